@@ -3,13 +3,16 @@
 #include "VulkanBookUtil.h"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include "imgui.h"
 #include "backends/imgui_impl_vulkan.h"
 #include "backends/imgui_impl_glfw.h"
 
 #include <array>
+#include <cmath>
 #include <random>
+#include <sstream>
 
 using namespace std;
 using namespace glm;
@@ -374,14 +377,17 @@ void DeferredRenderApp::Prepare()
     VK_SAMPLER_ADDRESS_MODE_REPEAT, 
     VK_SAMPLER_ADDRESS_MODE_REPEAT,
     0.0f, VK_FALSE, 1.0f, VK_FALSE,
-    VK_COMPARE_OP_NEVER, 0.0f, 0.0f,
+    VK_COMPARE_OP_NEVER, 0.0f, VK_LOD_CLAMP_NONE,
     VK_BORDER_COLOR_INT_OPAQUE_WHITE, VK_FALSE,
   };
   vkCreateSampler(m_device, &samplerCI, nullptr, &m_sampler);
+  samplerCI.maxLod = 0.0f;
+  vkCreateSampler(m_device, &samplerCI, nullptr, &m_samplerBaseLevel);
 
-  m_model = LoadModelData("assets/model/sponza/sponza.obj", true);
+  m_gpuTimer.Prepare(m_device, m_physicalDevice, imageCount);
 
-  PrepareModelResource(m_model);
+  LoadSceneModel();
+  LoadCharacterModel();
 
   m_camera.SetPerspective(
     radians(45.0f), float(extent.width) / float(extent.height), 1.0f, 5000.0f
@@ -393,7 +399,11 @@ void DeferredRenderApp::Prepare()
 
 void DeferredRenderApp::Cleanup()
 {
+  m_gpuTimer.Cleanup();
   m_model.Release(this);
+  vkFreeDescriptorSets(m_device, m_descriptorPool, uint32_t(m_characterSkinningSets.size()), m_characterSkinningSets.data());
+  m_characterSkinningSets.clear();
+  m_character.Release(this);
   DestroyImage(m_rtPosition);
   DestroyImage(m_rtNormal);
   DestroyImage(m_rtAlbedo);
@@ -408,6 +418,7 @@ void DeferredRenderApp::Cleanup()
   }
 
   vkDestroySampler(m_device, m_sampler, nullptr);
+  vkDestroySampler(m_device, m_samplerBaseLevel, nullptr);
 
   for (auto& v : m_pipelines)
   {
@@ -467,6 +478,16 @@ void DeferredRenderApp::Render()
   {
     MsgLoopMinimizedWindow();
   }
+  UpdateLayoutBenchmark();
+  if (m_requestedLayout != m_vertexLayout) {
+    ChangeVertexLayout(VertexLayout(m_requestedLayout));
+  }
+  UpdateMipmapBenchmark();
+  if (m_requestedMipmaps != m_useMipmaps) {
+    ChangeTextureMipmap(m_requestedMipmaps);
+  }
+  UpdateSkinningReuseBenchmark();
+
   uint32_t imageIndex = 0;
   auto result = m_swapchain->AcquireNextImage(&imageIndex, m_presentCompletedSem);
   if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -493,6 +514,7 @@ void DeferredRenderApp::Render()
     auto ubo = m_uniformBuffers[imageIndex];
     WriteToHostVisibleMemory(ubo.memory, sizeof(ShaderParameters), &m_sceneParameters);
   }
+  UpdateCharacter(imageIndex);
 
 
   auto command = m_commandBuffers[imageIndex].commandBuffer;
@@ -520,7 +542,8 @@ void DeferredRenderApp::Render()
   rpBI.pClearValues = clearVals;
   rpBI.clearValueCount = _countof(clearVals);
   vkBeginCommandBuffer(command, &commandBI);
-
+  m_gpuTimer.BeginFrame(command, imageIndex);
+  DispatchCharacterSkinning(command);
 
   vkCmdBeginRenderPass(command, &rpBI, VK_SUBPASS_CONTENTS_INLINE);
 
@@ -534,13 +557,24 @@ void DeferredRenderApp::Render()
   vkCmdSetViewport(command, 0, 1, &viewport);
 
   // Draw : Depth Prepass
+  auto timer = m_gpuTimer.Begin(command, DepthPrepassTimer);
   vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[DepthPrepassPipeline]);
   DrawModel(command);
+  m_gpuTimer.End(command, timer);
+  // ǉ̃r[̕XLjOʂ`悷.
+  timer = m_gpuTimer.Begin(command, CharacterDepthTimer);
+  DrawCharacter(command, SubpassDepthPrepass, 1 + uint32_t(m_characterExtraViews));
+  m_gpuTimer.End(command, timer);
 
   // Draw : GBuffer Pass
   vkCmdNextSubpass(command, VK_SUBPASS_CONTENTS_INLINE);
+  timer = m_gpuTimer.Begin(command, GBufferTimer);
   vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[DrawGBufferPipeline]);
   DrawModel(command);
+  m_gpuTimer.End(command, timer);
+  timer = m_gpuTimer.Begin(command, CharacterGBufferTimer);
+  DrawCharacter(command, SubpassGbuffer, 1);
+  m_gpuTimer.End(command, timer);
 
   // Draw : Deferred Lighiting Pass.
   vkCmdNextSubpass(command, VK_SUBPASS_CONTENTS_INLINE);
@@ -625,20 +659,15 @@ bool DeferredRenderApp::OnSizeChanged(uint32_t width, uint32_t height)
 
 void DeferredRenderApp::CreatePipeline()
 {
-  auto stride = uint32_t(sizeof(glm::vec3) * 2 + sizeof(glm::vec2));
-  std::vector<VkVertexInputBindingDescription> vibDescs{
-    // binding, stride, rate
-    { 0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX },
-    { 1, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX },
-    { 2, sizeof(glm::vec2), VK_VERTEX_INPUT_RATE_VERTEX },
-  };
+  // f̒_tH[}bgɍ킹Ē_͂.
+  std::vector<VkVertexInputBindingDescription> vibDescs;
+  std::vector<VkVertexInputAttributeDescription> inputAttribs;
+  m_model.GetVertexInputDescription(m_drawAttributes, vibDescs, inputAttribs);
 
-  std::vector<VkVertexInputAttributeDescription> inputAttribs{
-    // location, binding, format, offset
-    { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 },
-    { 1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0 },
-    { 2, 2, VK_FORMAT_R32G32_SFLOAT, 0 },
-  };
+  // _VF[_[̓WJ؂ւ.
+  VkBool32 compactVertexFormat = m_model.compactVertexFormat ? VK_TRUE : VK_FALSE;
+  VkSpecializationMapEntry specEntry{ 0, 0, sizeof(VkBool32) };
+  VkSpecializationInfo vsSpecInfo{ 1, &specEntry, sizeof(compactVertexFormat), &compactVertexFormat };
 
   VkPipelineVertexInputStateCreateInfo pipelineVisCI{
     VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
@@ -714,75 +743,103 @@ void DeferredRenderApp::CreatePipeline()
     VK_NULL_HANDLE, 0, // basePipeline
   };
 
-  // `ppCvC̍\z.
-  {
+  // DepthPrepass/GBuffer pX̕`ppCvC.
+  // LN^[pXɕ`̂ŁA_͂ƒ_VF[_[ACAEgւĎg.
+  // Depth Prepass ł̓J[݂̏͂Ȃ.
+  VkPipelineColorBlendAttachmentState colorBlendStateNoWriteColor = {
+      VK_FALSE,
+      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // color[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // alpha[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      0x0 };
+  VkPipelineColorBlendAttachmentState gbufferBlendState = {
+      VK_TRUE,
+      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // color[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // alpha[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      0xF };
+  VkPipelineColorBlendAttachmentState gbufferColors[3]{
+    gbufferBlendState, gbufferBlendState, gbufferBlendState,
+  };
+  auto createDrawPipeline = [&](uint32_t subpass, const char* vsFile, const std::string& layoutName,
+    const VkPipelineVertexInputStateCreateInfo* visCI, const VkSpecializationInfo* specInfo) {
+    bool depthPrepass = subpass == SubpassDepthPrepass;
     std::vector<VkPipelineShaderStageCreateInfo> shaderStages
     {
-      book_util::LoadShader(m_device,"assets/shader/depthPrepassVS.spv", VK_SHADER_STAGE_VERTEX_BIT),
-      book_util::LoadShader(m_device,"assets/shader/depthPrepassFS.spv", VK_SHADER_STAGE_FRAGMENT_BIT),
+      book_util::LoadShader(m_device, vsFile, VK_SHADER_STAGE_VERTEX_BIT),
+      book_util::LoadShader(m_device, depthPrepass ? "assets/shader/depthPrepassFS.spv" : "assets/shader/gbufferFS.spv", VK_SHADER_STAGE_FRAGMENT_BIT),
     };
+    shaderStages[0].pSpecializationInfo = specInfo;
     pipelineCI.pStages = shaderStages.data();
     pipelineCI.stageCount = uint32_t(shaderStages.size());
-    pipelineCI.layout = GetPipelineLayout("u2t2");
+    pipelineCI.pVertexInputState = visCI;
+    pipelineCI.layout = GetPipelineLayout(layoutName);
     pipelineCI.renderPass = GetRenderPass("deferred");
-    pipelineCI.subpass = SubpassDepthPrepass;
-
-    // Depth Prepass ł̓J[݂̏͂Ȃ.
-    VkPipelineColorBlendAttachmentState colorBlendStateNoWriteColor = {
-        VK_FALSE,
-        VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // color[Src/Dst] BlendFactor
-        VK_BLEND_OP_ADD,
-        VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // alpha[Src/Dst] BlendFactor
-        VK_BLEND_OP_ADD,
-        0x0 };
-    colorBlendStateCI.pAttachments = &colorBlendStateNoWriteColor;
-    colorBlendStateCI.attachmentCount = 1;
+    pipelineCI.subpass = subpass;
+
+    dsState = book_util::GetDefaultDepthStencilState();
+    if (depthPrepass) {
+      colorBlendStateCI.pAttachments = &colorBlendStateNoWriteColor;
+      colorBlendStateCI.attachmentCount = 1;
+    } else {
+      // GBuffer `pXł̓fvX݂̏͂ȂAfvXeXg͎g.
+      colorBlendStateCI.attachmentCount = _countof(gbufferColors);
+      colorBlendStateCI.pAttachments = gbufferColors;
+      dsState.depthTestEnable = true;
+      dsState.depthWriteEnable = false;
+      dsState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    }
+    pipelineCI.pDepthStencilState = &dsState;
 
     VkPipeline pipeline;
     result = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pipeline);
     ThrowIfFailed(result, "vkCreateGraphicsPipeline Failed. (shader)");
-    m_pipelines[DepthPrepassPipeline] = pipeline;
     book_util::DestroyShaderModules(m_device, shaderStages);
-  }
+    return pipeline;
+  };
+
+  // `ppCvC̍\z.
+  m_pipelines[DepthPrepassPipeline] = createDrawPipeline(
+    SubpassDepthPrepass, "assets/shader/depthPrepassVS.spv", "u2t2", &pipelineVisCI, &vsSpecInfo);
+  m_pipelines[DrawGBufferPipeline] = createDrawPipeline(
+    SubpassGbuffer, "assets/shader/gbufferVS.spv", "u2t2", &pipelineVisCI, &vsSpecInfo);
 
+  // LN^[p (OXLjO). XLjOς݂̒_͔񈳏k̈ʒu/@/UV Ȃ̂ŁAVF[_[WJŎg.
   {
-    // GBuffer `pXł̓fvX݂̏͂ȂAfvXeXg͎g.
-    // J[ݖ / fvX ON
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStages
-    {
-      book_util::LoadShader(m_device,"assets/shader/gbufferVS.spv", VK_SHADER_STAGE_VERTEX_BIT),
-      book_util::LoadShader(m_device,"assets/shader/gbufferFS.spv", VK_SHADER_STAGE_FRAGMENT_BIT),
-    };
-    pipelineCI.pStages = shaderStages.data();
-    pipelineCI.stageCount = uint32_t(shaderStages.size());
-    pipelineCI.layout = GetPipelineLayout("u2t2");
-    pipelineCI.renderPass = GetRenderPass("deferred");
-    pipelineCI.subpass = SubpassGbuffer;
-    VkPipelineColorBlendAttachmentState state = {
-        VK_TRUE,
-        VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // color[Src/Dst] BlendFactor
-        VK_BLEND_OP_ADD,
-        VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // alpha[Src/Dst] BlendFactor
-        VK_BLEND_OP_ADD,
-        0xF };
-    VkPipelineColorBlendAttachmentState colors[3]{
-      state, state, state,
+    std::vector<VkVertexInputBindingDescription> skinnedBindings;
+    std::vector<VkVertexInputAttributeDescription> skinnedAttribs;
+    ModelAsset::GetSkinnedVertexInputDescription(skinnedBindings, skinnedAttribs);
+    VkPipelineVertexInputStateCreateInfo skinnedVisCI{
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+      nullptr, 0,
+      uint32_t(skinnedBindings.size()), skinnedBindings.data(),
+      uint32_t(skinnedAttribs.size()), skinnedAttribs.data()
     };
-    colorBlendStateCI.attachmentCount = _countof(colors);
-    colorBlendStateCI.pAttachments = colors;
-    
-    dsState = book_util::GetDefaultDepthStencilState();
-    dsState.depthTestEnable = true;
-    dsState.depthWriteEnable = false;
-    dsState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-    pipelineCI.pDepthStencilState = &dsState;
-
-    VkPipeline pipeline;
-    result = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pipeline);
-    ThrowIfFailed(result, "vkCreateGraphicsPipeline Failed. (shader)");
-    m_pipelines[DrawGBufferPipeline] = pipeline;
+    VkBool32 uncompressed = VK_FALSE;
+    VkSpecializationInfo skinnedSpecInfo{ 1, &specEntry, sizeof(uncompressed), &uncompressed };
+    m_pipelines[CharacterDepthPrepassPipeline] = createDrawPipeline(
+      SubpassDepthPrepass, "assets/shader/depthPrepassVS.spv", "u2t2s2", &skinnedVisCI, &skinnedSpecInfo);
+    m_pipelines[CharacterGBufferPipeline] = createDrawPipeline(
+      SubpassGbuffer, "assets/shader/gbufferVS.spv", "u2t2s2", &skinnedVisCI, &skinnedSpecInfo);
+  }
 
-    book_util::DestroyShaderModules(m_device, shaderStages);
+  // LN^[p (pXƂ̃XLjO). {[̔ԍƏd݂_͂œǂ.
+  {
+    std::vector<VkVertexInputBindingDescription> skinBindings;
+    std::vector<VkVertexInputAttributeDescription> skinAttribs;
+    m_character.GetVertexInputDescription(m_characterSkinAttributes, skinBindings, skinAttribs);
+    VkPipelineVertexInputStateCreateInfo skinVisCI{
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+      nullptr, 0,
+      uint32_t(skinBindings.size()), skinBindings.data(),
+      uint32_t(skinAttribs.size()), skinAttribs.data()
+    };
+    m_pipelines[CharacterSkinDepthPrepassPipeline] = createDrawPipeline(
+      SubpassDepthPrepass, "assets/shader/depthPrepassSkinVS.spv", "u2t2s2", &skinVisCI, nullptr);
+    m_pipelines[CharacterSkinGBufferPipeline] = createDrawPipeline(
+      SubpassGbuffer, "assets/shader/gbufferSkinVS.spv", "u2t2s2", &skinVisCI, nullptr);
   }
 
   // CeBOppX
@@ -815,6 +872,23 @@ void DeferredRenderApp::CreatePipeline()
     book_util::DestroyShaderModules(m_device, shaderStages);
   }
 
+  // Rs[gVF[_[ŃXLjOpCvC̍\z.
+  {
+    auto stage = book_util::LoadShader(m_device, "assets/shader/skinningCS.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+    VkComputePipelineCreateInfo computeCI{
+      VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      nullptr, 0,
+      stage,
+      GetPipelineLayout("skinning"),
+      VK_NULL_HANDLE, 0,
+    };
+    VkPipeline pipeline;
+    result = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pipeline);
+    ThrowIfFailed(result, "vkCreateComputePipelines Failed. (skinning)");
+    vkDestroyShaderModule(m_device, stage.module, nullptr);
+    m_pipelines[ComputeSkinningPipeline] = pipeline;
+  }
+
 
   // DepthPrepass,Gbuffer pXp̃fBXNv^Zbg̏.
   for (int i = 0; i<int(m_swapchain->GetImageCount()); ++i) {
@@ -897,13 +971,14 @@ void DeferredRenderApp::PrepareModelResource(ModelAsset& model)
         drawBatch.modelMeshParameterUBO[j].buffer, 0, VK_WHOLE_SIZE,
       };
 
+      auto sampler = m_useMipmaps ? m_sampler : m_samplerBaseLevel;
       VkDescriptorImageInfo imageAlbedo{};
-      imageAlbedo.sampler = m_sampler;
+      imageAlbedo.sampler = sampler;
       imageAlbedo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
       imageAlbedo.imageView = material.albedo.view;
 
       VkDescriptorImageInfo imageSpecular{};
-      imageSpecular.sampler = m_sampler;
+      imageSpecular.sampler = sampler;
       imageSpecular.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
       imageSpecular.imageView = material.specular.view;
 
@@ -933,6 +1008,94 @@ void DeferredRenderApp::RenderHUD(VkCommandBuffer command)
   ImGui::InputFloat3("lightDir", (float*)&m_sceneParameters.lightDir);
  
   ImGui::InputInt("Mode", (int*)&m_sceneParameters.drawFlag);
+
+  const char* layoutNames[] = { "Separate (SoA)", "Interleaved", "Hot/Cold" };
+  if (!m_layoutBenchmark.running) {
+    ImGui::Combo("VertexLayout", &m_requestedLayout, layoutNames, _countof(layoutNames));
+  }
+  ImGui::Text("DepthPrepass: %.3f ms", m_gpuTimer.GetAverageMs(DepthPrepassTimer));
+  ImGui::Text("GBuffer     : %.3f ms", m_gpuTimer.GetAverageMs(GBufferTimer));
+  if (m_layoutBenchmark.running) {
+    ImGui::Text("Benchmark running... (%s)", layoutNames[m_layoutBenchmark.layout]);
+  } else if (ImGui::Button("Benchmark VertexLayout")) {
+    m_layoutBenchmark = LayoutBenchmark{};
+    m_layoutBenchmark.running = true;
+    m_layoutBenchmark.restoreLayout = m_vertexLayout;
+    m_requestedLayout = VertexLayout_Separate;
+  }
+  if (m_layoutBenchmark.hasResult) {
+    for (int i = 0; i < VertexLayout_Count; ++i) {
+      ImGui::Text("%-16s depth %.3f ms / gbuffer %.3f ms", layoutNames[i],
+        m_layoutBenchmark.depthPrepassMs[i], m_layoutBenchmark.gbufferMs[i]);
+    }
+  }
+  if (m_mipmapBenchmark.running) {
+    ImGui::Text("Benchmark running... (%s)", m_mipmapBenchmark.pass == 0 ? "base level" : "mipmap");
+  } else {
+    ImGui::Checkbox("Mipmap", &m_requestedMipmaps);
+    if (ImGui::Button("Benchmark Mipmap")) {
+      m_mipmapBenchmark = MipmapBenchmark{};
+      m_mipmapBenchmark.running = true;
+      m_mipmapBenchmark.restoreMipmaps = m_useMipmaps;
+      m_requestedMipmaps = false;
+    }
+  }
+  if (m_mipmapBenchmark.hasResult) {
+    ImGui::Text("GBuffer base level %.3f ms / mipmap %.3f ms",
+      m_mipmapBenchmark.gbufferMs[0], m_mipmapBenchmark.gbufferMs[1]);
+  }
+  const char* skinningModeNames[] = { "Pre-skinned (once)", "Per pass (VS)" };
+  if (m_skinningReuseBenchmark.running) {
+    ImGui::Text("Benchmark running... (%s)", skinningModeNames[m_skinningReuseBenchmark.mode]);
+  } else {
+    ImGui::Combo("CharacterSkinning", &m_characterSkinningMode, skinningModeNames, _countof(skinningModeNames));
+    ImGui::SliderInt("Extra views", &m_characterExtraViews, 0, MaxCharacterExtraViews);
+    if (ImGui::Button("Benchmark Skinning Reuse")) {
+      m_skinningReuseBenchmark = SkinningReuseBenchmark{};
+      m_skinningReuseBenchmark.running = true;
+      m_skinningReuseBenchmark.restoreMode = m_characterSkinningMode;
+      m_characterSkinningMode = CharacterSkinning_PreSkinned;
+    }
+  }
+  if (m_characterSkinningMode == CharacterSkinning_PreSkinned) {
+    ImGui::Text("Character: skinning %.3f ms / depth x%d %.3f ms / gbuffer %.3f ms",
+      m_gpuTimer.GetAverageMs(CharacterSkinningTimer), 1 + m_characterExtraViews,
+      m_gpuTimer.GetAverageMs(CharacterDepthTimer), m_gpuTimer.GetAverageMs(CharacterGBufferTimer));
+  } else {
+    ImGui::Text("Character: skinning in VS / depth x%d %.3f ms / gbuffer %.3f ms (both include skinning)",
+      1 + m_characterExtraViews,
+      m_gpuTimer.GetAverageMs(CharacterDepthTimer), m_gpuTimer.GetAverageMs(CharacterGBufferTimer));
+  }
+  if (m_skinningReuseBenchmark.hasResult) {
+    for (int i = 0; i < CharacterSkinning_Count; ++i) {
+      const auto& bench = m_skinningReuseBenchmark;
+      if (i == CharacterSkinning_PreSkinned) {
+        ImGui::Text("%-20s skin %.3f / depth %.3f / gbuffer %.3f ms", skinningModeNames[i],
+          bench.skinningMs[i], bench.depthMs[i], bench.gbufferMs[i]);
+      } else {
+        ImGui::Text("%-20s skin in VS / depth %.3f / gbuffer %.3f ms", skinningModeNames[i],
+          bench.depthMs[i], bench.gbufferMs[i]);
+      }
+    }
+  }
+  auto texStats = GetTextureCacheStats();
+  ImGui::Text("Texture: %u (unused %u, pending %u) %.1f / %.1f MB", texStats.textureCount,
+    texStats.unreferencedCount, texStats.pendingDestroyCount,
+    texStats.residentBytes / (1024.0 * 1024.0), texStats.budgetBytes / (1024.0 * 1024.0));
+  ImGui::Text("  hit %llu / miss %llu / evict %llu", texStats.hits, texStats.misses, texStats.evictions);
+  auto stagingStats = GetStagingStats();
+  ImGui::Text("Staging: %u slabs %.1f MB (create %llu, reuse %llu)", stagingStats.slabCount,
+    stagingStats.slabBytes / (1024.0 * 1024.0), stagingStats.slabCreates, stagingStats.slabReuses);
+  ImGui::Text("  decode in place %llu / fallback %llu, %.1f MB staged", stagingStats.decodeInPlace,
+    stagingStats.decodeFallback, stagingStats.bytesStaged / (1024.0 * 1024.0));
+  const char* memoryModes[] = { "discrete", "unified", "resizable BAR" };
+  auto uploadStats = GetUploadStats();
+  ImGui::Text("Upload (%s): direct %llu / %.1f MB, staging %llu / %.1f MB, image %llu / %.1f MB",
+    memoryModes[GetDeviceMemoryMode()],
+    uploadStats.directCount, uploadStats.directBytes / (1024.0 * 1024.0),
+    uploadStats.stagingCount, uploadStats.stagingBytes / (1024.0 * 1024.0),
+    uploadStats.imageCount, uploadStats.imageBytes / (1024.0 * 1024.0));
+  ImGui::Text("  chunked uploads %llu (%llu chunks), texture submits %llu", uploadStats.chunkedCount, uploadStats.chunkCount, uploadStats.imageSubmitCount);
   ImGui::End();
 
   ImGui::Render();
@@ -944,12 +1107,7 @@ void DeferredRenderApp::RenderHUD(VkCommandBuffer command)
 void DeferredRenderApp::DrawModel(VkCommandBuffer command)
 {
   auto imageIndex = m_swapchain->GetCurrentBufferIndex();
-  VkBuffer buffers[] = {
-    m_model.Position.buffer, m_model.Normal.buffer, m_model.UV0.buffer, m_model.Tangent.buffer
-  };
-  VkDeviceSize offsets[] = { 0,0,0,0 };
-  vkCmdBindVertexBuffers(command, 0, 4, buffers, offsets);
-  vkCmdBindIndexBuffer(command, m_model.Indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+  m_model.BindVertexBuffers(command, m_drawAttributes);
 
   for (auto& batch : m_model.DrawBatches) {
     const auto& material = m_model.materials[batch.materialIndex];
@@ -957,6 +1115,8 @@ void DeferredRenderApp::DrawModel(VkCommandBuffer command)
     meshParameters.mtxWorld = glm::mat4(1.0f);
     meshParameters.diffuse = vec4(material.diffuse, material.shininess);
     meshParameters.ambient = vec4(material.ambient, 0);
+    meshParameters.positionScale = batch.positionScale;
+    meshParameters.positionOffset = batch.positionOffset;
 
     WriteToHostVisibleMemory(
       batch.modelMeshParameterUBO[imageIndex].memory,
@@ -979,8 +1139,410 @@ void DeferredRenderApp::DrawModel(VkCommandBuffer command)
       uint32_t(descriptorSets.size()),
       descriptorSets.data(),
       0, nullptr);
-    vkCmdDrawIndexed(command, batch.indexCount, 1, batch.indexOffsetCount, batch.vertexOffsetCount, 0);
+    // RpNg`ł DrawBatch ƂɃCfbNX̌^قȂ.
+    vkCmdBindIndexBuffer(command, m_model.Indices.buffer, batch.indexBufferOffset, batch.indexType);
+    vkCmdDrawIndexed(command, batch.indexCount, 1, 0, batch.GetVertexOffset(), 0);
+  }
+}
+
+void DeferredRenderApp::LoadSceneModel()
+{
+  ModelLoadOptions loadOptions{};
+  loadOptions.useFlipUV = true;
+  loadOptions.compactVertexFormat = true;
+  loadOptions.vertexLayout = m_vertexLayout;
+  // Tangent ͂ǂ̃pXłgȂ̂œǂݍ܂Ȃ.
+  loadOptions.attributeMask = 0;
+  for (auto attr : m_drawAttributes) {
+    loadOptions.attributeMask |= VertexAttributeBit(attr);
+  }
+  m_model = LoadModelData("assets/model/sponza/sponza.obj", loadOptions);
+
+  PrepareModelResource(m_model);
+}
+
+void DeferredRenderApp::ChangeVertexLayout(VertexLayout layout)
+{
+  vkDeviceWaitIdle(m_device);
+
+  // fƂɈˑpCvC/fBXNv^Zbg蒼.
+  for (auto& batch : m_model.DrawBatches) {
+    vkFreeDescriptorSets(m_device, m_descriptorPool, uint32_t(batch.descriptorSets.size()), batch.descriptorSets.data());
+  }
+  m_model.Release(this);
+
+  vkFreeDescriptorSets(m_device, m_descriptorPool, uint32_t(m_dsGbuffer.size()), m_dsGbuffer.data());
+  vkFreeDescriptorSets(m_device, m_descriptorPool, uint32_t(m_dsDeferredLighting.size()), m_dsDeferredLighting.data());
+  m_dsGbuffer.clear();
+  m_dsDeferredLighting.clear();
+  for (auto& v : m_pipelines)
+  {
+    vkDestroyPipeline(m_device, v.second, nullptr);
+  }
+  m_pipelines.clear();
+
+  m_vertexLayout = layout;
+  m_requestedLayout = layout;
+  LoadSceneModel();
+  CreatePipeline();
+  m_gpuTimer.ResetAverage();
+}
+
+void DeferredRenderApp::UpdateLayoutBenchmark()
+{
+  // ؂ւ͑ÕCAEǧvlĉœǂݎ̂Ă.
+  const int WarmupFrames = 60;
+  const int MeasureFrames = 240;
+  auto& bench = m_layoutBenchmark;
+  if (!bench.running || m_vertexLayout != bench.layout) {
+    return;
+  }
+  bench.frame++;
+  if (bench.frame <= WarmupFrames) {
+    return;
+  }
+  bench.depthPrepassMs[bench.layout] += m_gpuTimer.GetLastMs(DepthPrepassTimer) / MeasureFrames;
+  bench.gbufferMs[bench.layout] += m_gpuTimer.GetLastMs(GBufferTimer) / MeasureFrames;
+  if (bench.frame < WarmupFrames + MeasureFrames) {
+    return;
+  }
+
+  bench.frame = 0;
+  bench.layout++;
+  if (bench.layout < VertexLayout_Count) {
+    m_requestedLayout = bench.layout;
+    return;
+  }
+  bench.running = false;
+  bench.hasResult = true;
+  bench.layout = 0;
+  m_requestedLayout = bench.restoreLayout;
+
+  const char* layoutNames[] = { "Separate", "Interleaved", "HotCold" };
+  std::stringstream ss;
+  ss << "[VertexLayout Benchmark] " << m_model.name << std::endl;
+  for (int i = 0; i < VertexLayout_Count; ++i) {
+    ss << "  " << layoutNames[i] << ": DepthPrepass " << bench.depthPrepassMs[i] << " ms, GBuffer " << bench.gbufferMs[i] << " ms" << std::endl;
+  }
+  OutputDebugStringA(ss.str().c_str());
+}
+
+void DeferredRenderApp::ChangeTextureMipmap(bool useMipmaps)
+{
+  vkDeviceWaitIdle(m_device);
+  m_useMipmaps = useMipmaps;
+  m_requestedMipmaps = useMipmaps;
+
+  // }eAeNX`̃Tv[ւ.
+  auto sampler = m_useMipmaps ? m_sampler : m_samplerBaseLevel;
+  for (auto& batch : m_model.DrawBatches) {
+    const auto& material = m_model.materials[batch.materialIndex];
+    for (auto descriptorSet : batch.descriptorSets) {
+      VkDescriptorImageInfo imageAlbedo{ sampler, material.albedo.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+      VkDescriptorImageInfo imageSpecular{ sampler, material.specular.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+      VkWriteDescriptorSet writes[] = {
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_MATERIAL_ALBEDO, &imageAlbedo),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_MATERIAL_SPECULAR, &imageSpecular),
+      };
+      vkUpdateDescriptorSets(m_device, _countof(writes), writes, 0, nullptr);
+    }
   }
+  m_gpuTimer.ResetAverage();
+}
+
+void DeferredRenderApp::UpdateMipmapBenchmark()
+{
+  const int WarmupFrames = 60;
+  const int MeasureFrames = 240;
+  auto& bench = m_mipmapBenchmark;
+  if (!bench.running || m_useMipmaps != (bench.pass == 1)) {
+    return;
+  }
+  bench.frame++;
+  if (bench.frame <= WarmupFrames) {
+    return;
+  }
+  bench.gbufferMs[bench.pass] += m_gpuTimer.GetLastMs(GBufferTimer) / MeasureFrames;
+  if (bench.frame < WarmupFrames + MeasureFrames) {
+    return;
+  }
+
+  bench.frame = 0;
+  bench.pass++;
+  if (bench.pass < 2) {
+    m_requestedMipmaps = true;
+    return;
+  }
+  bench.running = false;
+  bench.hasResult = true;
+  bench.pass = 0;
+  m_requestedMipmaps = bench.restoreMipmaps;
+
+  std::stringstream ss;
+  ss << "[Mipmap Benchmark] " << m_model.name << std::endl;
+  ss << "  base level: GBuffer " << bench.gbufferMs[0] << " ms" << std::endl;
+  ss << "  mipmap    : GBuffer " << bench.gbufferMs[1] << " ms" << std::endl;
+  OutputDebugStringA(ss.str().c_str());
+}
+
+void DeferredRenderApp::LoadCharacterModel()
+{
+  // Rs[gXLjO͈ʒu/@/UV  float ̔zƂēǂނ̂ŁA񈳏k Separate œǂݍ.
+  ModelLoadOptions loadOptions{};
+  loadOptions.compactVertexFormat = false;
+  loadOptions.vertexLayout = VertexLayout_Separate;
+  loadOptions.attributeMask = 0;
+  for (auto attr : m_characterSkinAttributes) {
+    loadOptions.attributeMask |= VertexAttributeBit(attr);
+  }
+  // LN^[f TransformFeedback Tv̂̂p.
+  m_character = LoadModelData("../TransformFeedback/assets/model/Alicia_solid.pmx", loadOptions);
+  CreateSkinnedVertexBuffer(m_character);
+
+  // Sponza ̒ɁAJ̕Ēu.
+  m_characterWorld = glm::translate(glm::mat4(1.0f), vec3(0.0f, 0.0f, -100.0f));
+  m_characterWorld = glm::rotate(m_characterWorld, glm::radians(-90.0f), vec3(0, 1, 0));
+  m_characterWorld = glm::scale(m_characterWorld, vec3(10.0f));
+
+  // Aj[VȂfȂ̂ŁAƘr葱ŗh炷.
+  const struct {
+    const char* name;
+    vec3 axis;
+    float amplitudeDegree;
+    float cycles;
+  } swings[] = {
+    { "", vec3(0, 1, 0), 30.0f, 0.5f },
+    { "㔼g", vec3(0, 0, 1), 8.0f, 0.5f },
+    { "Ђ", vec3(0, 1, 0), 30.0f, 1.0f },
+    { "EЂ", vec3(0, 1, 0), 30.0f, 1.0f },
+  };
+  m_characterSwings.clear();
+  for (const auto& swing : swings) {
+    auto node = m_character.FindNode(swing.name);
+    if (node == NodeHierarchy::InvalidIndex) {
+      continue;
+    }
+    m_characterSwings.push_back({ node, m_character.nodes.GetLocalMatrix(node), swing.axis, swing.amplitudeDegree, swing.cycles });
+  }
+
+  // DepthPrepass/GBuffer p. u2t2 Ƀ{[pbgƕϊ\𑫂CAEgg.
+  auto dsLayout = GetDescriptorSetLayout("u2t2s2");
+  m_character.pipelineLayout = GetPipelineLayout("u2t2s2");
+  auto imageCount = m_swapchain->GetImageCount();
+  for (auto& drawBatch : m_character.DrawBatches) {
+    const auto& material = m_character.materials[drawBatch.materialIndex];
+    drawBatch.descriptorSets.resize(imageCount);
+    for (uint32_t j = 0; j < imageCount; ++j) {
+      auto descriptorSet = AllocateDescriptorSet(dsLayout);
+      drawBatch.descriptorSets[j] = descriptorSet;
+
+      VkDescriptorBufferInfo sceneUniformUBO{ m_uniformBuffers[j].buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo modelUniformUBO{ drawBatch.modelMeshParameterUBO[j].buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo bonePalette{ m_character.boneMatrixPalette[j].buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo boneRemap{ m_character.BoneRemap.buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorImageInfo imageAlbedo{ m_sampler, material.albedo.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+      VkDescriptorImageInfo imageSpecular{ m_sampler, material.specular.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+      VkWriteDescriptorSet writes[] = {
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_SCENE_UNIFORM, &sceneUniformUBO),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_MODEL_UNIFORM, &modelUniformUBO),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_BONE_PALETTE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bonePalette),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_BONE_REMAP, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &boneRemap),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_MATERIAL_ALBEDO, &imageAlbedo),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_DRAW_MATERIAL_SPECULAR, &imageSpecular),
+      };
+      vkUpdateDescriptorSets(m_device, _countof(writes), writes, 0, nullptr);
+    }
+  }
+
+  // Rs[gXLjOp. pbgXbv`FCC[WƂɈقȂ.
+  auto skinningLayout = GetDescriptorSetLayout("skinning");
+  m_characterSkinningSets.resize(imageCount);
+  for (uint32_t j = 0; j < imageCount; ++j) {
+    auto descriptorSet = AllocateDescriptorSet(skinningLayout);
+    VkDescriptorBufferInfo positions{ m_character.Position.buffer, 0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo normals{ m_character.Normal.buffer, 0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo uv0s{ m_character.UV0.buffer, 0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo blendIndices{ m_character.BoneIndices.buffer, 0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo blendWeights{ m_character.BoneWeights.buffer, 0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo bonePalette{ m_character.boneMatrixPalette[j].buffer, 0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo skinned{ m_character.SkinnedVertices.buffer, 0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo boneRemap{ m_character.BoneRemap.buffer, 0, VK_WHOLE_SIZE };
+    VkWriteDescriptorSet writes[] = {
+      book_util::CreateWriteDescriptorSet(descriptorSet, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &positions),
+      book_util::CreateWriteDescriptorSet(descriptorSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &normals),
+      book_util::CreateWriteDescriptorSet(descriptorSet, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &uv0s),
+      book_util::CreateWriteDescriptorSet(descriptorSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &blendIndices),
+      book_util::CreateWriteDescriptorSet(descriptorSet, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &blendWeights),
+      book_util::CreateWriteDescriptorSet(descriptorSet, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bonePalette),
+      book_util::CreateWriteDescriptorSet(descriptorSet, 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &skinned),
+      book_util::CreateWriteDescriptorSet(descriptorSet, 7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &boneRemap),
+    };
+    vkUpdateDescriptorSets(m_device, _countof(writes), writes, 0, nullptr);
+    m_characterSkinningSets[j] = descriptorSet;
+  }
+}
+
+void DeferredRenderApp::UpdateCharacter(uint32_t imageIndex)
+{
+  m_characterTime += float(GetFrameDeltaTime());
+  for (const auto& swing : m_characterSwings) {
+    float degree = swing.amplitudeDegree * std::sin(2.0f * glm::pi<float>() * swing.cycles * m_characterTime);
+    m_character.nodes.SetLocalMatrix(swing.node, swing.bindLocal * glm::rotate(glm::mat4(1.0f), glm::radians(degree), swing.axis));
+  }
+  m_character.nodes.UpdateWorldMatrices();
+
+  // pbg͂ǂ̃[hł 1 t[ 1 񂾂. Ⴄ̂͂ǂŃXLjO.
+  UpdateBonePalette(m_character, imageIndex);
+
+  for (auto& batch : m_character.DrawBatches) {
+    const auto& material = m_character.materials[batch.materialIndex];
+    ModelMeshParameters meshParameters{};
+    meshParameters.mtxWorld = m_characterWorld;
+    meshParameters.diffuse = vec4(material.diffuse, material.shininess);
+    meshParameters.ambient = vec4(material.ambient, 0);
+    meshParameters.boneRemap.x = batch.boneRemapOffset;
+    meshParameters.boneRemap.y = SkinningMethod_Linear;
+    meshParameters.boneRemap.z = uint32_t(m_character.skeletonNodes.size());
+
+    WriteToHostVisibleMemory(
+      batch.modelMeshParameterUBO[imageIndex].memory,
+      sizeof(meshParameters),
+      &meshParameters);
+  }
+}
+
+void DeferredRenderApp::DispatchCharacterSkinning(VkCommandBuffer command)
+{
+  if (m_characterSkinningMode != CharacterSkinning_PreSkinned) {
+    // epX̒_VF[_[ŃXLjÔŁAł͉Ȃ.
+    // XLjO̎Ԃ̓fvX/GBuffer ̋ԂɊ܂܂̂ŁAXLjŐԂ͋L^Ȃ.
+    return;
+  }
+  auto imageIndex = m_swapchain->GetCurrentBufferIndex();
+
+  // Õt[̕`悪ǂݏIĂ珑.
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+  auto timer = m_gpuTimer.Begin(command, CharacterSkinningTimer);
+  auto layout = GetPipelineLayout("skinning");
+  vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[ComputeSkinningPipeline]);
+  vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_COMPUTE, layout,
+    0, 1, &m_characterSkinningSets[imageIndex], 0, nullptr);
+  for (const auto& batch : m_character.DrawBatches) {
+    if (batch.vertexCount == 0) {
+      continue;
+    }
+    // DrawBatch ̒_ʒu̓WIgv[Ao͂͂̃f̐擪.
+    SkinningPushConstants params{
+      book_util::CheckedUint32(batch.vertexOffsetCount),
+      uint32_t(m_character.GetSkinnedVertexOffset(batch)),
+      batch.vertexCount,
+      batch.boneRemapOffset,
+    };
+    vkCmdPushConstants(command, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+    vkCmdDispatch(command, (batch.vertexCount + 63) / 64, 1, 1);
+  }
+  m_gpuTimer.End(command, timer);
+
+  VkBufferMemoryBarrier barrier{
+    VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+    m_character.SkinnedVertices.buffer, 0, VK_WHOLE_SIZE,
+  };
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+    0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void DeferredRenderApp::DrawCharacter(VkCommandBuffer command, uint32_t subpass, uint32_t drawCount)
+{
+  auto imageIndex = m_swapchain->GetCurrentBufferIndex();
+  bool preSkinned = m_characterSkinningMode == CharacterSkinning_PreSkinned;
+  VkPipeline pipeline;
+  if (subpass == SubpassDepthPrepass) {
+    pipeline = m_pipelines[preSkinned ? CharacterDepthPrepassPipeline : CharacterSkinDepthPrepassPipeline];
+  } else {
+    pipeline = m_pipelines[preSkinned ? CharacterGBufferPipeline : CharacterSkinGBufferPipeline];
+  }
+  vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+  // OXLjOł̓XLjOς݂̒_AłȂΌ̒_ƃ{[̔ԍ/d݂ǂ.
+  if (preSkinned) {
+    m_character.BindSkinnedVertexBuffer(command);
+  } else {
+    m_character.BindVertexBuffers(command, m_characterSkinAttributes);
+  }
+
+  auto layout = GetPipelineLayout("u2t2s2");
+  for (uint32_t i = 0; i < drawCount; ++i) {
+    for (const auto& batch : m_character.DrawBatches) {
+      vkCmdBindDescriptorSets(command,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        layout,
+        0, 1, &batch.descriptorSets[imageIndex],
+        0, nullptr);
+      vkCmdBindIndexBuffer(command, m_character.Indices.buffer, batch.indexBufferOffset, batch.indexType);
+      // XLjOς݂̒_̓f̐擪ŕł.
+      int32_t vertexOffset = preSkinned ? m_character.GetSkinnedVertexOffset(batch) : batch.GetVertexOffset();
+      vkCmdDrawIndexed(command, batch.indexCount, 1, 0, vertexOffset, 0);
+    }
+  }
+}
+
+void DeferredRenderApp::UpdateSkinningReuseBenchmark()
+{
+  const int WarmupFrames = 60;
+  const int MeasureFrames = 240;
+  auto& bench = m_skinningReuseBenchmark;
+  if (!bench.running || m_characterSkinningMode != bench.mode) {
+    return;
+  }
+  bench.frame++;
+  if (bench.frame <= WarmupFrames) {
+    return;
+  }
+  // pXƂ̃XLjOɂ͓ƗԂȂ (fvX/GBuffer Ɋ܂܂) ̂ 0 ̂܂܂ɂ.
+  if (bench.mode == CharacterSkinning_PreSkinned) {
+    bench.skinningMs[bench.mode] += m_gpuTimer.GetLastMs(CharacterSkinningTimer) / MeasureFrames;
+  }
+  bench.depthMs[bench.mode] += m_gpuTimer.GetLastMs(CharacterDepthTimer) / MeasureFrames;
+  bench.gbufferMs[bench.mode] += m_gpuTimer.GetLastMs(CharacterGBufferTimer) / MeasureFrames;
+  if (bench.frame < WarmupFrames + MeasureFrames) {
+    return;
+  }
+
+  bench.frame = 0;
+  bench.mode++;
+  if (bench.mode < CharacterSkinning_Count) {
+    m_characterSkinningMode = bench.mode;
+    m_gpuTimer.ResetAverage();
+    return;
+  }
+  bench.running = false;
+  bench.hasResult = true;
+  bench.mode = 0;
+  m_characterSkinningMode = bench.restoreMode;
+  m_gpuTimer.ResetAverage();
+
+  const char* modeNames[] = { "PreSkinned", "PerPass   " };
+  std::stringstream ss;
+  ss << "[Skinning Reuse Benchmark] " << m_character.name
+    << " (" << m_character.totalVertexCount << " vertices, " << (2 + m_characterExtraViews) << " draws)" << std::endl;
+  for (int i = 0; i < CharacterSkinning_Count; ++i) {
+    ss << "  " << modeNames[i] << ": Skinning ";
+    if (i == CharacterSkinning_PreSkinned) {
+      ss << bench.skinningMs[i] << " ms";
+    } else {
+      ss << "(in VS)";
+    }
+    ss << ", DepthPrepass " << bench.depthMs[i]
+      << " ms, GBuffer " << bench.gbufferMs[i] << " ms, total "
+      << (bench.skinningMs[i] + bench.depthMs[i] + bench.gbufferMs[i]) << " ms" << std::endl;
+  }
+  OutputDebugStringA(ss.str().c_str());
 }
 
 void DeferredRenderApp::CreateSampleLayouts()
@@ -1017,6 +1579,38 @@ void DeferredRenderApp::CreateSampleLayouts()
   ThrowIfFailed(result, "vkCreateDescriptorSetLayout Failed (deferredLighting).");
   RegisterLayout("deferredLighting", dsLayout); dsLayout = VK_NULL_HANDLE;
 
+  // LN^[p. _VF[_[ŃXLjOƂ̓{[pbgƕϊ\ǂ.
+  dsLayoutBindings = {
+    { DS_DRAW_SCENE_UNIFORM, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, },
+    { DS_DRAW_MODEL_UNIFORM, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, },
+    { DS_DRAW_BONE_PALETTE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, },
+    { DS_DRAW_BONE_REMAP, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, },
+    { DS_DRAW_MATERIAL_ALBEDO, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_ALL, },
+    { DS_DRAW_MATERIAL_SPECULAR, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_ALL, },
+  };
+  dsLayoutCI.pBindings = dsLayoutBindings.data();
+  dsLayoutCI.bindingCount = uint32_t(dsLayoutBindings.size());
+  result = vkCreateDescriptorSetLayout(m_device, &dsLayoutCI, nullptr, &dsLayout);
+  ThrowIfFailed(result, "vkCreateDescriptorSetLayout Failed (u2t2s2).");
+  RegisterLayout("u2t2s2", dsLayout); dsLayout = VK_NULL_HANDLE;
+
+  // Rs[gXLjOp. ͂̒_Xg[Əo̓obt@ SSBO ƂĈ.
+  dsLayoutBindings = {
+    { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+  };
+  dsLayoutCI.pBindings = dsLayoutBindings.data();
+  dsLayoutCI.bindingCount = uint32_t(dsLayoutBindings.size());
+  result = vkCreateDescriptorSetLayout(m_device, &dsLayoutCI, nullptr, &dsLayout);
+  ThrowIfFailed(result, "vkCreateDescriptorSetLayout Failed (skinning).");
+  RegisterLayout("skinning", dsLayout); dsLayout = VK_NULL_HANDLE;
+
   // pCvCCAEg̏.
   VkPipelineLayoutCreateInfo layoutCI{
     VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0,
@@ -1036,5 +1630,24 @@ void DeferredRenderApp::CreateSampleLayouts()
   result = vkCreatePipelineLayout(m_device, &layoutCI, nullptr, &layout);
   ThrowIfFailed(result, "vkCreatePipelineLayout Failed(deferredLighting).");
   RegisterLayout("deferredLighting", layout); layout = VK_NULL_HANDLE;
+
+  dsLayout = GetDescriptorSetLayout("u2t2s2");
+  layoutCI.setLayoutCount = 1;
+  layoutCI.pSetLayouts = &dsLayout;
+  result = vkCreatePipelineLayout(m_device, &layoutCI, nullptr, &layout);
+  ThrowIfFailed(result, "vkCreatePipelineLayout Failed(u2t2s2).");
+  RegisterLayout("u2t2s2", layout); layout = VK_NULL_HANDLE;
+
+  VkPushConstantRange pushConstantRange{
+    VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SkinningPushConstants)
+  };
+  dsLayout = GetDescriptorSetLayout("skinning");
+  layoutCI.setLayoutCount = 1;
+  layoutCI.pSetLayouts = &dsLayout;
+  layoutCI.pushConstantRangeCount = 1;
+  layoutCI.pPushConstantRanges = &pushConstantRange;
+  result = vkCreatePipelineLayout(m_device, &layoutCI, nullptr, &layout);
+  ThrowIfFailed(result, "vkCreatePipelineLayout Failed(skinning).");
+  RegisterLayout("skinning", layout); layout = VK_NULL_HANDLE;
 }
 
@@ -2,6 +2,7 @@
 #include "VulkanAppBase.h"
 #include <glm/glm.hpp>
 #include "Camera.h"
+#include "GpuTimer.h"
 
 class DeferredRenderApp : public VulkanAppBase
 {
@@ -47,6 +48,21 @@ private:
 
   void DrawModel(VkCommandBuffer command);
 
+  void LoadSceneModel();
+  void ChangeVertexLayout(VertexLayout layout);
+  void UpdateLayoutBenchmark();
+  void ChangeTextureMipmap(bool useMipmaps);
+  void UpdateMipmapBenchmark();
+
+  // XLjOLN^[̓ǂݍ݂ƁAt[Ƃ̎p/pbg̍XV.
+  void LoadCharacterModel();
+  void UpdateCharacter(uint32_t imageIndex);
+  // OXLjÕ[hł́A_[pX̑OɃRs[g 1 񂾂XLjO.
+  void DispatchCharacterSkinning(VkCommandBuffer command);
+  // subpass (DepthPrepass/GBuffer) ɍ킹pCvC drawCount `悷.
+  void DrawCharacter(VkCommandBuffer command, uint32_t subpass, uint32_t drawCount);
+  void UpdateSkinningReuseBenchmark();
+
 private:
   ImageObject m_depthBuffer;
 
@@ -68,6 +84,12 @@ private:
   const std::string DepthPrepassPipeline = "DepthPrepass";
   const std::string DrawGBufferPipeline = "DrawGBuffer";
   const std::string LightingPassPipeline = "DeferredLightingPass";
+  // LN^[p. PreSkinned ̓XLjOς݂̒_ǂ݁ASkin ͒_VF[_[ŃXLjO.
+  const std::string CharacterDepthPrepassPipeline = "CharacterDepthPrepass";
+  const std::string CharacterGBufferPipeline = "CharacterGBuffer";
+  const std::string CharacterSkinDepthPrepassPipeline = "CharacterSkinDepthPrepass";
+  const std::string CharacterSkinGBufferPipeline = "CharacterSkinGBuffer";
+  const std::string ComputeSkinningPipeline = "ComputeSkinning";
 
   enum AttachmentIndex {
     AttachmentBackbuffer = 0,
@@ -91,6 +113,8 @@ private:
   enum DESCRIPTORSET_BINDINGS_DRAW {
     DS_DRAW_SCENE_UNIFORM = 0,
     DS_DRAW_MODEL_UNIFORM = 1,
+    DS_DRAW_BONE_PALETTE = 2,
+    DS_DRAW_BONE_REMAP = 3,
     DS_DRAW_MATERIAL_ALBEDO = 8,
     DS_DRAW_MATERIAL_SPECULAR = 9,
   };
@@ -102,7 +126,103 @@ private:
   };
 
   VkSampler m_sampler;
+  // x 0 ǂރTv[ (~bv}bvL̔rp).
+  VkSampler m_samplerBaseLevel;
+  bool m_useMipmaps = true;
+  bool m_requestedMipmaps = true;
   ModelAsset m_model;
+  // DepthPrepass/GBuffer pXœǂޒ_.
+  const std::vector<VertexAttribute> m_drawAttributes{
+    VertexAttribute_Position, VertexAttribute_Normal, VertexAttribute_UV0,
+  };
+  VertexLayout m_vertexLayout = VertexLayout_Separate;
+  int m_requestedLayout = VertexLayout_Separate;
+
+  GpuTimer m_gpuTimer;
+  const std::string DepthPrepassTimer = "DepthPrepass";
+  const std::string GBufferTimer = "GBuffer";
+  const std::string CharacterSkinningTimer = "CharacterSkinning";
+  const std::string CharacterDepthTimer = "CharacterDepth";
+  const std::string CharacterGBufferTimer = "CharacterGBuffer";
+
+  // LN^[̃XLjO@.
+  enum CharacterSkinningMode {
+    CharacterSkinning_PreSkinned = 0, // t[̍ŏ 1 񂾂XLjOAepX͂̌ʂ𒸓_obt@Ƃēǂ
+    CharacterSkinning_PerPass,        // `悷pXƂɒ_VF[_[ŃXLjO
+    CharacterSkinning_Count,
+  };
+  int m_characterSkinningMode = CharacterSkinning_PreSkinned;
+  // DepthPrepass ŃLN^[ǉŕ`悷. esbLOȂǁAbV`ʂ̃r[̑.
+  int m_characterExtraViews = 0;
+  const int MaxCharacterExtraViews = 8;
+
+  ModelAsset m_character;
+  // _VF[_[ŃXLjOƂɓǂޒ_. Skinning.glsl ̃P[Vƍ킹.
+  const std::vector<VertexAttribute> m_characterSkinAttributes{
+    VertexAttribute_Position, VertexAttribute_Normal, VertexAttribute_UV0,
+    VertexAttribute_BoneIndices, VertexAttribute_BoneWeights,
+  };
+  // oCh|[Y玲܂ sin gŗh炷m[h.
+  struct CharacterSwing
+  {
+    uint32_t node;
+    glm::mat4 bindLocal;
+    glm::vec3 axis;
+    float amplitudeDegree;
+    float cycles;   // 1 b̎
+  };
+  std::vector<CharacterSwing> m_characterSwings;
+  float m_characterTime = 0.0f;
+  glm::mat4 m_characterWorld = glm::mat4(1.0f);
+
+  // Rs[gXLjOp̃fBXNv^Zbg [Xbv`FCC[W].
+  std::vector<VkDescriptorSet> m_characterSkinningSets;
+  // skinningCS.comp  SkinningParameters Ɠzu.
+  struct SkinningPushConstants {
+    uint32_t srcVertexOffset;
+    uint32_t dstVertexOffset;
+    uint32_t vertexCount;
+    uint32_t boneRemapOffset;
+  };
+
+  // OXLjO (1 XLjO N `) ƃpXƂ̃XLjO̔r.
+  struct SkinningReuseBenchmark
+  {
+    bool running = false;
+    bool hasResult = false;
+    int mode = 0;
+    int frame = 0;
+    int restoreMode = CharacterSkinning_PreSkinned;
+    double skinningMs[CharacterSkinning_Count] = {};
+    double depthMs[CharacterSkinning_Count] = {};
+    double gbufferMs[CharacterSkinning_Count] = {};
+  };
+  SkinningReuseBenchmark m_skinningReuseBenchmark;
+
+  // _CAEgƂ DepthPrepass/GBuffer Ԃ̔r.
+  struct LayoutBenchmark
+  {
+    bool running = false;
+    bool hasResult = false;
+    int layout = 0;
+    int frame = 0;
+    VertexLayout restoreLayout = VertexLayout_Separate;
+    double depthPrepassMs[VertexLayout_Count] = {};
+    double gbufferMs[VertexLayout_Count] = {};
+  };
+  LayoutBenchmark m_layoutBenchmark;
+
+  // ~bv}bv/Lł GBuffer  (eNX`ǂݍݑш) ̔r.
+  struct MipmapBenchmark
+  {
+    bool running = false;
+    bool hasResult = false;
+    int pass = 0;   // 0: x 0 ̂, 1: ~bv}bv
+    int frame = 0;
+    bool restoreMipmaps = true;
+    double gbufferMs[2] = {};
+  };
+  MipmapBenchmark m_mipmapBenchmark;
 
   ImageObject m_rtPosition;
   ImageObject m_rtNormal;
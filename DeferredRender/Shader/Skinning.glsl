@@ -0,0 +1,23 @@
+// _VF[_[ł̃XLjO. pXƂɃXLjO` (OXLjOƂ̔rp) Ŏg.
+// pbg͍s (vec4 x 4) ̕тŁA{[ԍ boneRemap ŃbV̔ԍϊ.
+layout(location=3) in uvec4 inBlendIndices;
+layout(location=4) in vec4 inBlendWeights;
+
+layout(set=0,binding=2) readonly buffer BonePalette
+{
+  vec4 bonePalette[];
+};
+layout(set=0,binding=3) readonly buffer BoneRemap
+{
+  uint boneRemap[];
+};
+
+mat4 SkinMatrix(uint remapOffset)
+{
+  mat4 mtx = mat4(0);
+  for(int i=0;i<4;++i) {
+    uint b = boneRemap[remapOffset + inBlendIndices[i]] * 4;
+    mtx += mat4(bonePalette[b], bonePalette[b + 1], bonePalette[b + 2], bonePalette[b + 3]) * inBlendWeights[i];
+  }
+  return mtx;
+}
@@ -0,0 +1,22 @@
+// RpNg_tH[}bg̓WJ.
+// ModelAsset::compactVertexFormat ̂Ƃ@/ڐ͔ʑ̃GR[hĂ.
+layout(constant_id=0) const bool CompactVertexFormat = false;
+
+vec3 DecodeOctahedral(vec2 e)
+{
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+vec3 DecodeNormal(vec3 v)
+{
+  return CompactVertexFormat ? DecodeOctahedral(v.xy) : v;
+}
+
+vec4 DecodePosition(vec4 v, vec4 scale, vec4 offset)
+{
+  return vec4(v.xyz * scale.xyz + offset.xyz, 1.0);
+}
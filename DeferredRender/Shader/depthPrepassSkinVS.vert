@@ -0,0 +1,32 @@
+#version 450
+#extension GL_GOOGLE_include_directive : enable
+#include "SceneParameter.glsl"
+
+layout(location=0) in vec4 inPos;
+layout(location=1) in vec3 inNormal;
+layout(location=2) in vec2 inUV0;
+
+layout(location=0) out vec3 outNormalW;
+layout(location=1) out vec2 outUV0;
+
+layout(set=0,binding=1)
+uniform ModelMeshParamters
+{
+    mat4 world;
+    vec4 diffuse;
+    vec4 ambient;
+    vec4 positionScale;
+    vec4 positionOffset;
+    uvec4 boneRemapParams; // x: ̃bV boneRemap ̐擪
+};
+
+#include "Skinning.glsl"
+
+void main()
+{
+  mat4 skin = SkinMatrix(boneRemapParams.x);
+  vec4 worldPos = world * vec4((skin * inPos).xyz, 1);
+  gl_Position = proj * view * worldPos;
+  outNormalW = mat3(world) * normalize(mat3(skin) * inNormal);
+  outUV0 = inUV0;
+}
@@ -1,6 +1,7 @@
 #version 450
 #extension GL_GOOGLE_include_directive : enable
 #include "SceneParameter.glsl"
+#include "VertexDecode.glsl"
 
 layout(location=0) in vec4 inPos;
 layout(location=1) in vec3 inNormal;
@@ -14,14 +15,18 @@ layout(set=0,binding=1)
 uniform ModelMeshParamters
 {
     mat4 world;
+    vec4 diffuse;
+    vec4 ambient;
+    vec4 positionScale;
+    vec4 positionOffset;
 };
 
 void main()
 {
-  vec4 worldPos = world * inPos;
+  vec4 worldPos = world * DecodePosition(inPos, positionScale, positionOffset);
   gl_Position = proj * view * worldPos;
   mat3 m = mat3(world);
   outPositionW = worldPos;
-  outNormalW = m * inNormal;
+  outNormalW = m * DecodeNormal(inNormal);
   outUV0 = inUV0;
 }
@@ -188,7 +188,7 @@ void ManualMoviePlayer::SetMediaSource(const Path& fileName)
   m_appBase->DestroyCommandBuffer(command);
 
   // eNX`]pobt@(Xe[WOobt@).
-  auto totalBytes = uint32_t(m_width * m_height * sizeof(UINT32));
+  auto totalBytes = book_util::CheckedBufferSize(VkDeviceSize(m_width) * m_height, sizeof(UINT32));
   for (auto& buffer : m_frameDecoded) {
     buffer = m_appBase->CreateBuffer(totalBytes,
       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
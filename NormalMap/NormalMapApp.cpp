@@ -60,7 +60,7 @@ void NormalMapApp::Prepare()
     VK_SAMPLER_ADDRESS_MODE_REPEAT, 
     VK_SAMPLER_ADDRESS_MODE_REPEAT,
     0.0f, VK_FALSE, 1.0f, VK_FALSE,
-    VK_COMPARE_OP_NEVER, 0.0f, 0.0f,
+    VK_COMPARE_OP_NEVER, 0.0f, VK_LOD_CLAMP_NONE,
     VK_BORDER_COLOR_INT_OPAQUE_WHITE, VK_FALSE,
   };
   vkCreateSampler(m_device, &samplerCI, nullptr, &m_sampler);
@@ -75,7 +75,7 @@ void NormalMapApp::Prepare()
   m_model = LoadModelData("assets/model/plane.obj");
   PrepareModelResource(m_model);
 
-  m_model.rootNode->UpdateMatrices(glm::mat4(1.0f));
+  m_model.nodes.UpdateWorldMatrices();
   m_camera.SetPerspective(
     radians(45.0f), float(extent.width) / float(extent.height), 0.1f, 1000.0f
   );
@@ -211,7 +211,7 @@ void NormalMapApp::Render()
   vkCmdSetViewport(command, 0, 1, &viewport);
 
   
-  m_model.rootNode->UpdateMatrices(glm::mat4(1.0f));
+  m_model.nodes.UpdateWorldMatrices();
   DrawModel(command);
 
   RenderHUD(command);
@@ -514,7 +514,7 @@ void NormalMapApp::DrawModel(VkCommandBuffer command)
       uint32_t(descriptorSets.size()),
       descriptorSets.data(),
       0, nullptr);
-    vkCmdDrawIndexed(command, batch.indexCount, 1, batch.indexOffsetCount, batch.vertexOffsetCount, 0);
+    vkCmdDrawIndexed(command, batch.indexCount, 1, batch.GetFirstIndex(), batch.GetVertexOffset(), 0);
   }
 }
 
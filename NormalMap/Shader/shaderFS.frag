@@ -37,9 +37,11 @@ uniform sampler2D texHeightMap;
 
 vec3 FetchNormalMap(vec2 uv)
 {
-  vec3 normal = texture(texNormalMap, uv).xyz;
-  normal = normalize(normal * 2 - 1);
-  return normal;
+  // BC5 ɃNbN@}bv XY Ȃ̂ Z ͕.
+  // 񈳏k RGBA łň.
+  vec2 xy = texture(texNormalMap, uv).xy * 2 - 1;
+  float z = sqrt(max(0.0, 1.0 - dot(xy, xy)));
+  return normalize(vec3(xy, z));
 }
 float FetchHeightMap(vec2 uv)
 {
@@ -73,7 +73,7 @@ void SimpleVATApp::Prepare()
     VK_SAMPLER_ADDRESS_MODE_REPEAT, 
     VK_SAMPLER_ADDRESS_MODE_REPEAT,
     0.0f, VK_FALSE, 1.0f, VK_FALSE,
-    VK_COMPARE_OP_NEVER, 0.0f, 0.0f,
+    VK_COMPARE_OP_NEVER, 0.0f, VK_LOD_CLAMP_NONE,
     VK_BORDER_COLOR_INT_OPAQUE_WHITE, VK_FALSE,
   };
   vkCreateSampler(m_device, &samplerCI, nullptr, &m_sampler);
@@ -85,7 +85,7 @@ void SimpleVATApp::Prepare()
 
   PrepareModelResource(m_model);
 
-  m_model.rootNode->UpdateMatrices(glm::mat4(1.0f));
+  m_model.nodes.UpdateWorldMatrices();
 
   m_camera.SetPerspective(
     radians(45.0f), float(extent.width) / float(extent.height), 0.1f, 1000.0f
@@ -228,7 +228,7 @@ void SimpleVATApp::Render()
   vkCmdSetViewport(command, 0, 1, &viewport);
 
   // `.
-  m_model.rootNode->UpdateMatrices(glm::mat4(1.0f));
+  m_model.nodes.UpdateWorldMatrices();
   DrawModel(command);
 
   // VAT `.
@@ -581,15 +581,17 @@ void SimpleVATApp::DrawModel(VkCommandBuffer command)
       uint32_t(descriptorSets.size()),
       descriptorSets.data(),
       0, nullptr);
-    vkCmdDrawIndexed(command, batch.indexCount, 1, batch.indexOffsetCount, batch.vertexOffsetCount, 0);
+    vkCmdDrawIndexed(command, batch.indexCount, 1, batch.GetFirstIndex(), batch.GetVertexOffset(), 0);
   }
 }
 
 SimpleVATApp::VATData SimpleVATApp::LoadVAT(std::string path)
 {
   VATData vatData{};
-  vatData.texPosition = LoadTexture(path + ".ptex.ktx");
-  vatData.texNormal = LoadTexture(path + ".ntex.ktx");
+  // VAT ͒_VF[_[œǂ.
+  const VkPipelineStageFlags vatStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  vatData.texPosition = LoadTexture(path + ".ptex.ktx", vatStages);
+  vatData.texNormal = LoadTexture(path + ".ntex.ktx", vatStages);
 
   vatData.vertexCount = vatData.texPosition.width;
   vatData.animationCount = vatData.texPosition.height;
@@ -0,0 +1,482 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace block_compression
+{
+  namespace
+  {
+    // 听ׂ̎@ŋ߂. ߂l͕.
+    template<int N>
+    void ComputePrincipalAxis(const float (&texels)[16][N], float (&mean)[N], float (&axis)[N])
+    {
+      for (int c = 0; c < N; ++c) {
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+          mean[c] += texels[i][c];
+        }
+        mean[c] /= 16.0f;
+      }
+      float cov[N][N] = {};
+      for (int i = 0; i < 16; ++i) {
+        for (int a = 0; a < N; ++a) {
+          for (int b = 0; b < N; ++b) {
+            cov[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+          }
+        }
+      }
+      for (int c = 0; c < N; ++c) {
+        axis[c] = 1.0f;
+      }
+      for (int iter = 0; iter < 8; ++iter) {
+        float next[N] = {};
+        float length = 0.0f;
+        for (int a = 0; a < N; ++a) {
+          for (int b = 0; b < N; ++b) {
+            next[a] += cov[a][b] * axis[b];
+          }
+          length += next[a] * next[a];
+        }
+        if (length < 1e-8f) {
+          break;
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < N; ++c) {
+          axis[c] = next[c] / length;
+        }
+      }
+    }
+
+    // ɓe[[_Ƃ. ʎq덷ŏɊ񂹂.
+    template<int N>
+    void ComputeEndpoints(const float (&texels)[16][N], float (&e0)[N], float (&e1)[N])
+    {
+      float mean[N], axis[N];
+      ComputePrincipalAxis(texels, mean, axis);
+      float minT = 0.0f, maxT = 0.0f;
+      for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < N; ++c) {
+          t += (texels[i][c] - mean[c]) * axis[c];
+        }
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+      }
+      float inset = (maxT - minT) / 32.0f;
+      minT += inset;
+      maxT -= inset;
+      for (int c = 0; c < N; ++c) {
+        e0[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+        e1[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+      }
+    }
+
+    // CfbNXŒ肵Ē[_ŏŋߒ.
+    // weights[i] ̓eNZ i  e1 ̏d (0 ` 1).
+    template<int N>
+    bool RefineEndpoints(const float (&texels)[16][N], const float* weights, float (&e0)[N], float (&e1)[N])
+    {
+      float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+      float ax[N] = {}, bx[N] = {};
+      for (int i = 0; i < 16; ++i) {
+        float b = weights[i], a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < N; ++c) {
+          ax[c] += a * texels[i][c];
+          bx[c] += b * texels[i][c];
+        }
+      }
+      float det = aa * bb - ab * ab;
+      if (std::abs(det) < 1e-6f) {
+        return false;
+      }
+      for (int c = 0; c < N; ++c) {
+        e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / det, 0.0f), 255.0f);
+        e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / det, 0.0f), 255.0f);
+      }
+      return true;
+    }
+
+    uint16_t To565(const float* c)
+    {
+      auto r = uint16_t(std::lround(c[0] * 31.0f / 255.0f));
+      auto g = uint16_t(std::lround(c[1] * 63.0f / 255.0f));
+      auto b = uint16_t(std::lround(c[2] * 31.0f / 255.0f));
+      return uint16_t((r << 11) | (g << 5) | b);
+    }
+    void From565(uint16_t v, int* c)
+    {
+      int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+      c[0] = (r << 3) | (r >> 2);
+      c[1] = (g << 2) | (g >> 4);
+      c[2] = (b << 3) | (b >> 2);
+    }
+
+    // 4 F[h BC1 J[ubNA덷Ԃ.
+    float EncodeColorBlock(const float (&texels)[16][3], const float (&e0)[3], const float (&e1)[3], uint8_t* block)
+    {
+      uint16_t c0 = To565(e0), c1 = To565(e1);
+      if (c0 < c1) {
+        std::swap(c0, c1);
+      }
+      uint32_t indices = 0;
+      float error = 0.0f;
+      if (c0 != c1) {
+        int p[4][3];
+        From565(c0, p[0]);
+        From565(c1, p[1]);
+        for (int c = 0; c < 3; ++c) {
+          p[2][c] = (2 * p[0][c] + p[1][c]) / 3;
+          p[3][c] = (p[0][c] + 2 * p[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+          int best = 0;
+          float bestError = 1e30f;
+          for (int j = 0; j < 4; ++j) {
+            float e = 0.0f;
+            for (int c = 0; c < 3; ++c) {
+              float d = texels[i][c] - p[j][c];
+              e += d * d;
+            }
+            if (e < bestError) {
+              bestError = e;
+              best = j;
+            }
+          }
+          indices |= uint32_t(best) << (i * 2);
+          error += bestError;
+        }
+      } else {
+        // 1 F. 3 F[hɂȂ̂őSeNZ c0 w悤ɂ.
+        int p[3];
+        From565(c0, p);
+        for (int i = 0; i < 16; ++i) {
+          for (int c = 0; c < 3; ++c) {
+            float d = texels[i][c] - p[c];
+            error += d * d;
+          }
+        }
+      }
+      memcpy(block + 0, &c0, 2);
+      memcpy(block + 2, &c1, 2);
+      memcpy(block + 4, &indices, 4);
+      return error;
+    }
+
+    void EncodeColor(const uint8_t* rgba, uint8_t* block)
+    {
+      float texels[16][3];
+      for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+          texels[i][c] = float(rgba[i * 4 + c]);
+        }
+      }
+      float e0[3], e1[3];
+      ComputeEndpoints(texels, e0, e1);
+      float error = EncodeColorBlock(texels, e0, e1, block);
+
+      // I΂ꂽCfbNX[_ߒAǂȂ̗p.
+      uint16_t c0, c1;
+      uint32_t indices;
+      memcpy(&c0, block + 0, 2);
+      memcpy(&c1, block + 2, 2);
+      memcpy(&indices, block + 4, 4);
+      if (c0 == c1) {
+        return;
+      }
+      const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+      float weights[16];
+      for (int i = 0; i < 16; ++i) {
+        weights[i] = indexWeights[(indices >> (i * 2)) & 3];
+      }
+      if (RefineEndpoints(texels, weights, e0, e1)) {
+        uint8_t refined[8];
+        if (EncodeColorBlock(texels, e0, e1, refined) < error) {
+          memcpy(block, refined, 8);
+        }
+      }
+    }
+
+    // 128bit ̃rbgʂ珑.
+    struct BitWriter
+    {
+      uint8_t* block;
+      uint32_t position = 0;
+      void Write(uint32_t value, uint32_t bits)
+      {
+        for (uint32_t i = 0; i < bits; ++i, ++position) {
+          if (value & (1u << i)) {
+            block[position >> 3] |= uint8_t(1u << (position & 7));
+          }
+        }
+      }
+    };
+    struct BitReader
+    {
+      const uint8_t* block;
+      uint32_t position = 0;
+      uint32_t Read(uint32_t bits)
+      {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; ++i, ++position) {
+          value |= uint32_t((block[position >> 3] >> (position & 7)) & 1) << i;
+        }
+        return value;
+      }
+    };
+
+    const int BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // [_ 7bit + p rbgɗʎq. p rbg RGBA ŋ.
+    void QuantizeBC7Endpoint(const float (&e)[4], int (&q)[4], int& p)
+    {
+      float bestError = 1e30f;
+      for (int pbit = 0; pbit < 2; ++pbit) {
+        int candidate[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+          candidate[c] = std::min(std::max(int(std::lround((e[c] - pbit) / 2.0f)), 0), 127);
+          float d = float((candidate[c] << 1) | pbit) - e[c];
+          error += d * d;
+        }
+        if (error < bestError) {
+          bestError = error;
+          p = pbit;
+          memcpy(q, candidate, sizeof(q));
+        }
+      }
+    }
+
+    float EncodeBC7Mode6(const float (&texels)[16][4], const float (&e0)[4], const float (&e1)[4], uint8_t* block, int* outIndices)
+    {
+      int q0[4], q1[4], p0 = 0, p1 = 0;
+      QuantizeBC7Endpoint(e0, q0, p0);
+      QuantizeBC7Endpoint(e1, q1, p1);
+      int a[4], b[4];
+      for (int c = 0; c < 4; ++c) {
+        a[c] = (q0[c] << 1) | p0;
+        b[c] = (q1[c] << 1) | p1;
+      }
+      int indices[16];
+      float error = 0.0f;
+      for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        float bestError = 1e30f;
+        for (int j = 0; j < 16; ++j) {
+          float e = 0.0f;
+          for (int c = 0; c < 4; ++c) {
+            int v = ((64 - BC7Weights4[j]) * a[c] + BC7Weights4[j] * b[c] + 32) >> 6;
+            float d = texels[i][c] - float(v);
+            e += d * d;
+          }
+          if (e < bestError) {
+            bestError = e;
+            best = j;
+          }
+        }
+        indices[i] = best;
+        error += bestError;
+      }
+      // 擪eNZ̃CfbNX̍ŏʃrbg͈Öق 0. ĂΒ[_ւ.
+      if (indices[0] & 8) {
+        std::swap(q0, q1);
+        std::swap(p0, p1);
+        for (auto& index : indices) {
+          index = 15 - index;
+        }
+      }
+
+      memset(block, 0, 16);
+      BitWriter writer{ block };
+      writer.Write(1 << 6, 7);  // mode 6
+      for (int c = 0; c < 4; ++c) {
+        writer.Write(uint32_t(q0[c]), 7);
+        writer.Write(uint32_t(q1[c]), 7);
+      }
+      writer.Write(uint32_t(p0), 1);
+      writer.Write(uint32_t(p1), 1);
+      for (int i = 0; i < 16; ++i) {
+        writer.Write(uint32_t(indices[i]), i == 0 ? 3 : 4);
+      }
+      if (outIndices) {
+        memcpy(outIndices, indices, sizeof(indices));
+      }
+      return error;
+    }
+  }
+
+  void EncodeBC1(const uint8_t* rgba, uint8_t* block)
+  {
+    EncodeColor(rgba, block);
+  }
+
+  void EncodeBC3(const uint8_t* rgba, uint8_t* block)
+  {
+    EncodeBC4(rgba, 3, block);
+    EncodeColor(rgba, block + 8);
+  }
+
+  void EncodeBC4(const uint8_t* rgba, int channel, uint8_t* block)
+  {
+    int minValue = 255, maxValue = 0;
+    for (int i = 0; i < 16; ++i) {
+      int v = rgba[i * 4 + channel];
+      minValue = std::min(minValue, v);
+      maxValue = std::max(maxValue, v);
+    }
+    memset(block, 0, 8);
+    block[0] = uint8_t(maxValue);
+    block[1] = uint8_t(minValue);
+    if (maxValue == minValue) {
+      return;
+    }
+    // r0 > r1  8 iK[h.
+    int palette[8] = { maxValue, minValue };
+    for (int j = 2; j < 8; ++j) {
+      palette[j] = ((8 - j) * maxValue + (j - 1) * minValue) / 7;
+    }
+    uint64_t indices = 0;
+    for (int i = 0; i < 16; ++i) {
+      int v = rgba[i * 4 + channel];
+      int best = 0, bestError = 256;
+      for (int j = 0; j < 8; ++j) {
+        int e = std::abs(v - palette[j]);
+        if (e < bestError) {
+          bestError = e;
+          best = j;
+        }
+      }
+      indices |= uint64_t(best) << (i * 3);
+    }
+    for (int b = 0; b < 6; ++b) {
+      block[2 + b] = uint8_t(indices >> (b * 8));
+    }
+  }
+
+  void EncodeBC5(const uint8_t* rgba, uint8_t* block)
+  {
+    EncodeBC4(rgba, 0, block);
+    EncodeBC4(rgba, 1, block + 8);
+  }
+
+  void EncodeBC7(const uint8_t* rgba, uint8_t* block)
+  {
+    float texels[16][4];
+    for (int i = 0; i < 16; ++i) {
+      for (int c = 0; c < 4; ++c) {
+        texels[i][c] = float(rgba[i * 4 + c]);
+      }
+    }
+    float e0[4], e1[4];
+    ComputeEndpoints(texels, e0, e1);
+    int indices[16];
+    float error = EncodeBC7Mode6(texels, e0, e1, block, indices);
+
+    // CfbNXւĂĂ[_Ƃ̑Ή͕Ȃ悤ɁA[_ŏd݂߂.
+    BitReader reader{ block };
+    reader.Read(7);
+    int q[2][4];
+    for (int c = 0; c < 4; ++c) {
+      q[0][c] = int(reader.Read(7));
+      q[1][c] = int(reader.Read(7));
+    }
+    int p0 = int(reader.Read(1)), p1 = int(reader.Read(1));
+    float weights[16];
+    for (int i = 0; i < 16; ++i) {
+      weights[i] = BC7Weights4[indices[i]] / 64.0f;
+    }
+    float r0[4], r1[4];
+    for (int c = 0; c < 4; ++c) {
+      r0[c] = float((q[0][c] << 1) | p0);
+      r1[c] = float((q[1][c] << 1) | p1);
+    }
+    if (RefineEndpoints(texels, weights, r0, r1)) {
+      uint8_t refined[16];
+      if (EncodeBC7Mode6(texels, r0, r1, refined, nullptr) < error) {
+        memcpy(block, refined, 16);
+      }
+    }
+  }
+
+  void DecodeBC1(const uint8_t* block, uint8_t* rgba)
+  {
+    uint16_t c0, c1;
+    uint32_t indices;
+    memcpy(&c0, block + 0, 2);
+    memcpy(&c1, block + 2, 2);
+    memcpy(&indices, block + 4, 4);
+    int p[4][4];
+    From565(c0, p[0]);
+    From565(c1, p[1]);
+    p[0][3] = p[1][3] = 255;
+    for (int c = 0; c < 3; ++c) {
+      if (c0 > c1) {
+        p[2][c] = (2 * p[0][c] + p[1][c]) / 3;
+        p[3][c] = (p[0][c] + 2 * p[1][c]) / 3;
+      } else {
+        p[2][c] = (p[0][c] + p[1][c]) / 2;
+        p[3][c] = 0;
+      }
+    }
+    p[2][3] = 255;
+    p[3][3] = (c0 > c1) ? 255 : 0;
+    for (int i = 0; i < 16; ++i) {
+      auto index = (indices >> (i * 2)) & 3;
+      for (int c = 0; c < 4; ++c) {
+        rgba[i * 4 + c] = uint8_t(p[index][c]);
+      }
+    }
+  }
+
+  void DecodeBC4(const uint8_t* block, int channel, uint8_t* rgba)
+  {
+    int r0 = block[0], r1 = block[1];
+    int palette[8] = { r0, r1 };
+    if (r0 > r1) {
+      for (int j = 2; j < 8; ++j) {
+        palette[j] = ((8 - j) * r0 + (j - 1) * r1) / 7;
+      }
+    } else {
+      for (int j = 2; j < 6; ++j) {
+        palette[j] = ((6 - j) * r0 + (j - 1) * r1) / 5;
+      }
+      palette[6] = 0;
+      palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (int b = 0; b < 6; ++b) {
+      indices |= uint64_t(block[2 + b]) << (b * 8);
+    }
+    for (int i = 0; i < 16; ++i) {
+      rgba[i * 4 + channel] = uint8_t(palette[(indices >> (i * 3)) & 7]);
+    }
+  }
+
+  void DecodeBC7Mode6(const uint8_t* block, uint8_t* rgba)
+  {
+    BitReader reader{ block };
+    if (reader.Read(7) != (1 << 6)) {
+      memset(rgba, 0, 64);
+      return;
+    }
+    int e[2][4];
+    for (int c = 0; c < 4; ++c) {
+      e[0][c] = int(reader.Read(7)) << 1;
+      e[1][c] = int(reader.Read(7)) << 1;
+    }
+    int p0 = int(reader.Read(1)), p1 = int(reader.Read(1));
+    for (int c = 0; c < 4; ++c) {
+      e[0][c] |= p0;
+      e[1][c] |= p1;
+    }
+    for (int i = 0; i < 16; ++i) {
+      int index = int(reader.Read(i == 0 ? 3 : 4));
+      for (int c = 0; c < 4; ++c) {
+        rgba[i * 4 + c] = uint8_t(((64 - BC7Weights4[index]) * e[0][c] + BC7Weights4[index] * e[1][c] + 32) >> 6);
+      }
+    }
+  }
+}
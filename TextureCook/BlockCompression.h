@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+// 4x4 eNZ̃ubNkGR[_[ (CPU).
+// ͂ RGBA8  16 eNZ (sD). o͂͊etH[}bg̃ubN 1 .
+namespace block_compression
+{
+  // BC1: RGB 565  2 F + 2bit CfbNX (8 oCg). 4 F[ĥ݂ŃAt@͎Ȃ.
+  void EncodeBC1(const uint8_t* rgba, uint8_t* block);
+
+  // BC3: BC4 ̃At@ + BC1 ̃J[ (16 oCg).
+  void EncodeBC3(const uint8_t* rgba, uint8_t* block);
+
+  // BC4: 1 `l (channel Ŏw)  2 l + 3bit CfbNX (8 oCg).
+  void EncodeBC4(const uint8_t* rgba, int channel, uint8_t* block);
+
+  // BC5: R/G  2 `l BC4  2  (16 oCg). @}bv XY p.
+  void EncodeBC5(const uint8_t* rgba, uint8_t* block);
+
+  // BC7: [h 6 (1 TuZbg, RGBA 7bit + p rbg, 4bit CfbNX) ݂̂g (16 oCg).
+  void EncodeBC7(const uint8_t* rgba, uint8_t* block);
+
+  // mFp̃fR[_[.
+  void DecodeBC1(const uint8_t* block, uint8_t* rgba);
+  void DecodeBC4(const uint8_t* block, int channel, uint8_t* rgba);
+  void DecodeBC7Mode6(const uint8_t* block, uint8_t* rgba);
+}
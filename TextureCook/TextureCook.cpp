@@ -0,0 +1,521 @@
+// eNX`̃NbN (ItCϊ) c[.
+// PNG/JPG/TGA ǂݍ݁A~bv𐶐 BC1/BC3/BC4/BC5/BC7  KTX2 ɏo.
+// GPU  Vulkan SDK gȂ̂ŁArh Linux ł.
+//
+//   TextureCook [options] <input file or directory>...
+//     --format auto|bc1|bc3|bc4|bc5|bc7  o̓tH[}bg ( auto)
+//     --normal                           @}bvƂĈ (BC5, ~bvƂɍĐK)
+//     --srgb                             sRGB tH[}bgŏo (BC1/BC3/BC7)
+//     --no-mips                          ~bv𐶐Ȃ
+//     --force                            o͂VĂϊ
+//     -o <file>                          o̓t@C (͂ 1 t@ĈƂ)
+//
+// o͂͊œ͂ƓꏊɊgq .ktx2 Œu.
+// VulkanAppBase::LoadTexture ͓ .ktx2 ΂D悵ēǂݍ.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  enum CookFormat {
+    CookFormat_Auto = 0,
+    CookFormat_BC1,
+    CookFormat_BC3,
+    CookFormat_BC4,
+    CookFormat_BC5,
+    CookFormat_BC7,
+  };
+
+  struct CookOptions
+  {
+    CookFormat format = CookFormat_Auto;
+    bool normalMap = false;
+    bool srgb = false;
+    bool generateMips = true;
+    bool force = false;
+    fs::path output;
+  };
+
+  // c[ Vulkan wb_[ɈˑȂ̂ VkFormat ̒l𒼐ڎ.
+  const uint32_t VkFormat_BC1_RGB_UNORM = 131;
+  const uint32_t VkFormat_BC3_UNORM = 137;
+  const uint32_t VkFormat_BC4_UNORM = 139;
+  const uint32_t VkFormat_BC5_UNORM = 141;
+  const uint32_t VkFormat_BC7_UNORM = 145;
+  // e UNORM ̎̒l SRGB.
+
+  // Khronos Data Format ̒l (KTX2  DFD p).
+  const uint32_t KHR_DF_MODEL_BC1A = 128;
+  const uint32_t KHR_DF_MODEL_BC3 = 130;
+  const uint32_t KHR_DF_MODEL_BC4 = 131;
+  const uint32_t KHR_DF_MODEL_BC5 = 132;
+  const uint32_t KHR_DF_MODEL_BC7 = 134;
+  const uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+  const uint32_t KHR_DF_TRANSFER_SRGB = 2;
+  const uint32_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+
+  struct Image
+  {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> rgba;
+  };
+
+  const char* GetFormatName(CookFormat format)
+  {
+    switch (format) {
+    case CookFormat_BC1: return "BC1";
+    case CookFormat_BC3: return "BC3";
+    case CookFormat_BC4: return "BC4";
+    case CookFormat_BC5: return "BC5";
+    case CookFormat_BC7: return "BC7";
+    default: return "auto";
+    }
+  }
+  uint32_t GetBlockBytes(CookFormat format)
+  {
+    return (format == CookFormat_BC1 || format == CookFormat_BC4) ? 8 : 16;
+  }
+
+  bool IsSourceImage(const fs::path& path)
+  {
+    auto ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return char(tolower(c)); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".tga";
+  }
+
+  bool ContainsNoCase(std::string text, std::string pattern)
+  {
+    auto lower = [](std::string& s) { std::transform(s.begin(), s.end(), s.begin(), [](char c) { return char(tolower(c)); }); };
+    lower(text);
+    lower(pattern);
+    return text.find(pattern) != std::string::npos;
+  }
+
+  bool HasAlpha(const Image& image)
+  {
+    for (size_t i = 3; i < image.rgba.size(); i += 4) {
+      if (image.rgba[i] != 255) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool IsGrayscale(const Image& image)
+  {
+    for (size_t i = 0; i < image.rgba.size(); i += 4) {
+      if (image.rgba[i] != image.rgba[i + 1] || image.rgba[i] != image.rgba[i + 2]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // ^WFgԂ̖@}bv炵. قڑSeNZ 1 O +Z ĂΖ@Ƃ݂Ȃ.
+  bool LooksLikeNormalMap(const Image& image)
+  {
+    size_t count = 0, total = image.rgba.size() / 4;
+    for (size_t i = 0; i < image.rgba.size(); i += 4) {
+      float n[3];
+      for (int c = 0; c < 3; ++c) {
+        n[c] = image.rgba[i + c] / 127.5f - 1.0f;
+      }
+      float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      if (length > 0.85f && length < 1.15f && n[2] > 0.0f) {
+        ++count;
+      }
+    }
+    return total > 0 && count >= total * 95 / 100;
+  }
+
+  // t@CƓeo̓tH[}bg߂.
+  CookFormat ChooseFormat(const fs::path& path, const Image& image, CookOptions& options)
+  {
+    if (!options.normalMap && options.format == CookFormat_Auto) {
+      auto stem = path.stem().string();
+      bool namedNormal = ContainsNoCase(stem, "normal") || ContainsNoCase(stem, "_nm") || ContainsNoCase(stem, "_ddn");
+      options.normalMap = namedNormal && !IsGrayscale(image) && LooksLikeNormalMap(image);
+    }
+    if (options.format != CookFormat_Auto) {
+      return options.format;
+    }
+    if (options.normalMap) {
+      return CookFormat_BC5;
+    }
+    // BC4  G/B  0 ɂȂ̂ŁAR ǂނƕĂ鍂}bvɌ.
+    if (ContainsNoCase(path.stem().string(), "height") && IsGrayscale(image) && !HasAlpha(image)) {
+      return CookFormat_BC4;
+    }
+    return HasAlpha(image) ? CookFormat_BC3 : CookFormat_BC1;
+  }
+
+  // 2x2  box tB^ 1 ik. TCY̒[͐܂Ԃɕ.
+  Image Downsample(const Image& src, bool normalMap)
+  {
+    Image dst;
+    dst.width = std::max(src.width / 2, 1u);
+    dst.height = std::max(src.height / 2, 1u);
+    dst.rgba.resize(size_t(dst.width) * dst.height * 4);
+    for (uint32_t y = 0; y < dst.height; ++y) {
+      for (uint32_t x = 0; x < dst.width; ++x) {
+        uint32_t x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+        uint32_t y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+        const uint8_t* p[4] = {
+          &src.rgba[(size_t(y0) * src.width + x0) * 4],
+          &src.rgba[(size_t(y0) * src.width + x1) * 4],
+          &src.rgba[(size_t(y1) * src.width + x0) * 4],
+          &src.rgba[(size_t(y1) * src.width + x1) * 4],
+        };
+        uint8_t* out = &dst.rgba[(size_t(y) * dst.width + x) * 4];
+        if (normalMap) {
+          // @̓xNgƂĕςA 1 ɖ߂.
+          float n[3] = {};
+          for (auto texel : p) {
+            for (int c = 0; c < 3; ++c) {
+              n[c] += texel[c] / 127.5f - 1.0f;
+            }
+          }
+          float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+          if (length < 1e-6f) {
+            n[0] = n[1] = 0.0f;
+            n[2] = length = 1.0f;
+          }
+          for (int c = 0; c < 3; ++c) {
+            out[c] = uint8_t(std::lround((n[c] / length * 0.5f + 0.5f) * 255.0f));
+          }
+          out[3] = 255;
+        } else {
+          for (int c = 0; c < 4; ++c) {
+            out[c] = uint8_t((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+          }
+        }
+      }
+    }
+    return dst;
+  }
+
+  // 1 xubNk. [̃ubN͍ŏIs/𕡐Ė߂.
+  std::vector<uint8_t> CompressLevel(const Image& image, CookFormat format)
+  {
+    uint32_t blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+    uint32_t blockBytes = GetBlockBytes(format);
+    std::vector<uint8_t> data(size_t(blocksX) * blocksY * blockBytes);
+    for (uint32_t by = 0; by < blocksY; ++by) {
+      for (uint32_t bx = 0; bx < blocksX; ++bx) {
+        uint8_t texels[64];
+        for (uint32_t i = 0; i < 16; ++i) {
+          uint32_t x = std::min(bx * 4 + i % 4, image.width - 1);
+          uint32_t y = std::min(by * 4 + i / 4, image.height - 1);
+          memcpy(&texels[i * 4], &image.rgba[(size_t(y) * image.width + x) * 4], 4);
+        }
+        uint8_t* block = &data[(size_t(by) * blocksX + bx) * blockBytes];
+        switch (format) {
+        case CookFormat_BC1: block_compression::EncodeBC1(texels, block); break;
+        case CookFormat_BC3: block_compression::EncodeBC3(texels, block); break;
+        case CookFormat_BC4: block_compression::EncodeBC4(texels, 0, block); break;
+        case CookFormat_BC5: block_compression::EncodeBC5(texels, block); break;
+        case CookFormat_BC7: block_compression::EncodeBC7(texels, block); break;
+        default: break;
+        }
+      }
+    }
+    return data;
+  }
+
+  template<class T>
+  void Append(std::vector<uint8_t>& buffer, const T& value)
+  {
+    auto p = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), p, p + sizeof(T));
+  }
+  void AlignBuffer(std::vector<uint8_t>& buffer, size_t alignment)
+  {
+    buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, 0);
+  }
+
+  // Basic Data Format Descriptor . Tv͈kubÑ`lzu.
+  std::vector<uint8_t> BuildDataFormatDescriptor(CookFormat format, bool srgb)
+  {
+    struct Sample { uint32_t bitOffset, bitLength, channel; bool linear; };
+    std::vector<Sample> samples;
+    uint32_t colorModel = 0;
+    switch (format) {
+    case CookFormat_BC1:
+      colorModel = KHR_DF_MODEL_BC1A;
+      samples.push_back({ 0, 64, 0, false });
+      break;
+    case CookFormat_BC3:
+      colorModel = KHR_DF_MODEL_BC3;
+      samples.push_back({ 0, 64, 15, true });
+      samples.push_back({ 64, 64, 0, false });
+      break;
+    case CookFormat_BC4:
+      colorModel = KHR_DF_MODEL_BC4;
+      samples.push_back({ 0, 64, 0, false });
+      break;
+    case CookFormat_BC5:
+      colorModel = KHR_DF_MODEL_BC5;
+      samples.push_back({ 0, 64, 0, false });
+      samples.push_back({ 64, 64, 1, false });
+      break;
+    case CookFormat_BC7:
+      colorModel = KHR_DF_MODEL_BC7;
+      samples.push_back({ 0, 128, 0, false });
+      break;
+    default:
+      break;
+    }
+    uint32_t blockSize = 24 + 16 * uint32_t(samples.size());
+    std::vector<uint8_t> dfd;
+    Append(dfd, uint32_t(4 + blockSize));                        // dfdTotalSize
+    Append(dfd, uint32_t(0));                                    // vendorId | descriptorType
+    Append(dfd, uint32_t(2 | (blockSize << 16)));                // versionNumber | descriptorBlockSize
+    uint32_t transfer = srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR;
+    Append(dfd, uint32_t(colorModel | (1u << 8) | (transfer << 16)));  // model | primaries(BT709) | transfer | flags
+    Append(dfd, uint32_t(3 | (3 << 8)));                         // texelBlockDimension (4x4x1x1, el -1)
+    Append(dfd, uint32_t(GetBlockBytes(format)));                // bytesPlane0
+    Append(dfd, uint32_t(0));                                    // bytesPlane4-7
+    for (auto& sample : samples) {
+      uint32_t channelType = sample.channel | ((srgb && sample.linear) ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0);
+      Append(dfd, uint32_t(sample.bitOffset | ((sample.bitLength - 1) << 16) | (channelType << 24)));
+      Append(dfd, uint32_t(0));                                  // samplePosition
+      Append(dfd, uint32_t(0));                                  // sampleLower
+      Append(dfd, uint32_t(0xFFFFFFFF));                         // sampleUpper
+    }
+    return dfd;
+  }
+
+  bool WriteKtx2(const fs::path& path, CookFormat format, bool srgb, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels)
+  {
+    uint32_t vkFormat = 0;
+    switch (format) {
+    case CookFormat_BC1: vkFormat = VkFormat_BC1_RGB_UNORM; break;
+    case CookFormat_BC3: vkFormat = VkFormat_BC3_UNORM; break;
+    case CookFormat_BC4: vkFormat = VkFormat_BC4_UNORM; srgb = false; break;
+    case CookFormat_BC5: vkFormat = VkFormat_BC5_UNORM; srgb = false; break;
+    case CookFormat_BC7: vkFormat = VkFormat_BC7_UNORM; break;
+    default: return false;
+    }
+    if (srgb) {
+      vkFormat += 1;
+    }
+    const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    auto levelCount = uint32_t(levels.size());
+
+    auto dfd = BuildDataFormatDescriptor(format, srgb);
+    std::vector<uint8_t> kvd;
+    {
+      const char key[] = "KTXwriter";
+      const char value[] = "TextureCook";
+      Append(kvd, uint32_t(sizeof(key) + sizeof(value)));
+      kvd.insert(kvd.end(), key, key + sizeof(key));
+      kvd.insert(kvd.end(), value, value + sizeof(value));
+      AlignBuffer(kvd, 4);
+    }
+
+    // wb_[(80) + xCfbNX + DFD + KVD ̌ɁAx珇ɕׂ.
+    uint64_t headerSize = 80 + 24ull * levelCount;
+    uint64_t dfdOffset = headerSize;
+    uint64_t kvdOffset = dfdOffset + dfd.size();
+    uint64_t dataOffset = (kvdOffset + kvd.size() + 15) / 16 * 16;
+    std::vector<uint64_t> levelOffsets(levelCount);
+    for (uint32_t i = levelCount; i-- > 0;) {
+      levelOffsets[i] = dataOffset;
+      dataOffset = (dataOffset + levels[i].size() + 15) / 16 * 16;
+    }
+
+    std::vector<uint8_t> file;
+    file.insert(file.end(), identifier, identifier + sizeof(identifier));
+    Append(file, vkFormat);
+    Append(file, uint32_t(1));            // typeSize
+    Append(file, width);
+    Append(file, height);
+    Append(file, uint32_t(0));            // pixelDepth
+    Append(file, uint32_t(0));            // layerCount
+    Append(file, uint32_t(1));            // faceCount
+    Append(file, levelCount);
+    Append(file, uint32_t(0));            // supercompressionScheme
+    Append(file, uint32_t(dfdOffset));
+    Append(file, uint32_t(dfd.size()));
+    Append(file, uint32_t(kvdOffset));
+    Append(file, uint32_t(kvd.size()));
+    Append(file, uint64_t(0));            // sgdByteOffset
+    Append(file, uint64_t(0));            // sgdByteLength
+    for (uint32_t i = 0; i < levelCount; ++i) {
+      Append(file, levelOffsets[i]);
+      Append(file, uint64_t(levels[i].size()));
+      Append(file, uint64_t(levels[i].size()));
+    }
+    file.insert(file.end(), dfd.begin(), dfd.end());
+    file.insert(file.end(), kvd.begin(), kvd.end());
+    for (uint32_t i = levelCount; i-- > 0;) {
+      file.resize(levelOffsets[i], 0);
+      file.insert(file.end(), levels[i].begin(), levels[i].end());
+    }
+
+    std::ofstream outFile(path, std::ios::binary);
+    if (!outFile) {
+      return false;
+    }
+    outFile.write(reinterpret_cast<const char*>(file.data()), file.size());
+    return bool(outFile);
+  }
+
+  // ϊς (o͂͂V) Ȃ牽Ȃ.
+  bool CookFile(const fs::path& input, const fs::path& output, CookOptions options)
+  {
+    std::error_code ec;
+    if (!options.force && fs::exists(output, ec) && fs::last_write_time(output, ec) >= fs::last_write_time(input, ec)) {
+      std::cout << "skip    " << input.string() << " (up to date)" << std::endl;
+      return true;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+
+    int width = 0, height = 0, channels = 0;
+    auto pixels = stbi_load(input.string().c_str(), &width, &height, &channels, 4);
+    if (pixels == nullptr) {
+      std::cerr << "error   " << input.string() << ": " << stbi_failure_reason() << std::endl;
+      return false;
+    }
+    Image image;
+    image.width = uint32_t(width);
+    image.height = uint32_t(height);
+    image.rgba.assign(pixels, pixels + size_t(width) * height * 4);
+    stbi_image_free(pixels);
+
+    auto format = ChooseFormat(input, image, options);
+    if (options.normalMap && format == CookFormat_BC5) {
+      // x 0 KĂ (Z ͎s XY 畜).
+      for (size_t i = 0; i < image.rgba.size(); i += 4) {
+        float n[3];
+        for (int c = 0; c < 3; ++c) {
+          n[c] = image.rgba[i + c] / 127.5f - 1.0f;
+        }
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 1e-6f) {
+          for (int c = 0; c < 3; ++c) {
+            image.rgba[i + c] = uint8_t(std::lround((n[c] / length * 0.5f + 0.5f) * 255.0f));
+          }
+        }
+      }
+    }
+
+    std::vector<std::vector<uint8_t>> levels;
+    uint64_t compressedSize = 0;
+    for (;;) {
+      levels.push_back(CompressLevel(image, format));
+      compressedSize += levels.back().size();
+      if (!options.generateMips || (image.width == 1 && image.height == 1)) {
+        break;
+      }
+      image = Downsample(image, options.normalMap);
+    }
+
+    if (!WriteKtx2(output, format, options.srgb, uint32_t(width), uint32_t(height), levels)) {
+      std::cerr << "error   " << output.string() << ": failed to write." << std::endl;
+      return false;
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    uint64_t uncompressedSize = uint64_t(width) * height * 4 * 4 / 3;
+    std::cout << "cook    " << input.string() << " -> " << output.string()
+      << " [" << GetFormatName(format) << (options.srgb && format != CookFormat_BC4 && format != CookFormat_BC5 ? " sRGB" : "")
+      << ", " << width << "x" << height << ", " << levels.size() << " mips, "
+      << compressedSize / 1024 << " KB (RGBA8 " << uncompressedSize / 1024 << " KB), "
+      << elapsed << " ms]" << std::endl;
+    return true;
+  }
+
+  void PrintUsage()
+  {
+    std::cout <<
+      "usage: TextureCook [options] <input file or directory>...\n"
+      "  --format auto|bc1|bc3|bc4|bc5|bc7\n"
+      "  --normal     treat inputs as normal maps (BC5, Z reconstructed at runtime)\n"
+      "  --srgb       write sRGB formats (BC1/BC3/BC7)\n"
+      "  --no-mips    do not generate mip levels\n"
+      "  --force      cook even if the output is up to date\n"
+      "  -o <file>    output file (single input only)\n";
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  CookOptions options;
+  std::vector<fs::path> inputs;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--format" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (name == "auto") options.format = CookFormat_Auto;
+      else if (name == "bc1") options.format = CookFormat_BC1;
+      else if (name == "bc3") options.format = CookFormat_BC3;
+      else if (name == "bc4") options.format = CookFormat_BC4;
+      else if (name == "bc5") options.format = CookFormat_BC5;
+      else if (name == "bc7") options.format = CookFormat_BC7;
+      else {
+        std::cerr << "unknown format: " << name << std::endl;
+        return 1;
+      }
+    } else if (arg == "--normal") {
+      options.normalMap = true;
+    } else if (arg == "--srgb") {
+      options.srgb = true;
+    } else if (arg == "--no-mips") {
+      options.generateMips = false;
+    } else if (arg == "--force") {
+      options.force = true;
+    } else if (arg == "-o" && i + 1 < argc) {
+      options.output = argv[++i];
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage();
+      return 0;
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+  if (inputs.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::vector<fs::path> files;
+  for (auto& input : inputs) {
+    if (fs::is_directory(input)) {
+      for (auto& entry : fs::recursive_directory_iterator(input)) {
+        if (entry.is_regular_file() && IsSourceImage(entry.path())) {
+          files.push_back(entry.path());
+        }
+      }
+    } else {
+      files.push_back(input);
+    }
+  }
+  if (!options.output.empty() && files.size() != 1) {
+    std::cerr << "-o requires exactly one input file." << std::endl;
+    return 1;
+  }
+
+  int failed = 0;
+  for (auto& file : files) {
+    auto output = options.output.empty() ? fs::path(file).replace_extension(".ktx2") : options.output;
+    if (!CookFile(file, output, options)) {
+      ++failed;
+    }
+  }
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#version 450
+
+// QO`p. _VF[_[ŃXLjOAgl_InstanceIndex ŃCX^X̃pbgƔzu.
+layout(location=0) in vec4 inPos;
+layout(location=1) in vec3 inNormal;
+layout(location=2) in vec2 inUV0;
+
+layout(location=3) in uvec4 inBlendIndices;
+layout(location=4) in vec4 inBlendWeights;
+
+layout(location=0) out vec3 outNormalW;
+layout(location=1) out vec2 outUV0;
+
+out gl_PerVertex
+{
+  vec4 gl_Position;
+};
+
+layout(set=0, binding=0)
+uniform SceneParameters
+{
+  mat4  view;
+  mat4  proj;
+  vec4  lightDir;
+};
+
+layout(set=0,binding=1)
+uniform ModelMeshParamters
+{
+    mat4 world;
+    vec4 diffuse;
+    vec4 ambient;
+    vec4 positionScale;
+    vec4 positionOffset;
+    uvec4 boneRemapParams; // x: ̃bV boneRemap ̐擪, y: XLjO, z: 1 CX^X̃{[
+};
+
+// pbg̓CX^X x {[̏ɕ.
+layout(set=0,binding=2) readonly buffer BonePalette
+{
+  vec4 bonePalette[];
+};
+layout(set=0,binding=3) readonly buffer BoneRemap
+{
+  uint boneRemap[];
+};
+
+struct CrowdInstance
+{
+  mat4 world;
+  uint clip;
+  float time;
+  uint padding0;
+  uint padding1;
+};
+layout(set=0,binding=4) readonly buffer CrowdInstances
+{
+  CrowdInstance instances[];
+};
+
+const uint SKINNING_DUAL_QUATERNION = 1;
+
+uvec4 RemapBoneIndices()
+{
+  uint base = boneRemapParams.x;
+  uint instanceBase = gl_InstanceIndex * boneRemapParams.z;
+  return uvec4(
+    boneRemap[base + inBlendIndices.x], boneRemap[base + inBlendIndices.y],
+    boneRemap[base + inBlendIndices.z], boneRemap[base + inBlendIndices.w]) + instanceBase;
+}
+
+mat4 LinearBlendMatrix(uvec4 indices)
+{
+  mat4 mtx = mat4(0);
+  for(int i=0;i<4;++i) {
+    uint b = indices[i] * 4;
+    mtx += mat4(bonePalette[b], bonePalette[b + 1], bonePalette[b + 2], bonePalette[b + 3]) * inBlendWeights[i];
+  }
+  return mtx;
+}
+
+void BlendDualQuaternion(uvec4 indices, out vec4 real, out vec4 dual)
+{
+  vec4 pivot = bonePalette[indices.x * 2];
+  real = vec4(0);
+  dual = vec4(0);
+  for(int i=0;i<4;++i) {
+    vec4 r = bonePalette[indices[i] * 2];
+    vec4 d = bonePalette[indices[i] * 2 + 1];
+    float w = dot(pivot, r) < 0 ? -inBlendWeights[i] : inBlendWeights[i];
+    real += r * w;
+    dual += d * w;
+  }
+  float len = length(real);
+  real /= len;
+  dual /= len;
+}
+
+vec3 RotateByQuaternion(vec4 q, vec3 v)
+{
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void SkinVertex(out vec4 position, out vec3 normal)
+{
+  uvec4 indices = RemapBoneIndices();
+  if (boneRemapParams.y == SKINNING_DUAL_QUATERNION) {
+    vec4 real, dual;
+    BlendDualQuaternion(indices, real, dual);
+    vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+    position = vec4(RotateByQuaternion(real, inPos.xyz) + translation, 1);
+    normal = normalize(RotateByQuaternion(real, inNormal));
+    return;
+  }
+  mat4 mtx = LinearBlendMatrix(indices);
+  position = vec4((mtx * inPos).xyz, 1);
+  normal = normalize(mat3(mtx) * inNormal);
+}
+
+void main()
+{
+  vec4 pos;
+  vec3 normal;
+  SkinVertex(pos, normal);
+  mat4 instanceWorld = instances[gl_InstanceIndex].world;
+  gl_Position = proj * view * instanceWorld * pos;
+  outNormalW = mat3(instanceWorld) * normal;
+  outUV0 = inUV0;
+}
@@ -29,48 +29,91 @@ layout(set=0,binding=1)
 uniform ModelMeshParamters
 {
     mat4 world;
+    vec4 diffuse;
+    vec4 ambient;
+    vec4 positionScale;
+    vec4 positionOffset;
+    uvec4 boneRemapParams; // x: ̃bV boneRemap ̐擪, y: XLjO
 };
 
-layout(set=0,binding=2)
-uniform BoneMatrices
+// fŜ 1 ̃{[pbg. bṼ{[ԍ boneRemap ŕϊĈ.
+// boneRemapParams.y  0 Ȃ{[ 1 {ɂs (vec4 x 4)A1 ȂfANH[^jI (vec4 x 2).
+layout(set=0,binding=2) readonly buffer BonePalette
 {
-  mat4 boneMatrices[512];
+  vec4 bonePalette[];
+};
+layout(set=0,binding=3) readonly buffer BoneRemap
+{
+  uint boneRemap[];
 };
 
-vec4 TransformPosition() 
+const uint SKINNING_DUAL_QUATERNION = 1;
+
+uvec4 RemapBoneIndices()
 {
-  vec4 pos = vec4(0);
-  uint indices[4] = uint[4](inBlendIndices.x, inBlendIndices.y, inBlendIndices.z, inBlendIndices.w);
-  float weights[4] = float[4](
-    inBlendWeights.x, inBlendWeights.y, inBlendWeights.z, inBlendWeights.w
-  );
+  uint base = boneRemapParams.x;
+  return uvec4(
+    boneRemap[base + inBlendIndices.x], boneRemap[base + inBlendIndices.y],
+    boneRemap[base + inBlendIndices.z], boneRemap[base + inBlendIndices.w]);
+}
 
+mat4 LinearBlendMatrix(uvec4 indices)
+{
+  mat4 mtx = mat4(0);
   for(int i=0;i<4;++i) {
-    mat4 mtx = boneMatrices[indices[i]];
-    pos += mtx * inPos * weights[i];
+    uint b = indices[i] * 4;
+    mtx += mat4(bonePalette[b], bonePalette[b + 1], bonePalette[b + 2], bonePalette[b + 3]) * inBlendWeights[i];
   }
-  pos.w = 1;
-  return pos;
+  return mtx;
 }
-vec3 TransformNormal()
+
+// 4 ̃fANH[^jIŏ̃{[ƓɑđAK.
+void BlendDualQuaternion(uvec4 indices, out vec4 real, out vec4 dual)
 {
-  vec3 nrm = vec3(0);
-  uint indices[4] = uint[4](inBlendIndices.x, inBlendIndices.y, inBlendIndices.z, inBlendIndices.w);
-  float weights[4] = float[4](
-    inBlendWeights.x, inBlendWeights.y, inBlendWeights.z, inBlendWeights.w
-  );
+  vec4 pivot = bonePalette[indices.x * 2];
+  real = vec4(0);
+  dual = vec4(0);
   for(int i=0;i<4;++i) {
-    mat3 mtx = mat3(boneMatrices[indices[i]]);
-    nrm += mtx * inNormal * weights[i];
+    vec4 r = bonePalette[indices[i] * 2];
+    vec4 d = bonePalette[indices[i] * 2 + 1];
+    float w = dot(pivot, r) < 0 ? -inBlendWeights[i] : inBlendWeights[i];
+    real += r * w;
+    dual += d * w;
+  }
+  float len = length(real);
+  real /= len;
+  dual /= len;
+}
+
+vec3 RotateByQuaternion(vec4 q, vec3 v)
+{
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// XLjÖʒuƖ@ (f).
+void SkinVertex(out vec4 position, out vec3 normal)
+{
+  uvec4 indices = RemapBoneIndices();
+  if (boneRemapParams.y == SKINNING_DUAL_QUATERNION) {
+    vec4 real, dual;
+    BlendDualQuaternion(indices, real, dual);
+    vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+    position = vec4(RotateByQuaternion(real, inPos.xyz) + translation, 1);
+    normal = normalize(RotateByQuaternion(real, inNormal));
+    return;
   }
-  return normalize(nrm);
+  mat4 mtx = LinearBlendMatrix(indices);
+  position = vec4((mtx * inPos).xyz, 1);
+  normal = normalize(mat3(mtx) * inNormal);
 }
 
 
 void main()
 {
-  vec4 position = TransformPosition();
+  vec4 position;
+  vec3 normal;
+  SkinVertex(position, normal);
   outPosition = position.xyz;
-  outNormal = TransformNormal();
+  outNormal = normal;
   outUV0 = inUV0;
 }
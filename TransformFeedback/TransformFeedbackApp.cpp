@@ -7,7 +7,13 @@
 #include "backends/imgui_impl_vulkan.h"
 #include "backends/imgui_impl_glfw.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 using namespace glm;
@@ -25,6 +31,10 @@ void TransformFeedbackApp::Prepare()
   _vkCmdBeginTransformFeedbackEXT = (PFN_vkCmdBeginTransformFeedbackEXT)vkGetDeviceProcAddr(m_device, "vkCmdBeginTransformFeedbackEXT");
   _vkCmdEndTransformFeedbackEXT = (PFN_vkCmdEndTransformFeedbackEXT)vkGetDeviceProcAddr(m_device, "vkCmdEndTransformFeedbackEXT");
   _vkCmdBindTransformFeedbackBuffersEXT = (PFN_vkCmdBindTransformFeedbackBuffersEXT)vkGetDeviceProcAddr(m_device, "vkCmdBindTransformFeedbackBuffersEXT");
+  m_xfbSupported = _vkCmdBeginTransformFeedbackEXT && _vkCmdEndTransformFeedbackEXT && _vkCmdBindTransformFeedbackBuffersEXT;
+  if (!m_xfbSupported) {
+    m_mode = DrawMode_Compute;
+  }
   CreateSampleLayouts();
 
   auto colorFormat = m_swapchain->GetSurfaceFormat().format;
@@ -45,6 +55,7 @@ void TransformFeedbackApp::Prepare()
     c.fence = CreateFence();
     c.commandBuffer = CreateCommandBuffer(false); // R}hobt@JnԂɂȂ.
   }
+  m_gpuTimer.Prepare(m_device, m_physicalDevice, imageCount);
 
   // 萔obt@̏.
   auto bufferSize = uint32_t(sizeof(ShaderParameters));
@@ -61,28 +72,34 @@ void TransformFeedbackApp::Prepare()
     VK_SAMPLER_ADDRESS_MODE_REPEAT,
     VK_SAMPLER_ADDRESS_MODE_REPEAT,
     0.0f, VK_FALSE, 1.0f, VK_FALSE,
-    VK_COMPARE_OP_NEVER, 0.0f, 0.0f,
+    VK_COMPARE_OP_NEVER, 0.0f, VK_LOD_CLAMP_NONE,
     VK_BORDER_COLOR_INT_OPAQUE_WHITE, VK_FALSE,
   };
   vkCreateSampler(m_device, &samplerCI, nullptr, &m_sampler);
 
   
-  m_model = LoadModelData("assets/model/Alicia_solid.pmx");
+  // XLjOƕ`ł Tangent gȂ.
+  ModelLoadOptions loadOptions{};
+  loadOptions.attributeMask = VertexAttributeMask_All & ~VertexAttributeBit(VertexAttribute_Tangent);
+  m_model = LoadModelData("assets/model/Alicia_solid.pmx", loadOptions);
   PrepareModelResource(m_model);
+  // 葱ōNbv͎t̃|[YÕoCh|[Yɂ.
+  PrepareAnimationClips();
 
   {
     auto neck = m_model.FindNode("");
-    neck->transform = glm::rotate(glm::mat4(1.0f), glm::radians(20.0f), glm::vec3(0, 1, 0)) * neck->transform;
+    m_model.nodes.SetLocalMatrix(neck, glm::rotate(glm::mat4(1.0f), glm::radians(20.0f), glm::vec3(0, 1, 0)) * m_model.nodes.GetLocalMatrix(neck));
   }
   {
     auto elbow = m_model.FindNode("Ђ");
-    elbow->transform = elbow->transform * glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0, 1, 0));
+    m_model.nodes.SetLocalMatrix(elbow, m_model.nodes.GetLocalMatrix(elbow) * glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0, 1, 0)));
   }
   {
     auto elbow = m_model.FindNode("Ђ");
-    elbow->transform = elbow->transform * glm::rotate(glm::mat4(1.0f), glm::radians(45.0f), glm::vec3(1, 0, 0));
+    m_model.nodes.SetLocalMatrix(elbow, m_model.nodes.GetLocalMatrix(elbow) * glm::rotate(glm::mat4(1.0f), glm::radians(45.0f), glm::vec3(1, 0, 0)));
   }
-  m_model.rootNode->UpdateMatrices(glm::mat4(1.0f));
+  m_model.nodes.UpdateWorldMatrices();
+  m_pose.Initialize(m_model.nodes);
 
 
   m_camera.SetPerspective(
@@ -92,7 +109,21 @@ void TransformFeedbackApp::Prepare()
 
 void TransformFeedbackApp::Cleanup()
 {
+  StopCrowdWorkers();
+  m_gpuTimer.Cleanup();
   m_model.Release(this);
+  for (auto& palette : m_comparePalettes) {
+    DestroyBuffer(palette);
+  }
+  m_comparePalettes.clear();
+  for (auto& buffer : m_crowdInstanceBuffers) {
+    DestroyBuffer(buffer);
+  }
+  m_crowdInstanceBuffers.clear();
+  for (auto& palette : m_crowdPalettes) {
+    DestroyBuffer(palette);
+  }
+  m_crowdPalettes.clear();
 
   for (auto& ubo : m_uniformBuffers)
   {
@@ -208,7 +239,19 @@ void TransformFeedbackApp::Render()
 
   auto command = m_commandBuffers[imageIndex].commandBuffer;
 
+  UpdateAnimation();
+  auto updatedNodes = m_model.nodes.UpdateWorldMatrices();
+  UpdateSkinnedVertexCache(updatedNodes);
+  UpdateBonePalettes();
+  if (m_crowdEnabled) {
+    UpdateCrowd();
+  }
+
   vkBeginCommandBuffer(command, &commandBI);
+  m_gpuTimer.BeginFrame(command, imageIndex);
+  if (m_mode == DrawMode_Compute && !m_crowdEnabled) {
+    DispatchSkinning(command);
+  }
   vkCmdBeginRenderPass(command, &rpBI, VK_SUBPASS_CONTENTS_INLINE);
 
   auto extent = m_swapchain->GetSurfaceExtent();
@@ -220,8 +263,11 @@ void TransformFeedbackApp::Render()
   vkCmdSetScissor(command, 0, 1, &scissor);
   vkCmdSetViewport(command, 0, 1, &viewport);
 
-  m_model.rootNode->UpdateMatrices(glm::mat4(1.0f));
-  DrawModel(command);
+  if (m_crowdEnabled) {
+    DrawCrowd(command);
+  } else {
+    DrawModel(command);
+  }
 
   RenderHUD(command);
 
@@ -241,10 +287,113 @@ void TransformFeedbackApp::Render()
   vkQueueSubmit(m_deviceQueue, 1, &submitInfo, fence);
 
   m_swapchain->QueuePresent(m_deviceQueue, imageIndex, m_renderCompletedSem);
+
+  UpdateSkinningBenchmark();
 }
 
 
 
+void TransformFeedbackApp::PrepareAnimationClips()
+{
+  m_clips = m_model.animations;
+  if (m_clips.empty()) {
+    // wm[hoCh|[Y玲܂ sin gŗh炷`l.
+    auto addSwing = [&](AnimationClip& clip, const char* nodeName, const vec3& axis, float baseDegree, float amplitudeDegree, float cycles) {
+      auto node = m_model.FindNode(nodeName);
+      if (node == NodeHierarchy::InvalidIndex) {
+        return;
+      }
+      vec3 bindT, bindS;
+      quat bindR;
+      animation::DecomposeMatrix(m_model.nodes.GetLocalMatrix(node), bindT, bindR, bindS);
+
+      // 1  8 L[. ʒuƃXP[̃L[͎AoCh|[Y̒lg킹.
+      const uint32_t keyCount = uint32_t(cycles * 8) + 1;
+      AnimationChannel ch;
+      ch.nodeName = nodeName;
+      ch.node = node;
+      ch.rotationTimes.resize(keyCount);
+      ch.rotations.resize(keyCount);
+      for (uint32_t k = 0; k < keyCount; ++k) {
+        float t = clip.duration * k / (keyCount - 1);
+        float phase = 2.0f * glm::pi<float>() * cycles * t / clip.duration;
+        float degree = baseDegree + amplitudeDegree * std::sin(phase);
+        ch.rotationTimes[k] = t;
+        ch.rotations[k] = bindR * angleAxis(radians(degree), axis);
+      }
+      clip.channels.push_back(std::move(ch));
+    };
+
+    AnimationClip sway;
+    sway.name = "Sway";
+    sway.duration = 2.0f;
+    addSwing(sway, "", vec3(0, 1, 0), 0.0f, 30.0f, 1.0f);
+    addSwing(sway, "㔼g", vec3(0, 0, 1), 0.0f, 8.0f, 1.0f);
+
+    AnimationClip wave;
+    wave.name = "Wave";
+    wave.duration = 2.0f;
+    addSwing(wave, "Ђ", vec3(0, 1, 0), -90.0f, 30.0f, 2.0f);
+    addSwing(wave, "EЂ", vec3(0, 1, 0), 90.0f, 30.0f, 2.0f);
+
+    m_clips.push_back(std::move(sway));
+    m_clips.push_back(std::move(wave));
+  }
+
+  m_compressedClips.clear();
+  for (const auto& clip : m_clips) {
+    animation::CompressionReport report;
+    m_compressedClips.push_back(animation::CompressClip(clip, animation::CompressionSettings{}, &report));
+    std::stringstream ss;
+    ss << "[AnimCompression] " << clip.name << " : " << report.sourceKeyCount << " -> " << report.keptKeyCount << " keys, "
+      << report.sourceBytes << " -> " << report.compressedBytes << " bytes" << std::endl;
+    for (const auto& e : report.channels) {
+      ss << "  " << e.nodeName << " : max error T " << e.translation << " R " << degrees(e.rotation) << " deg S " << e.scale << std::endl;
+    }
+    OutputDebugStringA(ss.str().c_str());
+  }
+
+  m_clipNames.clear();
+  for (const auto& clip : m_clips) {
+    m_clipNames += clip.name.empty() ? std::string("(no name)") : clip.name;
+    m_clipNames.push_back('\0');
+  }
+  m_clipA = 0;
+  m_clipB = m_clips.size() > 1 ? 1 : 0;
+
+  std::stringstream ss;
+  ss << "[Anim] " << m_clips.size() << " clips" << (m_model.animations.empty() ? " (generated)" : "") << std::endl;
+  for (const auto& clip : m_clips) {
+    ss << "  " << clip.name << " : " << clip.duration << " s, " << clip.channels.size() << " channels, "
+      << clip.GetKeyCount() << " keys, " << clip.GetMemorySize() << " bytes" << std::endl;
+  }
+  OutputDebugStringA(ss.str().c_str());
+}
+
+void TransformFeedbackApp::UpdateAnimation()
+{
+  if (!m_playAnimation || m_clips.empty()) {
+    return;
+  }
+  m_animationTime += float(GetFrameDeltaTime()) * m_animationSpeed;
+
+  animation::BlendLayer layers[2] = {
+    { &m_clips[m_clipA], &m_cursors[0], m_animationTime, 1.0f - m_blendWeight },
+    { &m_clips[m_clipB], &m_cursors[1], m_animationTime, m_blendWeight },
+  };
+  if (m_useCompressedClips) {
+    layers[0].compressedClip = &m_compressedClips[m_clipA];
+    layers[1].compressedClip = &m_compressedClips[m_clipB];
+  }
+  // uhȂƂ A Tv.
+  uint32_t layerCount = m_blendWeight > 0.0f ? 2 : 1;
+  if (layerCount == 1) {
+    layers[0].weight = 1.0f;
+  }
+  animation::SampleBlended(layers, layerCount, m_pose);
+  m_animatedNodeCount = animation::ApplyPose(m_pose, m_model.nodes);
+}
+
 void TransformFeedbackApp::PrepareFramebuffers()
 {
   auto imageCount = m_swapchain->GetImageCount();
@@ -398,6 +547,23 @@ void TransformFeedbackApp::CreatePipeline()
     book_util::DestroyShaderModules(m_device, shaderStages);
     m_pipelines[CombinedBufferDrawPipeline] = pipeline;
   }
+
+  // Rs[gVF[_[ŃXLjOpCvC̍\z.
+  {
+    auto stage = book_util::LoadShader(m_device, "assets/shader/skinningCS.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+    VkComputePipelineCreateInfo computeCI{
+      VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      nullptr, 0,
+      stage,
+      GetPipelineLayout("skinning"),
+      VK_NULL_HANDLE, 0,
+    };
+    VkPipeline pipeline;
+    result = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &computeCI, nullptr, &pipeline);
+    ThrowIfFailed(result, "vkCreateComputePipelines Failed. (skinning)");
+    vkDestroyShaderModule(m_device, stage.module, nullptr);
+    m_pipelines[ComputeSkinningPipeline] = pipeline;
+  }
 }
 
 void TransformFeedbackApp::PrepareModelResource(ModelAsset& model)
@@ -508,7 +674,7 @@ void TransformFeedbackApp::PrepareModelResource(ModelAsset& model)
     VK_NULL_HANDLE, 0, // basePipeline
   };
 
-  {
+  if (m_xfbSupported) {
     // WIgVF[_[gXtH[tB[hobNg߂̃pCvC쐬.
     std::vector<VkPipelineShaderStageCreateInfo> shaderStages
     {
@@ -525,7 +691,7 @@ void TransformFeedbackApp::PrepareModelResource(ModelAsset& model)
     m_pipelines[GeometryShaderXfbPipeline] = pipeline;
   }
 
-  {
+  if (m_xfbSupported) {
     // _VF[_[gXtH[tB[hobNg߂̃pCvC쐬.
     std::vector<VkPipelineShaderStageCreateInfo> shaderStages
     {
@@ -540,6 +706,24 @@ void TransformFeedbackApp::PrepareModelResource(ModelAsset& model)
     m_pipelines[VertexShaderXfbSlimPipeline] = pipeline;
   }
 
+  if (hasBone) {
+    // QO`p. _VF[_[ŃCX^XƂ̃pbgăXLjOÂ܂ܕ`.
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages
+    {
+      book_util::LoadShader(m_device, "assets/shader/crowdVS.spv", VK_SHADER_STAGE_VERTEX_BIT),
+      book_util::LoadShader(m_device, "assets/shader/xfbDrawFS.spv", VK_SHADER_STAGE_FRAGMENT_BIT),
+    };
+    pipelineCI.pStages = shaderStages.data();
+    pipelineCI.stageCount = uint32_t(shaderStages.size());
+    pipelineCI.layout = GetPipelineLayout("crowd");
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    auto result = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pipeline);
+    ThrowIfFailed(result, "vkCreateGraphicsPipelines Failed. (crowd)");
+    book_util::DestroyShaderModules(m_device, shaderStages);
+    m_pipelines[CrowdDrawPipeline] = pipeline;
+    pipelineCI.layout = pipelineLayout;
+  }
+
   model.pipelineLayout = pipelineLayout;
   auto imageCount = m_swapchain->GetImageCount();
 
@@ -557,11 +741,15 @@ void TransformFeedbackApp::PrepareModelResource(ModelAsset& model)
       VkDescriptorBufferInfo modelUniformUBO{
         drawBatch.modelMeshParameterUBO[j].buffer, 0, VK_WHOLE_SIZE,
       };
-      VkDescriptorBufferInfo boneUBO{
+      VkDescriptorBufferInfo bonePalette{
+        VK_NULL_HANDLE, 0, VK_WHOLE_SIZE
+      };
+      VkDescriptorBufferInfo boneRemap{
         VK_NULL_HANDLE, 0, VK_WHOLE_SIZE
       };
       if (hasBone) {
-        boneUBO.buffer = drawBatch.boneMatrixPalette[j].buffer;
+        bonePalette.buffer = model.boneMatrixPalette[j].buffer;
+        boneRemap.buffer = model.BoneRemap.buffer;
       }
 
       VkDescriptorImageInfo modelTexture{};
@@ -572,7 +760,8 @@ void TransformFeedbackApp::PrepareModelResource(ModelAsset& model)
       VkWriteDescriptorSet writes[] = {
         book_util::CreateWriteDescriptorSet(descriptorSet, DS_SCENE_UNIFORM, &sceneUniformUBO),
         book_util::CreateWriteDescriptorSet(descriptorSet, DS_MODEL_UNIFORM, &modelUniformUBO),
-        book_util::CreateWriteDescriptorSet(descriptorSet, DS_BONE_UNIFORM, &boneUBO),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_BONE_PALETTE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bonePalette),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_BONE_REMAP, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &boneRemap),
         book_util::CreateWriteDescriptorSet(descriptorSet, DS_MATERIAL_ALBEDO, &modelTexture),
       };
       vkUpdateDescriptorSets(m_device, _countof(writes), writes, 0, nullptr);
@@ -581,18 +770,66 @@ void TransformFeedbackApp::PrepareModelResource(ModelAsset& model)
   }
 
   // Transform Feedback pf[^̏.
+  // Lv`̓CfbNXWJgCAOXg̏ɏ̂ŁACfbNẌ̗悪v.
   auto stride = (sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec2));
-  auto bufferSize = model.totalVertexCount * stride;
-  model.extraBuffers["xfbBuffer"] = CreateBuffer(
-    uint32_t(bufferSize),
-    VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_BUFFER_BIT_EXT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  bufferSize = sizeof(glm::vec4);
-  model.extraBuffers["xfbCountBuffer"] = CreateBuffer(
-    uint32_t(bufferSize),
-    VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_COUNTER_BUFFER_BIT_EXT,
+  if (m_xfbSupported) {
+    auto bufferSize = book_util::CheckedBufferSize(model.totalIndexCount, stride);
+    model.extraBuffers["xfbBuffer"] = CreateBuffer(
+      bufferSize,
+      VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_BUFFER_BIT_EXT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    bufferSize = sizeof(glm::vec4);
+    model.extraBuffers["xfbCountBuffer"] = CreateBuffer(
+      bufferSize,
+      VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_COUNTER_BUFFER_BIT_EXT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+
+  // Rs[gXLjȌo. ͒_̏ɏ̂ŁA`ɂ͌̃CfbNXobt@g.
+  // 㔼͔r\ŃfANH[^jǏʂu.
+  model.extraBuffers["skinnedBuffer"] = CreateBuffer(
+    book_util::CheckedBufferSize(book_util::CheckedBufferSize(model.totalVertexCount, 2), stride),
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  
+  // o͐蒼̂ŁAŏ̃t[͕KXLjO.
+  m_skinnedCache.valid = false;
+  if (hasBone) {
+    // pbgƕϊ\̓f 1 Ȃ̂ŁADrawBatch Ƃ̈Ⴂ̓vbV萔ɂȂ.
+    auto skinnedBuffer = model.extraBuffers["skinnedBuffer"].buffer;
+    auto skinningLayout = GetDescriptorSetLayout("skinning");
+    auto allocateSkinningSet = [&](VkBuffer palette) {
+      auto descriptorSet = AllocateDescriptorSet(skinningLayout);
+      VkDescriptorBufferInfo positions{ model.Position.buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo normals{ model.Normal.buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo uv0s{ model.UV0.buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo blendIndices{ model.BoneIndices.buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo blendWeights{ model.BoneWeights.buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo bonePalette{ palette, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo skinned{ skinnedBuffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo boneRemap{ model.BoneRemap.buffer, 0, VK_WHOLE_SIZE };
+      VkWriteDescriptorSet writes[] = {
+        book_util::CreateWriteDescriptorSet(descriptorSet, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &positions),
+        book_util::CreateWriteDescriptorSet(descriptorSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &normals),
+        book_util::CreateWriteDescriptorSet(descriptorSet, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &uv0s),
+        book_util::CreateWriteDescriptorSet(descriptorSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &blendIndices),
+        book_util::CreateWriteDescriptorSet(descriptorSet, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &blendWeights),
+        book_util::CreateWriteDescriptorSet(descriptorSet, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bonePalette),
+        book_util::CreateWriteDescriptorSet(descriptorSet, 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &skinned),
+        book_util::CreateWriteDescriptorSet(descriptorSet, 7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &boneRemap),
+      };
+      vkUpdateDescriptorSets(m_device, _countof(writes), writes, 0, nullptr);
+      return descriptorSet;
+    };
+
+    // r\ł̓fANH[^jĨpbgʂɎ.
+    m_comparePalettes = CreateStorageBuffers(sizeof(glm::vec4) * 2 * model.skeletonNodes.size(), imageCount);
+    m_skinningDescriptorSets.resize(imageCount);
+    m_compareDescriptorSets.resize(imageCount);
+    for (uint32_t j = 0; j < imageCount; ++j) {
+      m_skinningDescriptorSets[j] = allocateSkinningSet(model.boneMatrixPalette[j].buffer);
+      m_compareDescriptorSets[j] = allocateSkinningSet(m_comparePalettes[j].buffer);
+    }
+  }
 }
 
 void TransformFeedbackApp::RenderHUD(VkCommandBuffer command)
@@ -605,7 +842,102 @@ void TransformFeedbackApp::RenderHUD(VkCommandBuffer command)
   // ImGui EBWFbg`悷.
   ImGui::Begin("Information");
   ImGui::Text("Framerate: %.1f FPS", ImGui::GetIO().Framerate);
-  ImGui::Combo("Mode", (int*)&m_mode, "GS (XFB)\0VS (XFB)\0\0");
+  const char* modeNames[] = { "GS (XFB)", "VS (XFB)", "Compute" };
+  const char* methodNames[] = { "Linear", "DualQuat" };
+  if (m_skinningBenchmark.running) {
+    ImGui::Text("Benchmark running... (%s, %s)", modeNames[m_mode], methodNames[m_skinningMethod]);
+  } else {
+    if (ImGui::Combo("Mode", (int*)&m_mode, modeNames, _countof(modeNames))) {
+      if (!m_xfbSupported) {
+        m_mode = DrawMode_Compute;
+      }
+      if (m_mode != DrawMode_Compute) {
+        m_compareSkinning = false;
+      }
+      m_gpuTimer.ResetAverage();
+    }
+    if (ImGui::Combo("Skinning", (int*)&m_skinningMethod, methodNames, _countof(methodNames))) {
+      m_gpuTimer.ResetAverage();
+    }
+    // r\̓Rs[g̏o͂ 2 gׂ.
+    if (ImGui::Checkbox("Compare Linear | DualQuat", &m_compareSkinning)) {
+      if (m_compareSkinning) {
+        m_mode = DrawMode_Compute;
+        m_crowdEnabled = false;
+      }
+      m_gpuTimer.ResetAverage();
+    }
+    if (ImGui::Button("Benchmark skinning")) {
+      m_skinningBenchmark = SkinningBenchmark{};
+      m_skinningBenchmark.running = true;
+      m_skinningBenchmark.restoreMode = m_mode;
+      m_skinningBenchmark.restoreMethod = m_skinningMethod;
+      m_skinningBenchmark.restoreCompare = m_compareSkinning;
+      m_skinningBenchmark.mode = m_xfbSupported ? DrawMode_GS_XFB : DrawMode_Compute;
+      m_mode = DrawMode(m_skinningBenchmark.mode);
+      m_skinningMethod = SkinningMethod(m_skinningBenchmark.method);
+      m_compareSkinning = false;
+      m_crowdEnabled = false;
+      m_gpuTimer.ResetAverage();
+    }
+  }
+  ImGui::Text("Skinning: %.3f ms / Draw: %.3f ms", m_gpuTimer.GetAverageMs(SkinningTimer), m_gpuTimer.GetAverageMs(DrawTimer));
+  ImGui::Text("Palette: %u bones, %.1f KB/frame, %.1f us (CPU)",
+    uint32_t(m_model.skeletonNodes.size()), m_paletteBytes / 1024.0, m_paletteMicroseconds);
+  if (ImGui::Checkbox("Reuse skinned vertices", &m_lazySkinning)) {
+    m_gpuTimer.ResetAverage();
+  }
+  ImGui::Text("Skinning skipped: %u / %u frames%s", m_skinningSkippedLastWindow, SkinningCacheWindow,
+    m_reuseSkinnedVertices ? " (cached)" : "");
+  if (m_skinningBenchmark.hasResult) {
+    const auto& b = m_skinningBenchmark;
+    for (int i = 0; i < DrawMode_Count; ++i) {
+      if (!m_xfbSupported && i != DrawMode_Compute) {
+        continue;
+      }
+      for (int m = 0; m < SkinningMethod_Count; ++m) {
+        ImGui::Text("%-9s %-8s skinning %.3f ms / draw %.3f ms", modeNames[i], methodNames[m],
+          b.skinningMs[i][m], b.drawMs[i][m]);
+      }
+    }
+    for (int m = 0; m < SkinningMethod_Count; ++m) {
+      ImGui::Text("%-8s palette %.1f KB/frame, %.1f us", methodNames[m], b.paletteBytes[m] / 1024.0, b.paletteMicroseconds[m]);
+    }
+  }
+  if (ImGui::Button("Node hierarchy benchmark")) {
+    RunNodeHierarchyBenchmark();
+  }
+  if (m_hierarchyBenchmark.boneCount > 0) {
+    const auto& b = m_hierarchyBenchmark;
+    ImGui::Text("%u bones: tree %.2f us, flat %.2f us, partial %.2f us (%u nodes)",
+      b.boneCount, b.treeMicroseconds, b.flatMicroseconds, b.partialMicroseconds, b.partialUpdatedNodes);
+  }
+  if (!m_clips.empty()) {
+    ImGui::Checkbox("Play animation", &m_playAnimation);
+    ImGui::Combo("Clip A", &m_clipA, m_clipNames.c_str());
+    ImGui::Combo("Clip B", &m_clipB, m_clipNames.c_str());
+    ImGui::SliderFloat("Blend (B)", &m_blendWeight, 0.0f, 1.0f);
+    ImGui::SliderFloat("Speed", &m_animationSpeed, 0.0f, 4.0f);
+    ImGui::Checkbox("Compressed clips", &m_useCompressedClips);
+    ImGui::Text("[Anim] %.2f s, %u nodes written", m_animationTime, m_animatedNodeCount);
+  }
+  if (!m_clips.empty() && !m_model.skeletonNodes.empty() && !m_skinningBenchmark.running) {
+    // QO̓NbvƍĐʒuG[WFgƂɎ. ̃Nbv A/B ƃuh͎gȂ.
+    if (ImGui::Checkbox("Crowd", &m_crowdEnabled)) {
+      if (m_crowdEnabled) {
+        PrepareCrowd();
+        m_compareSkinning = false;
+      }
+      m_gpuTimer.ResetAverage();
+    }
+    if (m_crowdEnabled) {
+      if (ImGui::SliderInt("Crowd count", &m_crowdCount, 1, int(MaxCrowdInstances))) {
+        ResetCrowdAgents();
+      }
+      ImGui::Text("[Crowd] %d instances, %u threads, %.1f us (CPU), %u draws",
+        m_crowdCount, m_crowdThreadCount, m_crowdUpdateMicroseconds, uint32_t(m_model.DrawBatches.size()));
+    }
+  }
   ImGui::End();
 
   ImGui::Render();
@@ -614,9 +946,216 @@ void TransformFeedbackApp::RenderHUD(VkCommandBuffer command)
   );
 }
 
+void TransformFeedbackApp::UpdateBonePalettes()
+{
+  auto imageIndex = m_swapchain->GetCurrentBufferIndex();
+  // r\ł͖{̃pbgɐ`uhp̍sAfANH[^jI͕ʂ̃pbgɏ.
+  auto method = m_compareSkinning ? SkinningMethod_Linear : m_skinningMethod;
+  for (auto& batch : m_model.DrawBatches) {
+    const auto& material = m_model.materials[batch.materialIndex];
+    ModelMeshParameters meshParameters{};
+    meshParameters.mtxWorld = glm::mat4(1.0f);
+    meshParameters.diffuse = glm::vec4(material.diffuse, material.shininess);
+    meshParameters.ambient = glm::vec4(material.ambient, 0);
+    meshParameters.boneRemap.x = batch.boneRemapOffset;
+    meshParameters.boneRemap.y = method;
+    meshParameters.boneRemap.z = uint32_t(m_model.skeletonNodes.size());
+
+    WriteToHostVisibleMemory(
+      batch.modelMeshParameterUBO[imageIndex].memory,
+      sizeof(meshParameters),
+      &meshParameters);
+  }
+
+  if (m_reuseSkinnedVertices) {
+    // XLjOȂt[̓pbgǂ܂Ȃ.
+    m_paletteBytes = 0;
+    m_paletteLastMicroseconds = 0.0;
+    m_paletteMicroseconds -= m_paletteMicroseconds * 0.05;
+    return;
+  }
+
+  // {[s̓XPgŜ 1 񂾂ď.
+  using Clock = std::chrono::high_resolution_clock;
+  auto start = Clock::now();
+  m_paletteBytes = UpdateBonePalette(m_model, imageIndex, method);
+  if (m_compareSkinning && imageIndex < m_comparePalettes.size()) {
+    m_paletteBytes += WriteBonePalette(m_model, m_comparePalettes[imageIndex].memory, SkinningMethod_DualQuaternion);
+  }
+  m_paletteLastMicroseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  m_paletteMicroseconds += (m_paletteLastMicroseconds - m_paletteMicroseconds) * 0.05;
+}
+
+void TransformFeedbackApp::UpdateSkinnedVertexCache(uint32_t updatedNodes)
+{
+  auto& cache = m_skinnedCache;
+  m_reuseSkinnedVertices = false;
+  if (m_crowdEnabled) {
+    // QO\͒P̂̃XLjOʂȂ̂ŁA߂Ƃɍ蒼.
+    cache.valid = false;
+    return;
+  }
+
+  // [hs 1 XVĂȂ΁AnbV蒼܂łȂ.
+  // Đłl߂Ă邾 (~⑬x 0) ̂Ƃ̂ŁAXVƂ̓nbVŔׂ.
+  auto poseHash = (updatedNodes == 0 && cache.valid) ? cache.poseHash : HashSkeletonPose(m_model);
+  bool unchanged = cache.valid && cache.poseHash == poseHash &&
+    cache.mode == m_mode && cache.method == m_skinningMethod && cache.compare == m_compareSkinning;
+  // x`}[N͖t[̃XLjOv̂Ŏg񂳂Ȃ.
+  m_reuseSkinnedVertices = m_lazySkinning && unchanged && !m_skinningBenchmark.running;
+
+  cache.valid = true;
+  cache.poseHash = poseHash;
+  cache.mode = m_mode;
+  cache.method = m_skinningMethod;
+  cache.compare = m_compareSkinning;
+
+  m_skinningFrames++;
+  if (m_reuseSkinnedVertices) {
+    m_skinningSkippedFrames++;
+  }
+  if (m_skinningFrames >= SkinningCacheWindow) {
+    m_skinningSkippedLastWindow = m_skinningSkippedFrames;
+    m_skinningFrames = 0;
+    m_skinningSkippedFrames = 0;
+  }
+}
+
+void TransformFeedbackApp::DispatchSkinning(VkCommandBuffer command)
+{
+  if (m_skinningDescriptorSets.empty()) {
+    return;
+  }
+  if (m_reuseSkinnedVertices) {
+    // O skinnedBuffer ̂܂܎g. ܂Ȃ̂ŃoAvȂ.
+    m_gpuTimer.End(command, m_gpuTimer.Begin(command, SkinningTimer));
+    return;
+  }
+  auto imageIndex = m_swapchain->GetCurrentBufferIndex();
+  auto skinnedBuffer = m_model.extraBuffers["skinnedBuffer"].buffer;
+
+  // Õt[̕`悪ǂݏIĂ珑.
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+  auto timer = m_gpuTimer.Begin(command, SkinningTimer);
+  auto layout = GetPipelineLayout("skinning");
+  vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[ComputeSkinningPipeline]);
+
+  // r\ł 1 ڂ`uhōɁA2 ڂfANH[^jIŃobt@̌㔼 (E) ɏo͂.
+  const uint32_t passCount = m_compareSkinning ? 2 : 1;
+  for (uint32_t pass = 0; pass < passCount; ++pass) {
+    auto descriptorSet = pass == 0 ? m_skinningDescriptorSets[imageIndex] : m_compareDescriptorSets[imageIndex];
+    uint32_t method = m_skinningMethod;
+    float translationX = 0.0f;
+    if (m_compareSkinning) {
+      method = pass == 0 ? SkinningMethod_Linear : SkinningMethod_DualQuaternion;
+      translationX = pass == 0 ? -CompareOffsetX : CompareOffsetX;
+    }
+    vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_COMPUTE, layout,
+      0, 1, &descriptorSet, 0, nullptr);
+    for (const auto& batch : m_model.DrawBatches) {
+      if (batch.vertexCount == 0) {
+        continue;
+      }
+      // DrawBatch ̒_ʒu̓WIgv[Ao͂͂̃f̐擪.
+      SkinningPushConstants params{
+        book_util::CheckedUint32(batch.vertexOffsetCount),
+        book_util::CheckedUint32(batch.vertexOffsetCount - m_model.poolVertexBase + pass * m_model.totalVertexCount),
+        batch.vertexCount,
+        batch.boneRemapOffset,
+        method,
+        translationX,
+      };
+      vkCmdPushConstants(command, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+      vkCmdDispatch(command, (batch.vertexCount + 63) / 64, 1, 1);
+    }
+  }
+  m_gpuTimer.End(command, timer);
+
+  VkBufferMemoryBarrier barrier{
+    VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+    skinnedBuffer, 0, VK_WHOLE_SIZE,
+  };
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+    0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
 void TransformFeedbackApp::DrawModel(VkCommandBuffer command)
 {
   auto imageIndex = m_swapchain->GetCurrentBufferIndex();
+  if (m_mode == DrawMode_Compute) {
+    // XLjOς݂̒_̃CfbNXŕ`悷.
+    auto timer = m_gpuTimer.Begin(command, DrawTimer);
+    auto skinnedBuffer = m_model.extraBuffers["skinnedBuffer"];
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command, 0, 1, &skinnedBuffer.buffer, offsets);
+    vkCmdBindIndexBuffer(command, m_model.Indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[CombinedBufferDrawPipeline]);
+    auto layout = GetPipelineLayout("u3t1");
+    const uint32_t passCount = m_compareSkinning ? 2 : 1;
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+      for (auto& batch : m_model.DrawBatches) {
+        vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+          0, 1, &batch.descriptorSets[imageIndex], 0, nullptr);
+        vkCmdDrawIndexed(command, batch.indexCount, 1, batch.GetFirstIndex(),
+          book_util::CheckedInt32(int64_t(batch.vertexOffsetCount - m_model.poolVertexBase + pass * m_model.totalVertexCount)), 0);
+      }
+    }
+    m_gpuTimer.End(command, timer);
+    return;
+  }
+
+  if (m_reuseSkinnedVertices) {
+    // OLv` xfbBuffer ̂܂ܕ`. vt@Cɂ͋̋ԂƂĎc.
+    m_gpuTimer.End(command, m_gpuTimer.Begin(command, SkinningTimer));
+  } else {
+    CaptureSkinnedVertices(command);
+  }
+
+  // o͂ꂽobt@gĕ`悷.
+  auto layout = GetPipelineLayout("u3t1");
+  auto timer = m_gpuTimer.Begin(command, DrawTimer);
+  {
+    auto xfbBuffer = m_model.extraBuffers["xfbBuffer"];
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command, 0, 1, &xfbBuffer.buffer, offsets);
+
+    auto pipeline = m_pipelines[CombinedBufferDrawPipeline];
+    vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    for (auto& batch : m_model.DrawBatches) {
+      std::vector<VkDescriptorSet> descriptorSets = {
+        batch.descriptorSets[imageIndex]
+      };
+
+      layout = GetPipelineLayout("u3t1");
+      vkCmdBindDescriptorSets(command,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        layout,
+        0,
+        uint32_t(descriptorSets.size()),
+        descriptorSets.data(),
+        0, nullptr);
+
+      //obt@ɂ̓gCAOXg̏Œ_f[^ł邽߁A
+      // CfbNXobt@svŕ`悷.
+      // `悷钸_ʒu͏]̃CfbNXvfƈv邽߂𗘗p.
+      // Lv`͂̃f̐擪l߂ď̂ŁAWIgv[̈ʒuv[̐擪.
+      auto firstVertex = book_util::CheckedUint32((batch.indexBufferOffset - m_model.poolIndexBase) / sizeof(uint32_t));
+      vkCmdDraw(command, batch.indexCount, 1, firstVertex, 0);
+
+    }
+  }
+  m_gpuTimer.End(command, timer);
+}
+
+void TransformFeedbackApp::CaptureSkinnedVertices(VkCommandBuffer command)
+{
   VkBuffer buffers[] = {
     m_model.Position.buffer, m_model.Normal.buffer, m_model.UV0.buffer
   };
@@ -634,33 +1173,7 @@ void TransformFeedbackApp::DrawModel(VkCommandBuffer command)
     vkCmdBindVertexBuffers(command, 3, _countof(buffers), buffers, offsets);
   }
 
-  for (auto& batch : m_model.DrawBatches) {
-    const auto& material = m_model.materials[batch.materialIndex];
-    ModelMeshParameters meshParameters{};
-    meshParameters.mtxWorld = glm::mat4(1.0f);
-    meshParameters.diffuse = glm::vec4(material.diffuse, material.shininess);
-    meshParameters.ambient = glm::vec4(material.ambient, 0);
-
-    WriteToHostVisibleMemory(
-      batch.modelMeshParameterUBO[imageIndex].memory,
-      sizeof(meshParameters),
-      &meshParameters);
-
-    std::vector<glm::mat4> matrices;
-    matrices.reserve(batch.boneList2.size());
-    // {[}gNXobg̏.
-    for (auto bone : batch.boneList2) {
-      auto mtx = m_model.invGlobalTransform * bone->worldTransform  * bone->offsetMatrix;
-      matrices.push_back(mtx); 
-    }
-
-    WriteToHostVisibleMemory(
-      batch.boneMatrixPalette[imageIndex].memory,
-      sizeof(glm::mat4) * matrices.size(),
-      matrices.data()
-    );
-  }
-
+  auto imageIndex = m_swapchain->GetCurrentBufferIndex();
   auto layout = m_model.pipelineLayout;
   if (m_mode == DrawMode_GS_XFB) {
     auto pipeline = m_pipelines[GeometryShaderXfbPipeline];
@@ -672,6 +1185,7 @@ void TransformFeedbackApp::DrawModel(VkCommandBuffer command)
     vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
   }
 
+  auto timer = m_gpuTimer.Begin(command, SkinningTimer);
   {
     // gXtH[tB[hobNŒ_f[^Lv`ݒ.
     auto xfbBuffer = m_model.extraBuffers["xfbBuffer"];
@@ -701,7 +1215,7 @@ void TransformFeedbackApp::DrawModel(VkCommandBuffer command)
       uint32_t(descriptorSets.size()),
       descriptorSets.data(),
       0, nullptr);
-    vkCmdDrawIndexed(command, batch.indexCount, 1, batch.indexOffsetCount, batch.vertexOffsetCount, 0);
+    vkCmdDrawIndexed(command, batch.indexCount, 1, batch.GetFirstIndex(), batch.GetVertexOffset(), 0);
   }
 
   // gXtH[tB[hobN~.
@@ -710,37 +1224,7 @@ void TransformFeedbackApp::DrawModel(VkCommandBuffer command)
     VkDeviceSize countBufferOffsets[] = { 0 };
     _vkCmdEndTransformFeedbackEXT(command, 0, _countof(countBufferOffsets), &xfbCountBuffer.buffer, countBufferOffsets);
   }
-
-  // o͂ꂽobt@gĕ`悷.
-  {
-    auto xfbBuffer = m_model.extraBuffers["xfbBuffer"];
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(command, 0, 1, &xfbBuffer.buffer, offsets);
-
-    auto pipeline = m_pipelines[CombinedBufferDrawPipeline];
-    vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-    for (auto& batch : m_model.DrawBatches) {
-      std::vector<VkDescriptorSet> descriptorSets = {
-        batch.descriptorSets[imageIndex]
-      };
-
-      layout = GetPipelineLayout("u3t1");
-      vkCmdBindDescriptorSets(command,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        layout,
-        0,
-        uint32_t(descriptorSets.size()),
-        descriptorSets.data(),
-        0, nullptr);
-
-      //obt@ɂ̓gCAOXg̏Œ_f[^ł邽߁A
-      // CfbNXobt@svŕ`悷.
-      // `悷钸_ʒu͏]̃CfbNXvfƈv邽߂𗘗p.
-      vkCmdDraw(command, batch.indexCount, 1, batch.indexOffsetCount, 0);
-
-    }
-  }
+  m_gpuTimer.End(command, timer);
 }
 
 void TransformFeedbackApp::CreateSampleLayouts()
@@ -780,7 +1264,8 @@ void TransformFeedbackApp::CreateSampleLayouts()
   dsLayoutBindings = {
     { DS_SCENE_UNIFORM, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, },
     { DS_MODEL_UNIFORM, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, },
-    { DS_BONE_UNIFORM, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT },
+    { DS_BONE_PALETTE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT },
+    { DS_BONE_REMAP, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT },
     { DS_MATERIAL_ALBEDO, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, },
   };
   dsLayoutCI.pBindings = dsLayoutBindings.data();
@@ -796,4 +1281,499 @@ void TransformFeedbackApp::CreateSampleLayouts()
   result = vkCreatePipelineLayout(m_device, &layoutCI, nullptr, &layout);
   ThrowIfFailed(result, "vkCreatePipelineLayout Failed(u3t1).");
   RegisterLayout("u3t1", layout); layout = VK_NULL_HANDLE;
+
+  // QO`p. u3t1 ɃCX^X̔zuƍĐԂ SSBO 𑫂.
+  dsLayoutBindings = {
+    { DS_SCENE_UNIFORM, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, },
+    { DS_MODEL_UNIFORM, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, },
+    { DS_BONE_PALETTE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT },
+    { DS_BONE_REMAP, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT },
+    { DS_CROWD_INSTANCES, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT },
+    { DS_MATERIAL_ALBEDO, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, },
+  };
+  dsLayoutCI.pBindings = dsLayoutBindings.data();
+  dsLayoutCI.bindingCount = uint32_t(dsLayoutBindings.size());
+  result = vkCreateDescriptorSetLayout(m_device, &dsLayoutCI, nullptr, &dsLayout);
+  ThrowIfFailed(result, "vkCreateDescriptorSetLayout Failed (crowd).");
+  RegisterLayout("crowd", dsLayout); dsLayout = VK_NULL_HANDLE;
+
+  dsLayout = GetDescriptorSetLayout("crowd");
+  layoutCI.setLayoutCount = 1;
+  layoutCI.pSetLayouts = &dsLayout;
+  result = vkCreatePipelineLayout(m_device, &layoutCI, nullptr, &layout);
+  ThrowIfFailed(result, "vkCreatePipelineLayout Failed(crowd).");
+  RegisterLayout("crowd", layout); layout = VK_NULL_HANDLE;
+
+  // Rs[gXLjOp. ͂̒_Xg[Əo̓obt@ SSBO ƂĈ.
+  dsLayoutBindings = {
+    { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+    { 7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, },
+  };
+  dsLayoutCI.pBindings = dsLayoutBindings.data();
+  dsLayoutCI.bindingCount = uint32_t(dsLayoutBindings.size());
+  result = vkCreateDescriptorSetLayout(m_device, &dsLayoutCI, nullptr, &dsLayout);
+  ThrowIfFailed(result, "vkCreateDescriptorSetLayout Failed (skinning).");
+  RegisterLayout("skinning", dsLayout); dsLayout = VK_NULL_HANDLE;
+
+  VkPushConstantRange pushConstantRange{
+    VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SkinningPushConstants)
+  };
+  dsLayout = GetDescriptorSetLayout("skinning");
+  layoutCI.setLayoutCount = 1;
+  layoutCI.pSetLayouts = &dsLayout;
+  layoutCI.pushConstantRangeCount = 1;
+  layoutCI.pPushConstantRanges = &pushConstantRange;
+  result = vkCreatePipelineLayout(m_device, &layoutCI, nullptr, &layout);
+  ThrowIfFailed(result, "vkCreatePipelineLayout Failed(skinning).");
+  RegisterLayout("skinning", layout); layout = VK_NULL_HANDLE;
+}
+
+void TransformFeedbackApp::UpdateSkinningBenchmark()
+{
+  // ؂ւ͑Õ[ȟvlĉœǂݎ̂Ă.
+  const int WarmupFrames = 60;
+  const int MeasureFrames = 240;
+  auto& bench = m_skinningBenchmark;
+  if (!bench.running || m_mode != bench.mode || m_skinningMethod != bench.method) {
+    return;
+  }
+  bench.frame++;
+  if (bench.frame <= WarmupFrames) {
+    return;
+  }
+  bench.skinningMs[bench.mode][bench.method] += m_gpuTimer.GetLastMs(SkinningTimer) / MeasureFrames;
+  bench.drawMs[bench.mode][bench.method] += m_gpuTimer.GetLastMs(DrawTimer) / MeasureFrames;
+  // CPU ̃pbg\z͕`惂[hɂȂ̂ŁAS[h̕ςɂ.
+  bench.paletteMicroseconds[bench.method] += m_paletteLastMicroseconds / MeasureFrames;
+  bench.paletteBytes[bench.method] = m_paletteBytes;
+  if (bench.frame < WarmupFrames + MeasureFrames) {
+    return;
+  }
+
+  bench.frame = 0;
+  bench.method++;
+  if (bench.method >= SkinningMethod_Count) {
+    bench.method = 0;
+    bench.mode++;
+  }
+  if (bench.mode < DrawMode_Count) {
+    m_mode = DrawMode(bench.mode);
+    m_skinningMethod = SkinningMethod(bench.method);
+    m_gpuTimer.ResetAverage();
+    return;
+  }
+  bench.running = false;
+  bench.hasResult = true;
+  bench.mode = 0;
+  bench.method = 0;
+  m_mode = bench.restoreMode;
+  m_skinningMethod = bench.restoreMethod;
+  m_compareSkinning = bench.restoreCompare;
+  m_gpuTimer.ResetAverage();
+
+  const int measuredModes = m_xfbSupported ? DrawMode_Count : 1;
+  for (auto& us : bench.paletteMicroseconds) {
+    us /= measuredModes;
+  }
+
+  const char* modeNames[] = { "GS (XFB)", "VS (XFB)", "Compute" };
+  const char* methodNames[] = { "Linear", "DualQuat" };
+  std::stringstream ss;
+  ss << "[Skinning Benchmark] " << m_model.name << " (" << m_model.totalVertexCount << " vertices, "
+    << m_model.skeletonNodes.size() << " bones)" << std::endl;
+  for (int i = 0; i < DrawMode_Count; ++i) {
+    if (!m_xfbSupported && i != DrawMode_Compute) {
+      continue;
+    }
+    for (int m = 0; m < SkinningMethod_Count; ++m) {
+      ss << "  " << modeNames[i] << " " << methodNames[m] << ": Skinning " << bench.skinningMs[i][m]
+        << " ms, Draw " << bench.drawMs[i][m] << " ms" << std::endl;
+    }
+  }
+  for (int m = 0; m < SkinningMethod_Count; ++m) {
+    ss << "  " << methodNames[m] << " palette: " << bench.paletteBytes[m] << " bytes/frame, "
+      << bench.paletteMicroseconds[m] << " us (CPU)" << std::endl;
+  }
+  OutputDebugStringA(ss.str().c_str());
+}
+
+void TransformFeedbackApp::PrepareCrowd()
+{
+  if (!m_crowdPalettes.empty() || m_model.skeletonNodes.empty()) {
+    return;
+  }
+  auto imageCount = m_swapchain->GetImageCount();
+  const auto boneCount = m_model.skeletonNodes.size();
+  const auto nodeCount = m_pose.GetNodeCount();
+
+  // pbg͑傫 (s) ̔zuŊmۂāAXLjO؂ւĂ蒼Ȃ.
+  m_crowdPalettes = CreateStorageBuffers(
+    book_util::CheckedBufferSize(uint64_t(boneCount) * MaxCrowdInstances, sizeof(glm::mat4)), imageCount);
+  m_crowdInstanceBuffers = CreateStorageBuffers(sizeof(CrowdInstance) * MaxCrowdInstances, imageCount);
+
+  m_crowdBindLocals.resize(nodeCount);
+  for (uint32_t n = 0; n < nodeCount; ++n) {
+    m_crowdBindLocals[n] = animation::ComposeMatrix(m_pose.bindTranslations[n], m_pose.bindRotations[n], m_pose.bindScales[n]);
+  }
+
+  auto dsLayout = GetDescriptorSetLayout("crowd");
+  m_crowdDescriptorSets.resize(imageCount);
+  for (uint32_t j = 0; j < imageCount; ++j) {
+    auto& sets = m_crowdDescriptorSets[j];
+    sets.resize(m_model.DrawBatches.size());
+    for (size_t i = 0; i < sets.size(); ++i) {
+      const auto& batch = m_model.DrawBatches[i];
+      const auto& material = m_model.materials[batch.materialIndex];
+      auto descriptorSet = AllocateDescriptorSet(dsLayout);
+      sets[i] = descriptorSet;
+
+      VkDescriptorBufferInfo sceneUniformUBO{ m_uniformBuffers[j].buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo modelUniformUBO{ batch.modelMeshParameterUBO[j].buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo bonePalette{ m_crowdPalettes[j].buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo boneRemap{ m_model.BoneRemap.buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorBufferInfo instances{ m_crowdInstanceBuffers[j].buffer, 0, VK_WHOLE_SIZE };
+      VkDescriptorImageInfo modelTexture{};
+      modelTexture.sampler = m_sampler;
+      modelTexture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      modelTexture.imageView = material.albedo.view;
+
+      VkWriteDescriptorSet writes[] = {
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_SCENE_UNIFORM, &sceneUniformUBO),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_MODEL_UNIFORM, &modelUniformUBO),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_BONE_PALETTE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bonePalette),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_BONE_REMAP, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &boneRemap),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_CROWD_INSTANCES, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instances),
+        book_util::CreateWriteDescriptorSet(descriptorSet, DS_MATERIAL_ALBEDO, &modelTexture),
+      };
+      vkUpdateDescriptorSets(m_device, _countof(writes), writes, 0, nullptr);
+    }
+  }
+
+  m_crowdThreadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), 8u));
+  m_crowdWorkers.resize(m_crowdThreadCount);
+  for (auto& worker : m_crowdWorkers) {
+    worker.poses.assign(CrowdSampleChunk, m_pose);
+    worker.sampleTimes.resize(CrowdSampleChunk);
+    worker.worldMatrices.resize(nodeCount);
+  }
+  // [J[ [0]  UpdateCrowd Ă񂾃Xbh󂯎̂ŁAc̕.
+  for (uint32_t t = 1; t < m_crowdThreadCount; ++t) {
+    m_crowdThreads.emplace_back(&TransformFeedbackApp::CrowdWorkerLoop, this, t);
+  }
+  ResetCrowdAgents();
+
+  std::stringstream ss;
+  ss << "[Crowd] " << MaxCrowdInstances << " instances max, " << boneCount << " bones, "
+    << m_crowdPalettes[0].size * imageCount / 1024 << " KB palette, " << m_crowdThreadCount << " threads" << std::endl;
+  OutputDebugStringA(ss.str().c_str());
+}
+
+void TransformFeedbackApp::ResetCrowdAgents()
+{
+  const auto count = uint32_t(m_crowdCount);
+  const auto clipCount = uint32_t(m_clips.size());
+  m_crowdClips.resize(count);
+  m_crowdTimes.resize(count);
+  m_crowdSpeeds.resize(count);
+  m_crowdCursors.assign(count, animation::AnimationCursor{});
+  if (clipCount == 0) {
+    return;
+  }
+
+  // NbṽG[WFgAāA܂Ƃ߂ăTvł悤ɂ.
+  // ĐʒuƑ͂΂邪AlȂ疈񓯂тɂȂ悤ɃV[hŒ肷.
+  std::mt19937 rnd(count);
+  std::uniform_real_distribution<float> phase(0.0f, 1.0f);
+  std::uniform_real_distribution<float> speed(0.8f, 1.2f);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto clip = uint32_t(uint64_t(i) * clipCount / count);
+    m_crowdClips[i] = clip;
+    m_crowdTimes[i] = phase(rnd) * m_clips[clip].duration;
+    m_crowdSpeeds[i] = speed(rnd);
+  }
+}
+
+void TransformFeedbackApp::UpdateCrowd()
+{
+  if (m_crowdPalettes.empty() || m_clips.empty()) {
+    return;
+  }
+  if (m_crowdClips.size() != size_t(m_crowdCount)) {
+    ResetCrowdAgents();
+  }
+  using Clock = std::chrono::high_resolution_clock;
+  auto start = Clock::now();
+
+  auto imageIndex = m_swapchain->GetCurrentBufferIndex();
+  const auto count = uint32_t(m_crowdCount);
+  const auto method = m_skinningMethod;
+  const auto paletteStride = GetBonePaletteStride(method) * m_model.skeletonNodes.size();
+  const float deltaTime = m_playAnimation ? float(GetFrameDeltaTime()) * m_animationSpeed : 0.0f;
+  const auto gridSize = uint32_t(std::ceil(std::sqrt(float(count))));
+
+  auto paletteMemory = m_crowdPalettes[imageIndex].memory;
+  auto instanceMemory = m_crowdInstanceBuffers[imageIndex].memory;
+  void* p = nullptr;
+  vkMapMemory(m_device, paletteMemory, 0, VK_WHOLE_SIZE, 0, &p);
+  m_crowdFrameParams.palette = static_cast<uint8_t*>(p);
+  vkMapMemory(m_device, instanceMemory, 0, VK_WHOLE_SIZE, 0, &p);
+  m_crowdFrameParams.instances = static_cast<CrowdInstance*>(p);
+  m_crowdFrameParams.paletteStride = paletteStride;
+  m_crowdFrameParams.method = method;
+  m_crowdFrameParams.deltaTime = deltaTime;
+  m_crowdFrameParams.gridSize = gridSize;
+
+  // ͈͂Uă[J[NA擪͈̔͂͌ĂяõXbhŏ.
+  const auto threadCount = std::max(1u, std::min(m_crowdThreadCount, count));
+  const auto perThread = (count + threadCount - 1) / threadCount;
+  for (uint32_t t = 0; t < m_crowdThreadCount; ++t) {
+    auto& worker = m_crowdWorkers[t];
+    worker.begin = std::min(count, perThread * t);
+    worker.end = t < threadCount ? std::min(count, worker.begin + perThread) : worker.begin;
+  }
+  if (!m_crowdThreads.empty()) {
+    std::lock_guard<std::mutex> lock(m_crowdMutex);
+    m_crowdPending = uint32_t(m_crowdThreads.size());
+    m_crowdFrame++;
+  }
+  m_crowdWake.notify_all();
+  UpdateCrowdRange(0, m_crowdWorkers[0].begin, m_crowdWorkers[0].end);
+  {
+    std::unique_lock<std::mutex> lock(m_crowdMutex);
+    m_crowdDone.wait(lock, [this] { return m_crowdPending == 0; });
+  }
+
+  VkMappedMemoryRange ranges[2]{};
+  for (auto& range : ranges) {
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.offset = 0;
+    range.size = VK_WHOLE_SIZE;
+  }
+  ranges[0].memory = paletteMemory;
+  ranges[1].memory = instanceMemory;
+  vkFlushMappedMemoryRanges(m_device, _countof(ranges), ranges);
+  vkUnmapMemory(m_device, paletteMemory);
+  vkUnmapMemory(m_device, instanceMemory);
+
+  auto microseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  m_crowdUpdateMicroseconds += (microseconds - m_crowdUpdateMicroseconds) * 0.05;
+}
+
+void TransformFeedbackApp::UpdateCrowdRange(uint32_t workerIndex, uint32_t begin, uint32_t end)
+{
+  auto& worker = m_crowdWorkers[workerIndex];
+  const auto& frame = m_crowdFrameParams;
+  while (begin < end) {
+    // Nbv͈͂ CrowdSampleChunk l܂Ƃ߂ăTv.
+    const auto clip = m_crowdClips[begin];
+    auto runEnd = begin + 1;
+    while (runEnd < end && runEnd - begin < CrowdSampleChunk && m_crowdClips[runEnd] == clip) {
+      ++runEnd;
+    }
+    const auto runCount = runEnd - begin;
+    for (auto i = begin; i < runEnd; ++i) {
+      m_crowdTimes[i] = animation::WrapTime(m_clips[clip], m_crowdTimes[i] + frame.deltaTime * m_crowdSpeeds[i]);
+    }
+    if (m_useCompressedClips) {
+      for (uint32_t i = 0; i < runCount; ++i) {
+        animation::SampleClip(m_compressedClips[clip], m_crowdTimes[begin + i], m_crowdCursors[begin + i], worker.poses[i]);
+      }
+    } else {
+      animation::SampleClipBatch(m_clips[clip], &m_crowdTimes[begin], &m_crowdCursors[begin], worker.poses.data(), runCount, worker.sampleTimes.data());
+    }
+
+    for (uint32_t i = 0; i < runCount; ++i) {
+      const auto index = begin + i;
+      animation::ComputeWorldMatrices(worker.poses[i], m_model.nodes, m_crowdBindLocals.data(), worker.worldMatrices.data());
+      ComposeBonePalette(m_model, worker.worldMatrices.data(), frame.method, frame.palette + frame.paletteStride * index);
+
+      // _擪̒ɂāA֊iqɕׂ.
+      auto& instance = frame.instances[index];
+      float x = (float(index % frame.gridSize) - (frame.gridSize - 1) * 0.5f) * CrowdSpacing;
+      float z = -float(index / frame.gridSize) * CrowdSpacing;
+      instance.world = glm::translate(glm::mat4(1.0f), vec3(x, 0.0f, z));
+      instance.clip = clip;
+      instance.time = m_crowdTimes[index];
+    }
+    begin = runEnd;
+  }
+}
+
+void TransformFeedbackApp::CrowdWorkerLoop(uint32_t workerIndex)
+{
+  uint64_t frame = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_crowdMutex);
+      m_crowdWake.wait(lock, [&] { return m_crowdQuit || m_crowdFrame != frame; });
+      if (m_crowdQuit) {
+        return;
+      }
+      frame = m_crowdFrame;
+    }
+    const auto& worker = m_crowdWorkers[workerIndex];
+    UpdateCrowdRange(workerIndex, worker.begin, worker.end);
+    std::lock_guard<std::mutex> lock(m_crowdMutex);
+    if (--m_crowdPending == 0) {
+      m_crowdDone.notify_one();
+    }
+  }
+}
+
+void TransformFeedbackApp::StopCrowdWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_crowdMutex);
+    m_crowdQuit = true;
+  }
+  m_crowdWake.notify_all();
+  for (auto& th : m_crowdThreads) {
+    th.join();
+  }
+  m_crowdThreads.clear();
+  m_crowdQuit = false;
+}
+
+void TransformFeedbackApp::DrawCrowd(VkCommandBuffer command)
+{
+  if (m_crowdDescriptorSets.empty()) {
+    return;
+  }
+  auto imageIndex = m_swapchain->GetCurrentBufferIndex();
+  VkBuffer buffers[] = {
+    m_model.Position.buffer, m_model.Normal.buffer, m_model.UV0.buffer,
+    m_model.BoneIndices.buffer, m_model.BoneWeights.buffer,
+  };
+  VkDeviceSize offsets[] = { 0, 0, 0, 0, 0 };
+  vkCmdBindVertexBuffers(command, 0, _countof(buffers), buffers, offsets);
+  vkCmdBindIndexBuffer(command, m_model.Indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+  vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[CrowdDrawPipeline]);
+
+  // XLjO͒_VF[_[ōŝŁA`̎ԂɊ܂܂.
+  // `R}h̐͐lɂ炸 DrawBatch ̐ɂȂ.
+  auto timer = m_gpuTimer.Begin(command, DrawTimer);
+  auto layout = GetPipelineLayout("crowd");
+  const auto& sets = m_crowdDescriptorSets[imageIndex];
+  for (size_t i = 0; i < m_model.DrawBatches.size(); ++i) {
+    const auto& batch = m_model.DrawBatches[i];
+    vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+      0, 1, &sets[i], 0, nullptr);
+    vkCmdDrawIndexed(command, batch.indexCount, uint32_t(m_crowdCount), batch.GetFirstIndex(), batch.GetVertexOffset(), 0);
+  }
+  m_gpuTimer.End(command, timer);
+}
+
+void TransformFeedbackApp::RunNodeHierarchyBenchmark()
+{
+  const uint32_t boneCount = 1024;
+  const int iterations = 2000;
+
+  // ȑO Node Ɠ\̖ (q shared_ptr ŎAċAōXV).
+  struct TreeNode {
+    std::vector<std::shared_ptr<TreeNode>> children;
+    glm::mat4 transform;
+    glm::mat4 worldTransform = glm::mat4(1.0f);
+    glm::mat4 offsetMatrix = glm::mat4(1.0f);
+    std::string name;
+
+    void UpdateMatrices(const glm::mat4& mtxParent)
+    {
+      worldTransform = mtxParent * transform;
+      for (auto& c : children) {
+        c->UpdateMatrices(worldTransform);
+      }
+    }
+  };
+
+  // e𒼑Ô̃m[hIŁArŵ悤Ȓƕ.
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> angle(-0.3f, 0.3f);
+  NodeHierarchy flat;
+  std::vector<std::shared_ptr<TreeNode>> treeNodes;
+  for (uint32_t i = 0; i < boneCount; ++i) {
+    uint32_t parent = NodeHierarchy::InvalidIndex;
+    if (i > 0) {
+      parent = (rng() % 4 == 0) ? uint32_t(rng() % i) : i - 1;
+    }
+    auto local = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.0f)) *
+      glm::rotate(glm::mat4(1.0f), angle(rng), glm::normalize(glm::vec3(1.0f, 0.5f, 0.25f)));
+    auto name = "bone" + std::to_string(i);
+    flat.AddNode(name, parent, local);
+
+    auto node = std::make_shared<TreeNode>();
+    node->transform = local;
+    node->name = name;
+    if (parent != NodeHierarchy::InvalidIndex) {
+      treeNodes[parent]->children.push_back(node);
+    }
+    treeNodes.push_back(node);
+  }
+
+  using Clock = std::chrono::high_resolution_clock;
+  auto toMicroseconds = [&](Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count() / iterations;
+  };
+  // œKŏȂ悤ɌʂWvĂ.
+  float checksum = 0.0f;
+
+  auto start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    treeNodes[0]->UpdateMatrices(glm::mat4(1.0f));
+    checksum += treeNodes[boneCount - 1]->worldTransform[3][1];
+  }
+  auto treeTime = Clock::now() - start;
+
+  start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    flat.MarkAllDirty();
+    flat.UpdateWorldMatrices();
+    checksum += flat.GetWorldMatrix(boneCount - 1)[3][1];
+  }
+  auto flatTime = Clock::now() - start;
+
+  // Ō̃m[h͕K[Ȃ̂ŁA̎pςƂ 1 m[h̍XVōς.
+  const uint32_t leaf = boneCount - 1;
+  const auto leafLocal = flat.GetLocalMatrix(leaf);
+  uint32_t partialUpdated = 0;
+  start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    flat.SetLocalMatrix(leaf, leafLocal);
+    partialUpdated = flat.UpdateWorldMatrices();
+    checksum += flat.GetWorldMatrix(leaf)[3][1];
+  }
+  auto partialTime = Clock::now() - start;
+
+  // œʂɂȂĂ邩.
+  float maxError = 0.0f;
+  for (uint32_t i = 0; i < boneCount; ++i) {
+    const auto& a = flat.GetWorldMatrix(i);
+    const auto& b = treeNodes[i]->worldTransform;
+    for (int c = 0; c < 4; ++c) {
+      for (int r = 0; r < 4; ++r) {
+        maxError = std::max(maxError, std::abs(a[c][r] - b[c][r]));
+      }
+    }
+  }
+
+  auto& result = m_hierarchyBenchmark;
+  result.boneCount = boneCount;
+  result.treeMicroseconds = toMicroseconds(treeTime);
+  result.flatMicroseconds = toMicroseconds(flatTime);
+  result.partialMicroseconds = toMicroseconds(partialTime);
+  result.partialUpdatedNodes = partialUpdated;
+
+  std::stringstream ss;
+  ss << "[NodeHierarchy] " << boneCount << " bones, " << iterations << " iterations" << std::endl;
+  ss << "  shared_ptr tree : " << result.treeMicroseconds << " us/update" << std::endl;
+  ss << "  flat (all)      : " << result.flatMicroseconds << " us/update ("
+    << (result.flatMicroseconds > 0.0 ? result.treeMicroseconds / result.flatMicroseconds : 0.0) << "x)" << std::endl;
+  ss << "  flat (1 leaf)   : " << result.partialMicroseconds << " us/update, " << partialUpdated << " nodes" << std::endl;
+  ss << "  max error " << maxError << ", checksum " << checksum << std::endl;
+  OutputDebugStringA(ss.str().c_str());
 }
@@ -2,6 +2,11 @@
 #include "VulkanAppBase.h"
 #include <glm/glm.hpp>
 #include "Camera.h"
+#include "GpuTimer.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 class TransformFeedbackApp : public VulkanAppBase
 {
@@ -37,6 +42,39 @@ private:
   void RenderHUD(VkCommandBuffer command);
 
   void DrawModel(VkCommandBuffer command);
+
+  // f̃{[spbg DrawBatch Ƃ̃bVp[^. R}hL^̑OɌĂ.
+  void UpdateBonePalettes();
+  // Rs[gVF[_[ŃXLjO skinnedBuffer ɏo. _[pX̊OŌĂ.
+  void DispatchSkinning(VkCommandBuffer command);
+  // GS/VS ̃gXtH[tB[hobNŃXLjOʂ xfbBuffer փLv`.
+  void CaptureSkinnedVertices(VkCommandBuffer command);
+  // pƃXLjȌOXLjOƂƔׁÃt[̃XLjO΂邩߂.
+  // updatedNodes  UpdateWorldMatrices ̖߂l. UpdateBonePalettes OɌĂ.
+  void UpdateSkinnedVertexCache(uint32_t updatedNodes);
+  // GS-XFB / VS-XFB / Compute Ɛ`uh / fANH[^jȊgݍ킹ɐ؂ւČv.
+  void UpdateSkinningBenchmark();
+
+  // QO`. CX^XƂ̃Aj[VԂADrawBatch Ƃ 1 ̃CX^X`őS`.
+  // ߂ėLɂƂɃCX^Xƃpbg̃obt@AfBXNv^Zbg.
+  void PrepareCrowd();
+  // i߁AXbhŃTvăCX^Xƃpbg̃obt@֏.
+  void UpdateCrowd();
+  void DrawCrowd(VkCommandBuffer command);
+  void ResetCrowdAgents();
+  // [begin, end) ̃G[WFgXV. ݐ̓G[WFgƂɕʂȂ̂ŁA͈͂𕪂΃XbhԂŋȂ.
+  void UpdateCrowdRange(uint32_t workerIndex, uint32_t begin, uint32_t end);
+  // [J[Xbh PrepareCrowd ōAt[NĔ͈͂. Cleanup ŏI.
+  void CrowdWorkerLoop(uint32_t workerIndex);
+  void StopCrowdWorkers();
+
+  // 1000 {[̍XPgŁAm[hKw̍XṼ|C^؂Ɣr.
+  void RunNodeHierarchyBenchmark();
+
+  // ĐNbvpӂ. fAj[VȂƂ͎Ƙr𓮂Nbv.
+  void PrepareAnimationClips();
+  // oߎԂi߂ 2 ̃NbvuhAm[hKw̃[Js֏.
+  void UpdateAnimation();
 private:
   ImageObject m_depthBuffer;
 
@@ -57,19 +95,30 @@ private:
   const std::string GeometryShaderXfbPipeline = "skinnedDraw";
   const std::string VertexShaderXfbSlimPipeline = "xfbVSOnly";
   const std::string CombinedBufferDrawPipeline = "CombinedBufferDraw";
+  const std::string ComputeSkinningPipeline = "computeSkinning";
+  const std::string CrowdDrawPipeline = "crowdDraw";
+
+  const std::string SkinningTimer = "Skinning";
+  const std::string DrawTimer = "Draw";
 
   enum DrawMode
   {
     DrawMode_GS_XFB,
     DrawMode_VS_XFB,
+    DrawMode_Compute,
+    DrawMode_Count,
   };
   DrawMode m_mode = DrawMode_GS_XFB;
+  // VK_EXT_transform_feedback gȂƂ̓Rs[ĝ.
+  bool m_xfbSupported = true;
 
   enum DESCRIPTORSET_BINDINGS {
     // DescriptorSet:0
     DS_SCENE_UNIFORM = 0,
     DS_MODEL_UNIFORM = 1,
-    DS_BONE_UNIFORM = 2,
+    DS_BONE_PALETTE = 2,  // fŜ̃{[s (SSBO)
+    DS_BONE_REMAP = 3,    // _̃{[ԍ -> pbg̔ԍ (SSBO)
+    DS_CROWD_INSTANCES = 4, // QÕCX^XƂ̔zuƍĐ (SSBO)
 
     DS_MATERIAL_ALBEDO = 8,
 
@@ -83,4 +132,139 @@ private:
   ModelAsset m_model;
 
   VkPipelineLayout m_pipelineLayout;
+
+  // Rs[gXLjOp̃fBXNv^Zbg [Xbv`FCC[W].
+  std::vector<VkDescriptorSet> m_skinningDescriptorSets;
+  struct SkinningPushConstants {
+    uint32_t srcVertexOffset;
+    uint32_t dstVertexOffset;
+    uint32_t vertexCount;
+    uint32_t boneRemapOffset;
+    uint32_t skinningMethod;
+    float translationX;
+  };
+
+  SkinningMethod m_skinningMethod = SkinningMethod_Linear;
+  // `uh () ƃfANH[^jI (E) ׂĕ\. Rs[g[ĥ.
+  bool m_compareSkinning = false;
+  const float CompareOffsetX = 5.0f;
+  // r\p̃fANH[^jĨpbgƁAǂރfBXNv^Zbg [Xbv`FCC[W].
+  std::vector<BufferObject> m_comparePalettes;
+  std::vector<VkDescriptorSet> m_compareDescriptorSets;
+  // 1 t[ŏ񂾃pbg̃oCgƁA̍\zɂ CPU .
+  VkDeviceSize m_paletteBytes = 0;
+  double m_paletteLastMicroseconds = 0.0;
+  double m_paletteMicroseconds = 0.0; // \p̈ړ
+
+  // XLjOʂ̎g. xfbBuffer / skinnedBuffer  1 Ȃ̂ŁAŌɏƂ̏oĂ.
+  bool m_lazySkinning = true;
+  struct SkinnedVertexCache {
+    bool valid = false;
+    uint64_t poseHash = 0;
+    DrawMode mode = DrawMode_GS_XFB;
+    SkinningMethod method = SkinningMethod_Linear;
+    bool compare = false;
+  };
+  SkinnedVertexCache m_skinnedCache;
+  bool m_reuseSkinnedVertices = false; // ̃t[̓XLjO΂
+  // \p. SkinningCacheWindow t[Ƃɔ΂񐔂Wv.
+  static const uint32_t SkinningCacheWindow = 240;
+  uint32_t m_skinningFrames = 0;
+  uint32_t m_skinningSkippedFrames = 0;
+  uint32_t m_skinningSkippedLastWindow = 0;
+
+  GpuTimer m_gpuTimer;
+  struct SkinningBenchmark {
+    bool running = false;
+    bool hasResult = false;
+    int mode = 0;
+    int method = 0;
+    int frame = 0;
+    DrawMode restoreMode = DrawMode_GS_XFB;
+    SkinningMethod restoreMethod = SkinningMethod_Linear;
+    bool restoreCompare = false;
+    double skinningMs[DrawMode_Count][SkinningMethod_Count] = {};
+    double drawMs[DrawMode_Count][SkinningMethod_Count] = {};
+    double paletteMicroseconds[SkinningMethod_Count] = {};
+    VkDeviceSize paletteBytes[SkinningMethod_Count] = {};
+  };
+  SkinningBenchmark m_skinningBenchmark;
+
+  // QO. G[WFg̓NbvƂɘA͈͂ɕׁANbv܂Ƃ߂ăTv.
+  static const uint32_t MaxCrowdInstances = 2048;
+  // 1  SampleClipBatch ł܂Ƃ߂ăTvCX^X.
+  static const uint32_t CrowdSampleChunk = 32;
+  const float CrowdSpacing = 8.0f;
+  // crowdVS  CrowdInstance (std430) Ɠzu.
+  struct CrowdInstance {
+    glm::mat4 world;
+    uint32_t clip;
+    float time;
+    uint32_t padding[2];
+  };
+  bool m_crowdEnabled = false;
+  int m_crowdCount = 1024;
+  std::vector<uint32_t> m_crowdClips;
+  std::vector<float> m_crowdTimes;
+  std::vector<float> m_crowdSpeeds;
+  std::vector<animation::AnimationCursor> m_crowdCursors;
+  // Aj[VĂȂm[h̃[Js (SŋL).
+  std::vector<glm::mat4> m_crowdBindLocals;
+  // [Xbv`FCC[W]. pbg̓CX^X x {[̏.
+  std::vector<BufferObject> m_crowdInstanceBuffers;
+  std::vector<BufferObject> m_crowdPalettes;
+  std::vector<std::vector<VkDescriptorSet>> m_crowdDescriptorSets; // [C[W][DrawBatch]
+  // XbhƂ̍Ɨ̈. pƃ[hs̓CX^XƂɎAŎg.
+  struct CrowdWorker {
+    std::vector<animation::Pose> poses; // CrowdSampleChunk 
+    std::vector<float> sampleTimes;     // CrowdSampleChunk . SampleClipBatch ̍Ɨ̈
+    std::vector<glm::mat4> worldMatrices;
+    uint32_t begin = 0, end = 0;        // ̃t[Ɏ󂯎͈
+  };
+  std::vector<CrowdWorker> m_crowdWorkers;
+  uint32_t m_crowdThreadCount = 1;
+  // m_crowdWorkers[1..] Xbh. [0]  UpdateCrowd Ă񂾃Xbh󂯎.
+  std::vector<std::thread> m_crowdThreads;
+  std::mutex m_crowdMutex;
+  std::condition_variable m_crowdWake;
+  std::condition_variable m_crowdDone;
+  uint64_t m_crowdFrame = 0;      // 烏[J[ 1 񕪏
+  uint32_t m_crowdPending = 0;    // ̃t[ŏIĂȂ[J[
+  bool m_crowdQuit = false;
+  // UpdateCrowdRange QƂ邱̃t[̏ݐƏ.
+  struct CrowdFrameParams {
+    uint8_t* palette = nullptr;
+    CrowdInstance* instances = nullptr;
+    VkDeviceSize paletteStride = 0;
+    SkinningMethod method = SkinningMethod_Linear;
+    float deltaTime = 0.0f;
+    uint32_t gridSize = 1;
+  };
+  CrowdFrameParams m_crowdFrameParams;
+  double m_crowdUpdateMicroseconds = 0.0; // \p̈ړ
+
+  struct NodeHierarchyBenchmark {
+    uint32_t boneCount = 0;
+    double treeMicroseconds = 0.0;     // shared_ptr ̖؂ċAōXV
+    double flatMicroseconds = 0.0;     // zSm[hXV
+    double partialMicroseconds = 0.0;  // [ 1 m[hύXƂ
+    uint32_t partialUpdatedNodes = 0;
+  };
+  NodeHierarchyBenchmark m_hierarchyBenchmark;
+
+  // Aj[VĐ. Nbv A  B  m_blendWeight (B ̏d) ō.
+  std::vector<AnimationClip> m_clips;
+  // m_clips k. m_useCompressedClips ̂Ƃ͂𒼐ڃTv.
+  std::vector<animation::CompressedClip> m_compressedClips;
+  bool m_useCompressedClips = false;
+  std::string m_clipNames; // ImGui::Combo p '\0' ؂ŕׂO
+  animation::Pose m_pose;
+  animation::AnimationCursor m_cursors[2];
+  float m_animationTime = 0.0f;
+  float m_animationSpeed = 1.0f;
+  float m_blendWeight = 0.0f;
+  int m_clipA = 0;
+  int m_clipB = 0;
+  bool m_playAnimation = true;
+  uint32_t m_animatedNodeCount = 0;
 };
\ No newline at end of file
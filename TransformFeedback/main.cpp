@@ -104,10 +104,19 @@ int __stdcall wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCm
   {
     VkFormat surfaceFormat = VK_FORMAT_B8G8R8A8_UNORM;
     theApp.Initialize(window, surfaceFormat, false);
+
+    LARGE_INTEGER freq, prevFrame{};
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&prevFrame);
     while (glfwWindowShouldClose(window) == GLFW_FALSE)
     {
       glfwPollEvents();
+      LARGE_INTEGER now;
+      QueryPerformanceCounter(&now);
+      auto frameDelta = double(now.QuadPart - prevFrame.QuadPart) / freq.QuadPart;
+      theApp.SetFrameDeltaTime(frameDelta);
       theApp.Render();
+      prevFrame = now;
     }
     theApp.Terminate();
   }
@@ -0,0 +1,334 @@
+#include "Animation.h"
+#include "AnimationCompression.h"
+#include <algorithm>
+#include <cmath>
+
+namespace animation
+{
+  namespace
+  {
+    // time ܂ދԂ̐擪L[Ԃ. ÖʒuO֐i߂邾ŁA߂Ƃ ([v) 擪蒼.
+    inline uint32_t SeekKey(const std::vector<float>& times, float time, uint32_t& cursor)
+    {
+      const auto count = uint32_t(times.size());
+      uint32_t k = cursor;
+      if (k >= count || times[k] > time) {
+        k = 0;
+      }
+      while (k + 1 < count && times[k + 1] <= time) {
+        ++k;
+      }
+      cursor = k;
+      return k;
+    }
+
+    inline float KeyAlpha(const std::vector<float>& times, uint32_t k, float time)
+    {
+      if (k + 1 >= times.size()) {
+        return 0.0f;
+      }
+      const float span = times[k + 1] - times[k];
+      if (span <= 0.0f) {
+        return 0.0f;
+      }
+      return std::min(std::max((time - times[k]) / span, 0.0f), 1.0f);
+    }
+
+    inline glm::vec3 SampleVector(const std::vector<float>& times, const std::vector<glm::vec3>& values, float time, uint32_t& cursor, const glm::vec3& fallback)
+    {
+      if (values.empty()) {
+        return fallback;
+      }
+      auto k = SeekKey(times, time, cursor);
+      if (k + 1 >= values.size()) {
+        return values[k];
+      }
+      return glm::mix(values[k], values[k + 1], KeyAlpha(times, k, time));
+    }
+
+    // L[͏\ɖȂ̂ slerp ł͂ȂK`Ԃg.
+    inline glm::quat Nlerp(const glm::quat& a, glm::quat b, float t)
+    {
+      if (glm::dot(a, b) < 0.0f) {
+        b = -b;
+      }
+      return glm::normalize(a * (1.0f - t) + b * t);
+    }
+
+    inline glm::quat SampleRotation(const std::vector<float>& times, const std::vector<glm::quat>& values, float time, uint32_t& cursor, const glm::quat& fallback)
+    {
+      if (values.empty()) {
+        return fallback;
+      }
+      auto k = SeekKey(times, time, cursor);
+      if (k + 1 >= values.size()) {
+        return values[k];
+      }
+      return Nlerp(values[k], values[k + 1], KeyAlpha(times, k, time));
+    }
+
+    inline void PrepareCursor(size_t channelCount, AnimationCursor& cursor)
+    {
+      if (cursor.keys.size() != channelCount * 3) {
+        cursor.keys.assign(channelCount * 3, 0);
+      }
+    }
+  }
+
+  size_t AnimationClip::GetKeyCount() const
+  {
+    size_t count = 0;
+    for (const auto& ch : channels) {
+      count += ch.positions.size() + ch.rotations.size() + ch.scales.size();
+    }
+    return count;
+  }
+
+  size_t AnimationClip::GetMemorySize() const
+  {
+    size_t size = sizeof(AnimationClip) + name.capacity();
+    for (const auto& ch : channels) {
+      size += sizeof(AnimationChannel) + ch.nodeName.capacity();
+      size += ch.positionTimes.size() * sizeof(float) + ch.positions.size() * sizeof(glm::vec3);
+      size += ch.rotationTimes.size() * sizeof(float) + ch.rotations.size() * sizeof(glm::quat);
+      size += ch.scaleTimes.size() * sizeof(float) + ch.scales.size() * sizeof(glm::vec3);
+    }
+    return size;
+  }
+
+  void Pose::Initialize(const NodeHierarchy& nodes)
+  {
+    const auto count = nodes.GetNodeCount();
+    bindTranslations.resize(count);
+    bindRotations.resize(count);
+    bindScales.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      DecomposeMatrix(nodes.GetLocalMatrix(i), bindTranslations[i], bindRotations[i], bindScales[i]);
+    }
+    translations = bindTranslations;
+    rotations = bindRotations;
+    scales = bindScales;
+    weights.assign(count, 0.0f);
+    applied.assign(count, 0);
+  }
+
+  float WrapTime(float duration, float time)
+  {
+    if (duration <= 0.0f) {
+      return 0.0f;
+    }
+    float t = std::fmod(time, duration);
+    return t < 0.0f ? t + duration : t;
+  }
+
+  float WrapTime(const AnimationClip& clip, float time)
+  {
+    return WrapTime(clip.duration, time);
+  }
+
+  void SampleClip(const AnimationClip& clip, float time, AnimationCursor& cursor, Pose& pose)
+  {
+    PrepareCursor(clip.channels.size(), cursor);
+    const float t = WrapTime(clip, time);
+    std::fill(pose.weights.begin(), pose.weights.end(), 0.0f);
+    for (size_t c = 0; c < clip.channels.size(); ++c) {
+      const auto& ch = clip.channels[c];
+      const auto node = ch.node;
+      if (node >= pose.GetNodeCount()) {
+        continue;
+      }
+      auto* keys = &cursor.keys[c * 3];
+      pose.translations[node] = SampleVector(ch.positionTimes, ch.positions, t, keys[0], pose.bindTranslations[node]);
+      pose.rotations[node] = SampleRotation(ch.rotationTimes, ch.rotations, t, keys[1], pose.bindRotations[node]);
+      pose.scales[node] = SampleVector(ch.scaleTimes, ch.scales, t, keys[2], pose.bindScales[node]);
+      pose.weights[node] = 1.0f;
+    }
+  }
+
+  void SampleBlended(const BlendLayer* layers, uint32_t layerCount, Pose& pose)
+  {
+    if (layerCount == 1 && layers[0].weight >= 1.0f) {
+      if (layers[0].compressedClip) {
+        SampleClip(*layers[0].compressedClip, layers[0].time, *layers[0].cursor, pose);
+      } else {
+        SampleClip(*layers[0].clip, layers[0].time, *layers[0].cursor, pose);
+      }
+      return;
+    }
+    const auto nodeCount = pose.GetNodeCount();
+    std::fill(pose.translations.begin(), pose.translations.end(), glm::vec3(0.0f));
+    std::fill(pose.rotations.begin(), pose.rotations.end(), glm::quat(0.0f, 0.0f, 0.0f, 0.0f));
+    std::fill(pose.scales.begin(), pose.scales.end(), glm::vec3(0.0f));
+    std::fill(pose.weights.begin(), pose.weights.end(), 0.0f);
+
+    for (uint32_t l = 0; l < layerCount; ++l) {
+      const auto& layer = layers[l];
+      if (layer.weight <= 0.0f) {
+        continue;
+      }
+      const float w = layer.weight;
+      auto accumulate = [&](uint32_t node, const glm::vec3& translation, glm::quat rotation, const glm::vec3& scale) {
+        // q  -q ͓]Ȃ̂ŁAoCh|[Y̔ɑĂ瑫.
+        if (glm::dot(rotation, pose.bindRotations[node]) < 0.0f) {
+          rotation = -rotation;
+        }
+        pose.translations[node] += translation * w;
+        pose.rotations[node] += rotation * w;
+        pose.scales[node] += scale * w;
+        pose.weights[node] += w;
+      };
+      glm::vec3 translation, scale;
+      glm::quat rotation;
+      if (layer.compressedClip) {
+        const auto& clip = *layer.compressedClip;
+        PrepareCursor(clip.channels.size(), *layer.cursor);
+        const float t = WrapTime(clip, layer.time);
+        for (size_t c = 0; c < clip.channels.size(); ++c) {
+          const auto node = clip.channels[c].node;
+          if (node >= nodeCount) {
+            continue;
+          }
+          SampleChannel(clip, c, t, &layer.cursor->keys[c * 3],
+            pose.bindTranslations[node], pose.bindRotations[node], pose.bindScales[node], translation, rotation, scale);
+          accumulate(node, translation, rotation, scale);
+        }
+        continue;
+      }
+      const auto& clip = *layer.clip;
+      PrepareCursor(clip.channels.size(), *layer.cursor);
+      const float t = WrapTime(clip, layer.time);
+      for (size_t c = 0; c < clip.channels.size(); ++c) {
+        const auto& ch = clip.channels[c];
+        const auto node = ch.node;
+        if (node >= nodeCount) {
+          continue;
+        }
+        auto* keys = &layer.cursor->keys[c * 3];
+        translation = SampleVector(ch.positionTimes, ch.positions, t, keys[0], pose.bindTranslations[node]);
+        rotation = SampleRotation(ch.rotationTimes, ch.rotations, t, keys[1], pose.bindRotations[node]);
+        scale = SampleVector(ch.scaleTimes, ch.scales, t, keys[2], pose.bindScales[node]);
+        accumulate(node, translation, rotation, scale);
+      }
+    }
+
+    for (uint32_t n = 0; n < nodeCount; ++n) {
+      float total = pose.weights[n];
+      if (total <= 0.0f) {
+        continue;
+      }
+      if (total < 1.0f) {
+        const float rest = 1.0f - total;
+        pose.translations[n] += pose.bindTranslations[n] * rest;
+        pose.rotations[n] += pose.bindRotations[n] * rest;
+        pose.scales[n] += pose.bindScales[n] * rest;
+        total = 1.0f;
+      }
+      pose.translations[n] /= total;
+      pose.scales[n] /= total;
+      pose.rotations[n] = glm::normalize(pose.rotations[n]);
+    }
+  }
+
+  void SampleClipBatch(const AnimationClip& clip, const float* times, AnimationCursor* cursors, Pose* poses, uint32_t instanceCount, float* wrappedTimes)
+  {
+    auto* wrapped = wrappedTimes;
+    for (uint32_t i = 0; i < instanceCount; ++i) {
+      PrepareCursor(clip.channels.size(), cursors[i]);
+      wrapped[i] = WrapTime(clip, times[i]);
+      std::fill(poses[i].weights.begin(), poses[i].weights.end(), 0.0f);
+    }
+    for (size_t c = 0; c < clip.channels.size(); ++c) {
+      const auto& ch = clip.channels[c];
+      const auto node = ch.node;
+      for (uint32_t i = 0; i < instanceCount; ++i) {
+        auto& pose = poses[i];
+        if (node >= pose.GetNodeCount()) {
+          continue;
+        }
+        auto* keys = &cursors[i].keys[c * 3];
+        pose.translations[node] = SampleVector(ch.positionTimes, ch.positions, wrapped[i], keys[0], pose.bindTranslations[node]);
+        pose.rotations[node] = SampleRotation(ch.rotationTimes, ch.rotations, wrapped[i], keys[1], pose.bindRotations[node]);
+        pose.scales[node] = SampleVector(ch.scaleTimes, ch.scales, wrapped[i], keys[2], pose.bindScales[node]);
+        pose.weights[node] = 1.0f;
+      }
+    }
+  }
+
+  uint32_t ApplyPose(Pose& pose, NodeHierarchy& nodes)
+  {
+    const auto count = std::min(pose.GetNodeCount(), nodes.GetNodeCount());
+    uint32_t written = 0;
+    for (uint32_t n = 0; n < count; ++n) {
+      if (pose.weights[n] > 0.0f) {
+        nodes.SetLocalMatrix(n, ComposeMatrix(pose.translations[n], pose.rotations[n], pose.scales[n]));
+        pose.applied[n] = 1;
+        written++;
+      } else if (pose.applied[n]) {
+        // O܂ŃAj[VĂm[h̓oCh|[Y֖߂.
+        nodes.SetLocalMatrix(n, ComposeMatrix(pose.bindTranslations[n], pose.bindRotations[n], pose.bindScales[n]));
+        pose.applied[n] = 0;
+        written++;
+      }
+    }
+    return written;
+  }
+
+  void ComputeWorldMatrices(const Pose& pose, const NodeHierarchy& nodes, const glm::mat4* bindLocals, glm::mat4* worldMatrices)
+  {
+    const auto count = std::min(pose.GetNodeCount(), nodes.GetNodeCount());
+    glm::mat4 local;
+    for (uint32_t n = 0; n < count; ++n) {
+      if (pose.weights[n] > 0.0f) {
+        local = ComposeMatrix(pose.translations[n], pose.rotations[n], pose.scales[n]);
+      } else {
+        local = bindLocals[n];
+      }
+      // e͕KOɂ̂ŁA擪 1 ̃[vōς.
+      auto parent = nodes.GetParent(n);
+      if (parent == NodeHierarchy::InvalidIndex) {
+        worldMatrices[n] = local;
+      } else {
+        NodeHierarchy::MultiplyMatrix(worldMatrices[parent], local, worldMatrices[n]);
+      }
+    }
+  }
+
+  void DecomposeMatrix(const glm::mat4& m, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale)
+  {
+    translation = glm::vec3(m[3]);
+    glm::vec3 axes[3] = { glm::vec3(m[0]), glm::vec3(m[1]), glm::vec3(m[2]) };
+    for (int i = 0; i < 3; ++i) {
+      scale[i] = glm::length(axes[i]);
+      axes[i] = scale[i] > 0.0f ? axes[i] / scale[i] : glm::vec3(i == 0, i == 1, i == 2);
+    }
+    glm::mat3 r(axes[0], axes[1], axes[2]);
+    // f܂ނƂ X ̃XP[𕉂ɂĉ]𐳋Kɖ߂.
+    if (glm::determinant(r) < 0.0f) {
+      scale.x = -scale.x;
+      r[0] = -r[0];
+    }
+    rotation = glm::normalize(glm::quat_cast(r));
+  }
+
+  DualQuaternion MakeDualQuaternion(const glm::mat4& m)
+  {
+    glm::vec3 translation, scale;
+    glm::quat rotation;
+    DecomposeMatrix(m, translation, rotation, scale);
+    // dual = 0.5 * t * real (t ͏̃NH[^jI).
+    DualQuaternion dq;
+    dq.real = rotation;
+    dq.dual = (glm::quat(0.0f, translation.x, translation.y, translation.z) * rotation) * 0.5f;
+    return dq;
+  }
+
+  glm::mat4 ComposeMatrix(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+  {
+    glm::mat4 m = glm::mat4_cast(rotation);
+    m[0] *= scale.x;
+    m[1] *= scale.y;
+    m[2] *= scale.z;
+    m[3] = glm::vec4(translation, 1.0f);
+    return m;
+  }
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "NodeHierarchy.h"
+
+// XP^Aj[ṼNbvƃTv[.
+// L[͎ƒlʂ̔zɎATv͑ÕL[ʒu (J[\) O֐i߂邾œ񕪒TȂ.
+// p (Pose) ̓m[hƂ TRS ޕʂ̔zŎAŌɂ܂Ƃ߂ă[Js֕ϊ.
+namespace animation
+{
+  struct CompressedClip;
+
+  // m[h 1 ̃Aj[VL[. ͕b.
+  // l̔z񂪋̗vf̓oCh|[Y̒lg.
+  struct AnimationChannel
+  {
+    std::string nodeName;
+    uint32_t node = NodeHierarchy::InvalidIndex;
+    std::vector<float> positionTimes;
+    std::vector<glm::vec3> positions;
+    std::vector<float> rotationTimes;
+    std::vector<glm::quat> rotations;
+    std::vector<float> scaleTimes;
+    std::vector<glm::vec3> scales;
+  };
+  struct AnimationClip
+  {
+    std::string name;
+    float duration = 0.0f; // b
+    std::vector<AnimationChannel> channels;
+
+    size_t GetKeyCount() const;
+    size_t GetMemorySize() const;
+  };
+
+  // Nbv 1 ĐCX^XƂ̏. `lƂɒOɎgL[̔ԍoĂ.
+  struct AnimationCursor
+  {
+    // [channel * 3 + 0/1/2] = ʒu/]/XP[̃L[ԍ.
+    std::vector<uint32_t> keys;
+  };
+
+  // m[hƂ TRS.
+  struct Pose
+  {
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    // uh̏d݂̍v. 0 ̃m[h̓Aj[VĂȂ.
+    std::vector<float> weights;
+    // `l̖vfɎgoCh|[Y.
+    std::vector<glm::vec3> bindTranslations;
+    std::vector<glm::quat> bindRotations;
+    std::vector<glm::vec3> bindScales;
+    // O ApplyPose ŏm[h. Aj[VOꂽoCh|[Y֖߂̂Ɏg.
+    std::vector<uint8_t> applied;
+
+    // m[hKw݂̌̃[JsoCh|[YƂĎ荞.
+    void Initialize(const NodeHierarchy& nodes);
+    uint32_t GetNodeCount() const { return uint32_t(weights.size()); }
+  };
+
+  struct BlendLayer
+  {
+    const AnimationClip* clip;
+    AnimationCursor* cursor;
+    float time;   // b. Nbv̒Ń[v
+    float weight;
+    // w肵Ƃ clip ̑ɈkꂽNbvTv.
+    const CompressedClip* compressedClip = nullptr;
+  };
+
+  // Nbv̒Ń[v.
+  float WrapTime(float duration, float time);
+  float WrapTime(const AnimationClip& clip, float time);
+
+  // 1 ̃NbvTv pose ㏑.
+  void SampleClip(const AnimationClip& clip, float time, AnimationCursor& cursor, Pose& pose);
+  // ̃NbvdݕtŃuh. d݂̍v 1 ɖȂm[h͎coCh|[YŖ߂.
+  void SampleBlended(const BlendLayer* layers, uint32_t layerCount, Pose& pose);
+  // Nbv𑽐̃CX^XɂăTv.
+  // `lÕ[vɂāAL[zǂޏ܂Ƃ߂.
+  // wrappedTimes  instanceCount ̍Ɨ̈ (ĂяoŎg).
+  void SampleClipBatch(const AnimationClip& clip, const float* times, AnimationCursor* cursors, Pose* poses, uint32_t instanceCount, float* wrappedTimes);
+
+  // Aj[Vꂽm[h[Js. ߂l͏m[h.
+  uint32_t ApplyPose(Pose& pose, NodeHierarchy& nodes);
+  // NodeHierarchy 𕡐ɁAp璼ڃ[hs߂ (̃CX^Xp).
+  // Aj[VĂȂm[h bindLocals g. worldMatrices ̓m[ḧ̗悪v.
+  void ComputeWorldMatrices(const Pose& pose, const NodeHierarchy& nodes, const glm::mat4* bindLocals, glm::mat4* worldMatrices);
+
+  // ]ƕsړ̕ϊ\fANH[^jI. XLjOŃuhĂ̐ςׂɂ.
+  struct DualQuaternion
+  {
+    glm::quat real;
+    glm::quat dual;
+  };
+  // s̃XP[͎̂ĂāA]ƕsړo.
+  DualQuaternion MakeDualQuaternion(const glm::mat4& m);
+
+  // s TRS ɕ (VA[͍lȂ).
+  void DecomposeMatrix(const glm::mat4& m, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale);
+  glm::mat4 ComposeMatrix(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+}
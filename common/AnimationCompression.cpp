@@ -0,0 +1,542 @@
+#include "AnimationCompression.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+namespace animation
+{
+  namespace
+  {
+    const float QuantizeMax = 65535.0f;
+    const float SmallestThreeRange = 0.70710678f; // ővfȊO̐Βl 1/sqrt(2) ȉ
+    const float SmallestThreeMax = 32767.0f;
+
+    inline uint16_t QuantizeUnorm16(float v, float minValue, float extent)
+    {
+      if (extent <= 0.0f) {
+        return 0;
+      }
+      float n = std::min(std::max((v - minValue) / extent, 0.0f), 1.0f);
+      return uint16_t(n * QuantizeMax + 0.5f);
+    }
+
+    inline glm::vec3 DequantizeVector(const uint16_t* q, const glm::vec3& minValue, const glm::vec3& extent)
+    {
+      return minValue + glm::vec3(q[0], q[1], q[2]) * (extent / QuantizeMax);
+    }
+
+    // ővf̔ԍ (2bit)  1, 2 vfڂ̍ŏʃrbgɓAc 3 vf 15bit .
+    inline void EncodeQuaternion(glm::quat q, uint16_t* out)
+    {
+      q = glm::normalize(q);
+      float c[4] = { q.x, q.y, q.z, q.w };
+      int largest = 0;
+      for (int i = 1; i < 4; ++i) {
+        if (std::fabs(c[i]) > std::fabs(c[largest])) {
+          largest = i;
+        }
+      }
+      // q  -q ͓]Ȃ̂ōővf𐳂ɂ낦Aɍς܂.
+      const float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+      uint16_t packed[3];
+      for (int i = 0, n = 0; i < 4; ++i) {
+        if (i == largest) {
+          continue;
+        }
+        float v = std::min(std::max(c[i] * sign / SmallestThreeRange, -1.0f), 1.0f);
+        packed[n++] = uint16_t((v * 0.5f + 0.5f) * SmallestThreeMax + 0.5f);
+      }
+      out[0] = uint16_t(packed[0] | ((largest >> 1) << 15));
+      out[1] = uint16_t(packed[1] | ((largest & 1) << 15));
+      out[2] = packed[2];
+    }
+
+    inline glm::quat DecodeQuaternion(const uint16_t* in)
+    {
+      const int largest = ((in[0] >> 15) << 1) | (in[1] >> 15);
+      float rest[3];
+      float sum = 0.0f;
+      for (int i = 0; i < 3; ++i) {
+        rest[i] = ((in[i] & 0x7fff) / SmallestThreeMax * 2.0f - 1.0f) * SmallestThreeRange;
+        sum += rest[i] * rest[i];
+      }
+      float c[4];
+      for (int i = 0, n = 0; i < 4; ++i) {
+        c[i] = (i == largest) ? std::sqrt(std::max(0.0f, 1.0f - sum)) : rest[n++];
+      }
+      return glm::quat(c[3], c[0], c[1], c[2]);
+    }
+
+    inline float RotationError(const glm::quat& a, const glm::quat& b)
+    {
+      float d = std::min(std::fabs(glm::dot(a, b)), 1.0f);
+      return 2.0f * std::acos(d);
+    }
+
+    inline float VectorError(const glm::vec3& a, const glm::vec3& b)
+    {
+      return glm::length(a - b);
+    }
+
+    inline glm::quat Nlerp(const glm::quat& a, glm::quat b, float t)
+    {
+      if (glm::dot(a, b) < 0.0f) {
+        b = -b;
+      }
+      return glm::normalize(a * (1.0f - t) + b * t);
+    }
+
+    // ԂōČłL[菜AcL[̔ԍԂ.
+    // Ԃ̎n_I_ 1 ΂AԂ̃L[ׂċe덷Ɏ܂ȂȂƂŋ؂.
+    template<class T, class Lerp, class Error>
+    std::vector<uint32_t> ReduceKeys(const std::vector<float>& times, const std::vector<T>& values,
+      float tolerance, uint32_t maxSpan, Lerp lerp, Error error)
+    {
+      std::vector<uint32_t> kept;
+      const auto count = uint32_t(values.size());
+      if (count == 0) {
+        return kept;
+      }
+      kept.push_back(0);
+      bool constant = true;
+      for (uint32_t k = 1; k < count && constant; ++k) {
+        constant = error(values[0], values[k]) <= tolerance;
+      }
+      if (constant) {
+        return kept;
+      }
+
+      auto spanFits = [&](uint32_t start, uint32_t end) {
+        const float span = times[end] - times[start];
+        for (uint32_t k = start + 1; k < end; ++k) {
+          float alpha = span > 0.0f ? (times[k] - times[start]) / span : 0.0f;
+          if (error(lerp(values[start], values[end], alpha), values[k]) > tolerance) {
+            return false;
+          }
+        }
+        return true;
+      };
+      uint32_t start = 0;
+      while (start + 1 < count) {
+        uint32_t end = start + 1;
+        while (end + 1 < count && end + 1 - start <= maxSpan && spanFits(start, end + 1)) {
+          ++end;
+        }
+        kept.push_back(end);
+        start = end;
+      }
+      return kept;
+    }
+
+    inline uint16_t QuantizeTime(float time, float duration)
+    {
+      if (duration <= 0.0f) {
+        return 0;
+      }
+      float n = std::min(std::max(time / duration, 0.0f), 1.0f);
+      return uint16_t(n * QuantizeMax + 0.5f);
+    }
+
+    // tick (0..65535 ̎) ܂ދԂ̐擪L[. Animation.cpp  SeekKey ƓO֐i߂邾.
+    inline uint32_t SeekKey(const uint16_t* times, uint32_t count, float tick, uint32_t& cursor)
+    {
+      uint32_t k = cursor;
+      if (k >= count || times[k] > tick) {
+        k = 0;
+      }
+      while (k + 1 < count && times[k + 1] <= tick) {
+        ++k;
+      }
+      cursor = k;
+      return k;
+    }
+
+    inline float KeyAlpha(const uint16_t* times, uint32_t count, uint32_t k, float tick)
+    {
+      if (k + 1 >= count || times[k + 1] <= times[k]) {
+        return 0.0f;
+      }
+      return std::min(std::max((tick - times[k]) / float(times[k + 1] - times[k]), 0.0f), 1.0f);
+    }
+
+    glm::vec3 SampleVectorTrack(const CompressedClip& clip, TrackType type, const CompressedTrack& track,
+      float tick, uint32_t& cursor, const glm::vec3& minValue, const glm::vec3& extent, const glm::vec3& fallback)
+    {
+      if (track.keyCount == 0) {
+        return fallback;
+      }
+      const auto* times = clip.times[type].data() + track.firstKey;
+      const auto* values = clip.values[type].data() + size_t(track.firstKey) * 3;
+      auto k = SeekKey(times, track.keyCount, tick, cursor);
+      auto a = DequantizeVector(values + k * 3, minValue, extent);
+      if (k + 1 >= track.keyCount) {
+        return a;
+      }
+      auto b = DequantizeVector(values + (k + 1) * 3, minValue, extent);
+      return glm::mix(a, b, KeyAlpha(times, track.keyCount, k, tick));
+    }
+
+    glm::quat SampleRotationTrack(const CompressedClip& clip, const CompressedTrack& track, float tick, uint32_t& cursor, const glm::quat& fallback)
+    {
+      if (track.keyCount == 0) {
+        return fallback;
+      }
+      const auto* times = clip.times[TrackType_Rotation].data() + track.firstKey;
+      const auto* values = clip.values[TrackType_Rotation].data() + size_t(track.firstKey) * 3;
+      auto k = SeekKey(times, track.keyCount, tick, cursor);
+      auto a = DecodeQuaternion(values + k * 3);
+      if (k + 1 >= track.keyCount) {
+        return a;
+      }
+      auto b = DecodeQuaternion(values + (k + 1) * 3);
+      return Nlerp(a, b, KeyAlpha(times, track.keyCount, k, tick));
+    }
+
+    inline float TimeToTick(const CompressedClip& clip, float time)
+    {
+      return clip.duration > 0.0f ? time / clip.duration * QuantizeMax : 0.0f;
+    }
+
+    void SampleChannelAtTick(const CompressedClip& clip, size_t channel, float tick, uint32_t* keys,
+      const glm::vec3& bindTranslation, const glm::quat& bindRotation, const glm::vec3& bindScale,
+      glm::vec3& translation, glm::quat& rotation, glm::vec3& scale)
+    {
+      const auto& ch = clip.channels[channel];
+      translation = SampleVectorTrack(clip, TrackType_Position, ch.tracks[TrackType_Position], tick, keys[0],
+        clip.translationMin, clip.translationExtent, bindTranslation);
+      rotation = SampleRotationTrack(clip, ch.tracks[TrackType_Rotation], tick, keys[1], bindRotation);
+      scale = SampleVectorTrack(clip, TrackType_Scale, ch.tracks[TrackType_Scale], tick, keys[2],
+        clip.scaleMin, clip.scaleExtent, bindScale);
+    }
+
+    // Xg[̔zu.
+    struct ClipChunkHeader {
+      char magic[4] = { 'A', 'N', 'M', 'C' };
+      uint32_t version = 1;
+      uint64_t bodySize = 0;  // ̃wb_[ɑ{̂̃oCg
+    };
+
+    template<class T>
+    void WritePod(std::ostream& out, const T& v)
+    {
+      out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+    template<class T>
+    bool ReadPod(std::istream& in, T& v)
+    {
+      in.read(reinterpret_cast<char*>(&v), sizeof(T));
+      return bool(in);
+    }
+    void WriteString(std::ostream& out, const std::string& s)
+    {
+      WritePod(out, uint32_t(s.size()));
+      out.write(s.data(), s.size());
+    }
+    // ݈ʒu end ܂ł̃oCg. ʒuȂƂ 0.
+    uint64_t BytesBefore(std::istream& in, std::streampos end)
+    {
+      auto pos = in.tellg();
+      if (pos == std::streampos(-1) || pos > end) {
+        return 0;
+      }
+      return uint64_t(end - pos);
+    }
+    // vf̓t@C̒lȂ̂ŁAmۂO end ܂łɎ܂邩m߂.
+    bool ReadString(std::istream& in, std::string& s, std::streampos end)
+    {
+      uint32_t length = 0;
+      if (!ReadPod(in, length) || length > BytesBefore(in, end)) {
+        return false;
+      }
+      s.resize(length);
+      in.read(&s[0], length);
+      return bool(in);
+    }
+    void WriteArray(std::ostream& out, const std::vector<uint16_t>& v)
+    {
+      WritePod(out, uint32_t(v.size()));
+      out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(uint16_t));
+    }
+    bool ReadArray(std::istream& in, std::vector<uint16_t>& v, std::streampos end)
+    {
+      uint32_t count = 0;
+      if (!ReadPod(in, count) || uint64_t(count) * sizeof(uint16_t) > BytesBefore(in, end)) {
+        return false;
+      }
+      v.resize(count);
+      in.read(reinterpret_cast<char*>(v.data()), count * sizeof(uint16_t));
+      return bool(in);
+    }
+  }
+
+  size_t CompressedClip::GetKeyCount() const
+  {
+    return times[TrackType_Position].size() + times[TrackType_Rotation].size() + times[TrackType_Scale].size();
+  }
+
+  size_t CompressedClip::GetMemorySize() const
+  {
+    size_t size = sizeof(CompressedClip) + name.capacity();
+    for (const auto& ch : channels) {
+      size += sizeof(CompressedChannel) + ch.nodeName.capacity();
+    }
+    for (int type = 0; type < TrackType_Count; ++type) {
+      size += (times[type].size() + values[type].size()) * sizeof(uint16_t);
+    }
+    return size;
+  }
+
+  CompressedClip CompressClip(const AnimationClip& clip, const CompressionSettings& settings, CompressionReport* report)
+  {
+    CompressedClip result;
+    result.name = clip.name;
+    result.duration = clip.duration;
+    result.channels.resize(clip.channels.size());
+
+    auto lerpVector = [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); };
+    auto lerpQuat = [](const glm::quat& a, const glm::quat& b, float t) { return Nlerp(a, b, t); };
+
+    // L[ԈAʎq͈͂߂.
+    std::vector<std::vector<uint32_t>> kept(clip.channels.size() * TrackType_Count);
+    std::vector<std::vector<glm::quat>> continuousRotations(clip.channels.size());
+    glm::vec3 translationMin(FLT_MAX), translationMax(-FLT_MAX);
+    glm::vec3 scaleMin(FLT_MAX), scaleMax(-FLT_MAX);
+    for (size_t c = 0; c < clip.channels.size(); ++c) {
+      const auto& ch = clip.channels[c];
+      // Ԃŉ肵Ȃ悤Aׂ荇L[̉]𓯂ɂ낦ĂԈ.
+      auto& rotations = continuousRotations[c];
+      rotations = ch.rotations;
+      for (size_t k = 1; k < rotations.size(); ++k) {
+        if (glm::dot(rotations[k - 1], rotations[k]) < 0.0f) {
+          rotations[k] = -rotations[k];
+        }
+      }
+      auto* keys = &kept[c * TrackType_Count];
+      keys[TrackType_Position] = ReduceKeys(ch.positionTimes, ch.positions, settings.translationTolerance, settings.maxKeySpan, lerpVector, VectorError);
+      keys[TrackType_Rotation] = ReduceKeys(ch.rotationTimes, rotations, settings.rotationTolerance, settings.maxKeySpan, lerpQuat, RotationError);
+      keys[TrackType_Scale] = ReduceKeys(ch.scaleTimes, ch.scales, settings.scaleTolerance, settings.maxKeySpan, lerpVector, VectorError);
+      for (auto k : keys[TrackType_Position]) {
+        translationMin = glm::min(translationMin, ch.positions[k]);
+        translationMax = glm::max(translationMax, ch.positions[k]);
+      }
+      for (auto k : keys[TrackType_Scale]) {
+        scaleMin = glm::min(scaleMin, ch.scales[k]);
+        scaleMax = glm::max(scaleMax, ch.scales[k]);
+      }
+    }
+    if (translationMin.x <= translationMax.x) {
+      result.translationMin = translationMin;
+      result.translationExtent = translationMax - translationMin;
+    }
+    if (scaleMin.x <= scaleMax.x) {
+      result.scaleMin = scaleMin;
+      result.scaleExtent = scaleMax - scaleMin;
+    }
+
+    // cL[ʎqċl߂.
+    for (size_t c = 0; c < clip.channels.size(); ++c) {
+      const auto& ch = clip.channels[c];
+      auto& dst = result.channels[c];
+      dst.nodeName = ch.nodeName;
+      dst.node = ch.node;
+      const std::vector<float>* sourceTimes[TrackType_Count] = { &ch.positionTimes, &ch.rotationTimes, &ch.scaleTimes };
+      for (int type = 0; type < TrackType_Count; ++type) {
+        const auto& keys = kept[c * TrackType_Count + type];
+        auto& times = result.times[type];
+        auto& values = result.values[type];
+        dst.tracks[type].firstKey = uint32_t(times.size());
+        dst.tracks[type].keyCount = uint32_t(keys.size());
+        for (auto k : keys) {
+          times.push_back(QuantizeTime((*sourceTimes[type])[k], clip.duration));
+          uint16_t q[3];
+          if (type == TrackType_Rotation) {
+            EncodeQuaternion(continuousRotations[c][k], q);
+          } else {
+            const auto& v = (type == TrackType_Position) ? ch.positions[k] : ch.scales[k];
+            const auto& minValue = (type == TrackType_Position) ? result.translationMin : result.scaleMin;
+            const auto& extent = (type == TrackType_Position) ? result.translationExtent : result.scaleExtent;
+            for (int i = 0; i < 3; ++i) {
+              q[i] = QuantizeUnorm16(v[i], minValue[i], extent[i]);
+            }
+          }
+          values.insert(values.end(), q, q + 3);
+        }
+      }
+    }
+
+    if (report) {
+      // ԈƗʎq̗܂߂덷ÃL[̎ňk̃NbvTvđ.
+      *report = CompressionReport{};
+      report->sourceBytes = clip.GetMemorySize();
+      report->compressedBytes = result.GetMemorySize();
+      report->channels.resize(clip.channels.size());
+      const glm::vec3 zero(0.0f);
+      const glm::quat identity(1.0f, 0.0f, 0.0f, 0.0f);
+      for (size_t c = 0; c < clip.channels.size(); ++c) {
+        const auto& ch = clip.channels[c];
+        auto& error = report->channels[c];
+        error.nodeName = ch.nodeName;
+        error.sourceKeyCount = uint32_t(ch.positions.size() + ch.rotations.size() + ch.scales.size());
+        error.keptKeyCount = 0;
+        for (const auto& track : result.channels[c].tracks) {
+          error.keptKeyCount += track.keyCount;
+        }
+        uint32_t keys[3] = {};
+        glm::vec3 t, s;
+        glm::quat r;
+        for (size_t k = 0; k < ch.positions.size(); ++k) {
+          SampleChannelAtTick(result, c, TimeToTick(result, ch.positionTimes[k]), keys, zero, identity, zero, t, r, s);
+          error.translation = std::max(error.translation, VectorError(t, ch.positions[k]));
+        }
+        for (size_t k = 0; k < ch.rotations.size(); ++k) {
+          SampleChannelAtTick(result, c, TimeToTick(result, ch.rotationTimes[k]), keys, zero, identity, zero, t, r, s);
+          error.rotation = std::max(error.rotation, RotationError(r, ch.rotations[k]));
+        }
+        for (size_t k = 0; k < ch.scales.size(); ++k) {
+          SampleChannelAtTick(result, c, TimeToTick(result, ch.scaleTimes[k]), keys, zero, identity, zero, t, r, s);
+          error.scale = std::max(error.scale, VectorError(s, ch.scales[k]));
+        }
+        report->sourceKeyCount += error.sourceKeyCount;
+        report->keptKeyCount += error.keptKeyCount;
+      }
+    }
+    return result;
+  }
+
+  float WrapTime(const CompressedClip& clip, float time)
+  {
+    return WrapTime(clip.duration, time);
+  }
+
+  void SampleChannel(const CompressedClip& clip, size_t channel, float time, uint32_t* keys,
+    const glm::vec3& bindTranslation, const glm::quat& bindRotation, const glm::vec3& bindScale,
+    glm::vec3& translation, glm::quat& rotation, glm::vec3& scale)
+  {
+    SampleChannelAtTick(clip, channel, TimeToTick(clip, time), keys,
+      bindTranslation, bindRotation, bindScale, translation, rotation, scale);
+  }
+
+  void SampleClip(const CompressedClip& clip, float time, AnimationCursor& cursor, Pose& pose)
+  {
+    if (cursor.keys.size() != clip.channels.size() * 3) {
+      cursor.keys.assign(clip.channels.size() * 3, 0);
+    }
+    const float tick = TimeToTick(clip, WrapTime(clip, time));
+    std::fill(pose.weights.begin(), pose.weights.end(), 0.0f);
+    for (size_t c = 0; c < clip.channels.size(); ++c) {
+      const auto node = clip.channels[c].node;
+      if (node >= pose.GetNodeCount()) {
+        continue;
+      }
+      SampleChannelAtTick(clip, c, tick, &cursor.keys[c * 3],
+        pose.bindTranslations[node], pose.bindRotations[node], pose.bindScales[node],
+        pose.translations[node], pose.rotations[node], pose.scales[node]);
+      pose.weights[node] = 1.0f;
+    }
+  }
+
+  bool WriteCompressedClip(std::ostream& out, const CompressedClip& clip)
+  {
+    // {̂ɑgݗĂăTCYm肳.
+    std::ostringstream body(std::ios::binary);
+    WriteString(body, clip.name);
+    WritePod(body, clip.duration);
+    WritePod(body, clip.translationMin);
+    WritePod(body, clip.translationExtent);
+    WritePod(body, clip.scaleMin);
+    WritePod(body, clip.scaleExtent);
+    WritePod(body, uint32_t(clip.channels.size()));
+    for (const auto& ch : clip.channels) {
+      WriteString(body, ch.nodeName);
+      for (const auto& track : ch.tracks) {
+        WritePod(body, track.firstKey);
+        WritePod(body, track.keyCount);
+      }
+    }
+    for (int type = 0; type < TrackType_Count; ++type) {
+      WriteArray(body, clip.times[type]);
+      WriteArray(body, clip.values[type]);
+    }
+    const auto data = body.str();
+
+    ClipChunkHeader header;
+    header.bodySize = data.size();
+    WritePod(out, header);
+    out.write(data.data(), data.size());
+    return bool(out);
+  }
+
+  bool ReadCompressedClip(std::istream& in, CompressedClip& clip)
+  {
+    ClipChunkHeader expect, header;
+    if (!ReadPod(in, header) || memcmp(header.magic, expect.magic, sizeof(header.magic)) != 0 || header.version != expect.version) {
+      return false;
+    }
+    // {̂̃TCYXg[̎cɎ܂邩m߁Aȍ~̓ǂݍ݂͈͂̔͂ɐ.
+    const auto begin = in.tellg();
+    if (begin == std::streampos(-1) || !in.seekg(0, std::ios::end)) {
+      return false;
+    }
+    const auto streamEnd = in.tellg();
+    in.seekg(begin);
+    if (!in || streamEnd < begin || header.bodySize > uint64_t(streamEnd - begin)) {
+      return false;
+    }
+    const auto end = begin + std::streamoff(header.bodySize);
+
+    clip = CompressedClip{};
+    uint32_t channelCount = 0;
+    if (!ReadString(in, clip.name, end) || !ReadPod(in, clip.duration) ||
+      !ReadPod(in, clip.translationMin) || !ReadPod(in, clip.translationExtent) ||
+      !ReadPod(in, clip.scaleMin) || !ReadPod(in, clip.scaleExtent) ||
+      !ReadPod(in, channelCount)) {
+      return false;
+    }
+    // `l 1 ͍ŒłO̒ƃgbN͈̔͂̕߂.
+    const uint64_t minChannelSize = sizeof(uint32_t) + (sizeof(CompressedTrack::firstKey) + sizeof(CompressedTrack::keyCount)) * TrackType_Count;
+    if (uint64_t(channelCount) * minChannelSize > BytesBefore(in, end)) {
+      return false;
+    }
+    clip.channels.resize(channelCount);
+    for (auto& ch : clip.channels) {
+      if (!ReadString(in, ch.nodeName, end)) {
+        return false;
+      }
+      for (auto& track : ch.tracks) {
+        if (!ReadPod(in, track.firstKey) || !ReadPod(in, track.keyCount)) {
+          return false;
+        }
+      }
+    }
+    for (int type = 0; type < TrackType_Count; ++type) {
+      if (!ReadArray(in, clip.times[type], end) || !ReadArray(in, clip.values[type], end)) {
+        return false;
+      }
+    }
+    // ꂽf[^Ŕ͈͊Oǂ܂Ȃ悤AgbN͈̔͂m߂Ă.
+    for (const auto& ch : clip.channels) {
+      for (int type = 0; type < TrackType_Count; ++type) {
+        const auto& track = ch.tracks[type];
+        if (size_t(track.firstKey) + track.keyCount > clip.times[type].size() ||
+          (size_t(track.firstKey) + track.keyCount) * 3 > clip.values[type].size()) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool SkipCompressedClip(std::istream& in)
+  {
+    ClipChunkHeader expect, header;
+    if (!ReadPod(in, header) || memcmp(header.magic, expect.magic, sizeof(header.magic)) != 0) {
+      return false;
+    }
+    in.seekg(std::streamoff(header.bodySize), std::ios::cur);
+    return bool(in);
+  }
+}
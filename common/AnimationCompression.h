@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "Animation.h"
+
+// Aj[VNbv̈k.
+//  - ԂōČłL[e덷͈̔͂ŊԈ
+//  - ̓Nbv̒ 65535  16bit
+//  - ]͍ővf 3 vf 15bit  (smallest three, 48bit)
+//  - ʒu/XP[̓NbvŜ͈̔͂ 16bit ɗʎq
+// Tv͕Kv 2 L[̏œWĴŁAWJς݂̃Nbv͍Ȃ.
+namespace animation
+{
+  enum TrackType {
+    TrackType_Position = 0,
+    TrackType_Rotation,
+    TrackType_Scale,
+    TrackType_Count,
+  };
+
+  struct CompressionSettings
+  {
+    float translationTolerance = 0.0005f; // f̒P
+    float rotationTolerance = 0.0005f;    // WA
+    float scaleTolerance = 0.0005f;
+    // 1 Ԃɂ܂Ƃ߂錳̃L[̏. Î~Ԃł̍팸̌vZʂ}.
+    uint32_t maxKeySpan = 256;
+  };
+
+  // 1 gbÑL[͈̔ (CompressedClip::times/values ̔ԍ). keyCount  0 ȂoCh|[Yg.
+  struct CompressedTrack
+  {
+    uint32_t firstKey = 0;
+    uint32_t keyCount = 0;
+  };
+  struct CompressedChannel
+  {
+    std::string nodeName;
+    uint32_t node = NodeHierarchy::InvalidIndex;
+    CompressedTrack tracks[TrackType_Count];
+  };
+  struct CompressedClip
+  {
+    std::string name;
+    float duration = 0.0f; // b
+    // ʒuƃXP[̗ʎq͈. l = min + q * extent / 65535.
+    glm::vec3 translationMin = glm::vec3(0.0f);
+    glm::vec3 translationExtent = glm::vec3(0.0f);
+    glm::vec3 scaleMin = glm::vec3(0.0f);
+    glm::vec3 scaleExtent = glm::vec3(0.0f);
+    std::vector<CompressedChannel> channels;
+    // gbN̎ނƂɑS`l̃L[ׂ. l 1 L[ 3 vf.
+    std::vector<uint16_t> times[TrackType_Count];
+    std::vector<uint16_t> values[TrackType_Count];
+
+    size_t GetKeyCount() const;
+    size_t GetMemorySize() const;
+  };
+
+  // `l ({[) Ƃ̈k. 덷͌̃L[̎ő[JԂł̍ől.
+  struct ChannelCompressionError
+  {
+    std::string nodeName;
+    uint32_t sourceKeyCount = 0;
+    uint32_t keptKeyCount = 0;
+    float translation = 0.0f;
+    float rotation = 0.0f;    // WA
+    float scale = 0.0f;
+  };
+  struct CompressionReport
+  {
+    size_t sourceBytes = 0;      // AnimationClip ̃TCY
+    size_t compressedBytes = 0;
+    uint32_t sourceKeyCount = 0;
+    uint32_t keptKeyCount = 0;
+    std::vector<ChannelCompressionError> channels;
+  };
+
+  CompressedClip CompressClip(const AnimationClip& clip, const CompressionSettings& settings, CompressionReport* report = nullptr);
+
+  float WrapTime(const CompressedClip& clip, float time);
+  // kꂽNbv̂܂܃Tv. cursor  AnimationClip Ɠg.
+  void SampleClip(const CompressedClip& clip, float time, AnimationCursor& cursor, Pose& pose);
+  // `l 1 Tv. time ̓[vς݂̕b, keys ͂̃`l̃J[\ (3 vf).
+  void SampleChannel(const CompressedClip& clip, size_t channel, float time, uint32_t* keys,
+    const glm::vec3& bindTranslation, const glm::quat& bindRotation, const glm::vec3& bindScale,
+    glm::vec3& translation, glm::quat& rotation, glm::vec3& scale);
+
+  // Xg[ւ̏o/ǂݍ. NbvƂɎʎqƃTCY擪ɒûŁA
+  // ̃Nbv𑱂ďA擪珇ɓǂނƂAsvȃNbvǂݔ΂Ƃł.
+  bool WriteCompressedClip(std::ostream& out, const CompressedClip& clip);
+  bool ReadCompressedClip(std::istream& in, CompressedClip& clip);
+  bool SkipCompressedClip(std::istream& in);
+}
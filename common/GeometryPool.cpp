@@ -0,0 +1,115 @@
+#include "GeometryPool.h"
+#include <algorithm>
+
+GeometryRangeAllocator::GeometryRangeAllocator()
+  : m_capacity(0), m_usedSize(0)
+{
+}
+
+void GeometryRangeAllocator::Reset(uint64_t capacity)
+{
+  m_capacity = capacity;
+  m_usedSize = 0;
+  m_freeRanges.clear();
+  m_allocations.clear();
+  if (capacity > 0) {
+    m_freeRanges[0] = capacity;
+  }
+}
+
+uint64_t GeometryRangeAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+  if (size == 0) {
+    return InvalidOffset;
+  }
+  for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+    auto rangeOffset = it->first;
+    auto rangeSize = it->second;
+    auto offset = (rangeOffset + alignment - 1) / alignment * alignment;
+    auto padding = offset - rangeOffset;
+    if (rangeSize < padding + size) {
+      continue;
+    }
+    m_freeRanges.erase(it);
+    auto remain = rangeSize - padding - size;
+    if (remain > 0) {
+      m_freeRanges[offset + size] = remain;
+    }
+    // 擪͉̒ɈꏏɕԂ.
+    m_allocations[offset] = Allocation{ rangeOffset, padding + size };
+    m_usedSize += padding + size;
+    return offset;
+  }
+  return InvalidOffset;
+}
+
+void GeometryRangeAllocator::Free(uint64_t offset)
+{
+  auto it = m_allocations.find(offset);
+  if (it == m_allocations.end()) {
+    return;
+  }
+  auto range = it->second;
+  m_allocations.erase(it);
+  m_usedSize -= range.rangeSize;
+  InsertFreeRange(range.rangeOffset, range.rangeSize);
+}
+
+void GeometryRangeAllocator::InsertFreeRange(uint64_t offset, uint64_t size)
+{
+  // Ő󂫗̈ƌ.
+  auto next = m_freeRanges.lower_bound(offset);
+  if (next != m_freeRanges.end() && offset + size == next->first) {
+    size += next->second;
+    next = m_freeRanges.erase(next);
+  }
+  if (next != m_freeRanges.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += size;
+      return;
+    }
+  }
+  m_freeRanges[offset] = size;
+}
+
+void GeometryRangeAllocator::Compact(std::vector<Relocation>& relocations, uint64_t alignment)
+{
+  relocations.clear();
+  std::map<uint64_t, Allocation> allocations;
+  uint64_t cursor = 0;
+  for (const auto& a : m_allocations) {
+    auto offset = a.first;
+    auto size = a.second.rangeSize - (offset - a.second.rangeOffset);
+    auto newOffset = (cursor + alignment - 1) / alignment * alignment;
+    if (newOffset != offset) {
+      relocations.push_back(Relocation{ offset, newOffset, size });
+    }
+    allocations[newOffset] = Allocation{ cursor, newOffset - cursor + size };
+    cursor = newOffset + size;
+  }
+  m_allocations.swap(allocations);
+  m_usedSize = cursor;
+  m_freeRanges.clear();
+  if (cursor < m_capacity) {
+    m_freeRanges[cursor] = m_capacity - cursor;
+  }
+}
+
+uint64_t GeometryRangeAllocator::GetLargestFreeRange() const
+{
+  uint64_t largest = 0;
+  for (const auto& r : m_freeRanges) {
+    largest = std::max(largest, r.second);
+  }
+  return largest;
+}
+
+float GeometryRangeAllocator::GetFragmentation() const
+{
+  auto freeSize = m_capacity - m_usedSize;
+  if (freeSize == 0) {
+    return 0.0f;
+  }
+  return 1.0f - float(double(GetLargestFreeRange()) / double(freeSize));
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+// WIgv[(_/CfbNX̃Kobt@)̗̈Ǘ.
+// Pʂ͌Ăяo߂ (_v[͒_ACfbNXv[̓oCg).
+// 󂫗͉̈ɗאڂ̂ƌACompact Ŏgp̗̈擪֋l߂.
+class GeometryRangeAllocator
+{
+public:
+  static const uint64_t InvalidOffset = ~0ull;
+
+  GeometryRangeAllocator();
+
+  void Reset(uint64_t capacity);
+
+  // first-fit Ŋmۂ. mۂłȂ InvalidOffset.
+  uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+  void Free(uint64_t offset);
+
+  // gp̗̈ItZbgɐ擪lߒ.
+  // ړKvȗ̈ relocations ɕԂ (newOffset < oldOffset ̏ɕ).
+  struct Relocation
+  {
+    uint64_t oldOffset;
+    uint64_t newOffset;
+    uint64_t size;
+  };
+  void Compact(std::vector<Relocation>& relocations, uint64_t alignment = 1);
+
+  uint64_t GetCapacity() const { return m_capacity; }
+  uint64_t GetUsedSize() const { return m_usedSize; }
+  uint64_t GetLargestFreeRange() const;
+  size_t GetFreeRangeCount() const { return m_freeRanges.size(); }
+  size_t GetAllocationCount() const { return m_allocations.size(); }
+  // 󂫗eʂ̂Aő̋󂫗̈ȊOɎU΂Ă銄 (0 ` 1).
+  float GetFragmentation() const;
+private:
+  void InsertFreeRange(uint64_t offset, uint64_t size);
+
+  uint64_t m_capacity;
+  uint64_t m_usedSize;
+  // offset -> size
+  std::map<uint64_t, uint64_t> m_freeRanges;
+  // offset -> size (ACgŎ̂Ă擪܂߂ĊǗ)
+  struct Allocation
+  {
+    uint64_t rangeOffset;
+    uint64_t rangeSize;
+  };
+  std::map<uint64_t, Allocation> m_allocations;
+};
@@ -0,0 +1,159 @@
+#include "GpuTimer.h"
+#include "VulkanBookUtil.h"
+
+GpuTimer::GpuTimer()
+  : m_device(VK_NULL_HANDLE), m_queryPool(VK_NULL_HANDLE), m_timestampPeriod(1.0), m_timestampMask(~0ull),
+  m_frameCount(0), m_maxSections(0), m_currentFrame(0)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+}
+
+void GpuTimer::Prepare(VkDevice device, VkPhysicalDevice physDev, uint32_t frameCount, uint32_t maxSections)
+{
+  m_device = device;
+  m_frameCount = frameCount;
+  m_maxSections = maxSections;
+  m_frameSections.resize(frameCount);
+
+  VkPhysicalDeviceProperties props{};
+  vkGetPhysicalDeviceProperties(physDev, &props);
+  if (props.limits.timestampPeriod == 0.0f) {
+    // ^CX^vΉ.
+    return;
+  }
+  m_timestampPeriod = props.limits.timestampPeriod;
+
+  uint32_t count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physDev, &count, nullptr);
+  std::vector<VkQueueFamilyProperties> queueProps(count);
+  vkGetPhysicalDeviceQueueFamilyProperties(physDev, &count, queueProps.data());
+  uint32_t validBits = 64;
+  for (const auto& q : queueProps) {
+    if (q.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+      validBits = q.timestampValidBits;
+      break;
+    }
+  }
+  if (validBits == 0) {
+    return;
+  }
+  m_timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+  VkQueryPoolCreateInfo queryPoolCI{
+    VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, nullptr, 0,
+    VK_QUERY_TYPE_TIMESTAMP,
+    frameCount * maxSections * 2,
+    0,
+  };
+  auto result = vkCreateQueryPool(m_device, &queryPoolCI, nullptr, &m_queryPool);
+  ThrowIfFailed(result, "vkCreateQueryPool Failed.");
+}
+
+void GpuTimer::Cleanup()
+{
+  if (m_queryPool != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+    m_queryPool = VK_NULL_HANDLE;
+  }
+  m_sections.clear();
+  m_frameSections.clear();
+}
+
+void GpuTimer::BeginFrame(VkCommandBuffer command, uint32_t frameIndex)
+{
+  if (m_queryPool == VK_NULL_HANDLE) {
+    return;
+  }
+  // ̃t[̃tFX͑ҋ@ς݂Ȃ̂őǑʂ͎擾ł.
+  CollectResults(frameIndex);
+
+  m_currentFrame = frameIndex;
+  vkCmdResetQueryPool(command, m_queryPool, frameIndex * m_maxSections * 2, m_maxSections * 2);
+}
+
+uint32_t GpuTimer::Begin(VkCommandBuffer command, const std::string& name)
+{
+  uint32_t section = 0;
+  for (; section < uint32_t(m_sections.size()); ++section) {
+    if (m_sections[section].name == name) {
+      break;
+    }
+  }
+  if (section == m_sections.size()) {
+    if (section >= m_maxSections) {
+      return ~0u;
+    }
+    Section s{};
+    s.name = name;
+    m_sections.push_back(s);
+  }
+  if (m_queryPool == VK_NULL_HANDLE) {
+    return section;
+  }
+
+  auto& recorded = m_frameSections[m_currentFrame];
+  recorded.push_back(section);
+  auto query = (m_currentFrame * m_maxSections + section) * 2;
+  vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, query);
+  return section;
+}
+
+void GpuTimer::End(VkCommandBuffer command, uint32_t section)
+{
+  if (m_queryPool == VK_NULL_HANDLE || section >= m_maxSections) {
+    return;
+  }
+  auto query = (m_currentFrame * m_maxSections + section) * 2 + 1;
+  vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, query);
+}
+
+double GpuTimer::GetAverageMs(const std::string& name) const
+{
+  for (const auto& s : m_sections) {
+    if (s.name == name) {
+      return s.averageMs;
+    }
+  }
+  return 0.0;
+}
+
+double GpuTimer::GetLastMs(const std::string& name) const
+{
+  for (const auto& s : m_sections) {
+    if (s.name == name) {
+      return s.lastMs;
+    }
+  }
+  return 0.0;
+}
+
+void GpuTimer::ResetAverage()
+{
+  for (auto& s : m_sections) {
+    s.averageMs = 0.0;
+  }
+}
+
+void GpuTimer::CollectResults(uint32_t frameIndex)
+{
+  auto& recorded = m_frameSections[frameIndex];
+  for (auto section : recorded) {
+    uint64_t ticks[2] = { 0, 0 };
+    auto query = (frameIndex * m_maxSections + section) * 2;
+    auto result = vkGetQueryPoolResults(
+      m_device, m_queryPool, query, 2,
+      sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+      continue;
+    }
+    auto delta = (ticks[1] - ticks[0]) & m_timestampMask;
+    auto ms = double(delta) * m_timestampPeriod / 1000000.0;
+    auto& s = m_sections[section];
+    s.lastMs = ms;
+    s.averageMs = (s.averageMs == 0.0) ? ms : (s.averageMs * 0.95 + ms * 0.05);
+  }
+  recorded.clear();
+}
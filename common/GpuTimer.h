@@ -0,0 +1,54 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+#include <string>
+
+// ^CX^vNGɂ GPU ԎԂ̌v.
+// t[(Xbv`FCC[W)ƂɃNG̈A
+// t[̃R}hobt@ɋL^ƂɑO񕪂̌ʂ.
+class GpuTimer
+{
+public:
+  GpuTimer();
+  ~GpuTimer();
+
+  void Prepare(VkDevice device, VkPhysicalDevice physDev, uint32_t frameCount, uint32_t maxSections = 16);
+  void Cleanup();
+
+  // _[pX̊OŁAt[̃R}hL^JnɌĂ.
+  void BeginFrame(VkCommandBuffer command, uint32_t frameIndex);
+
+  // Ԃ̊Jn/I. ߂l̋Ԕԍ End ɓn.
+  uint32_t Begin(VkCommandBuffer command, const std::string& name);
+  void End(VkCommandBuffer command, uint32_t section);
+
+  struct Section
+  {
+    std::string name;
+    double lastMs = 0.0;     // ߂̌vl
+    double averageMs = 0.0;  // wړ
+  };
+  const std::vector<Section>& GetSections() const { return m_sections; }
+  double GetAverageMs(const std::string& name) const;
+  double GetLastMs(const std::string& name) const;
+
+  // ϒlZbg (v؂ւƂp).
+  void ResetAverage();
+
+  bool IsSupported() const { return m_queryPool != VK_NULL_HANDLE; }
+private:
+  void CollectResults(uint32_t frameIndex);
+
+  VkDevice m_device;
+  VkQueryPool m_queryPool;
+  double m_timestampPeriod;  // ns/tick
+  uint64_t m_timestampMask;
+  uint32_t m_frameCount;
+  uint32_t m_maxSections;
+  uint32_t m_currentFrame;
+
+  std::vector<Section> m_sections;
+  // t[ƂɋL^ꂽԔԍ (NG 2 g).
+  std::vector<std::vector<uint32_t>> m_frameSections;
+};
@@ -0,0 +1,515 @@
+#include "KtxTexture.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace ktx_texture
+{
+  namespace
+  {
+    const uint8_t Ktx1Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    const uint8_t Ktx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    struct Ktx1Header
+    {
+      uint8_t identifier[12];
+      uint32_t endianness;
+      uint32_t glType;
+      uint32_t glTypeSize;
+      uint32_t glFormat;
+      uint32_t glInternalFormat;
+      uint32_t glBaseInternalFormat;
+      uint32_t pixelWidth;
+      uint32_t pixelHeight;
+      uint32_t pixelDepth;
+      uint32_t numberOfArrayElements;
+      uint32_t numberOfFaces;
+      uint32_t numberOfMipmapLevels;
+      uint32_t bytesOfKeyValueData;
+    };
+    struct Ktx2Header
+    {
+      uint8_t identifier[12];
+      uint32_t vkFormat;
+      uint32_t typeSize;
+      uint32_t pixelWidth;
+      uint32_t pixelHeight;
+      uint32_t pixelDepth;
+      uint32_t layerCount;
+      uint32_t faceCount;
+      uint32_t levelCount;
+      uint32_t supercompressionScheme;
+      uint32_t dfdByteOffset;
+      uint32_t dfdByteLength;
+      uint32_t kvdByteOffset;
+      uint32_t kvdByteLength;
+      uint64_t sgdByteOffset;
+      uint64_t sgdByteLength;
+    };
+    struct Ktx2LevelIndex
+    {
+      uint64_t byteOffset;
+      uint64_t byteLength;
+      uint64_t uncompressedByteLength;
+    };
+
+    const uint32_t Ktx1EndianReference = 0x04030201;
+    const uint64_t SubresourceAlignment = 16;
+
+    uint32_t Swap32(uint32_t v)
+    {
+      return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+    }
+    uint64_t Align(uint64_t v, uint64_t alignment)
+    {
+      return (v + alignment - 1) / alignment * alignment;
+    }
+    // floor(log2(max(w,h,d))) + 1. őł 32 Ȃ̂ width >> level `ɂȂȂ.
+    uint32_t MaxMipLevels(uint32_t width, uint32_t height, uint32_t depth)
+    {
+      uint32_t extent = std::max(std::max(width, height), depth);
+      uint32_t levels = 1;
+      while (extent > 1) {
+        extent >>= 1;
+        ++levels;
+      }
+      return levels;
+    }
+    bool SetError(std::string* error, const char* message)
+    {
+      if (error) {
+        *error = message;
+      }
+      return false;
+    }
+
+    void ParseKeyValues(const uint8_t* p, uint64_t length, bool swap, TextureData& texture)
+    {
+      uint64_t offset = 0;
+      while (offset + sizeof(uint32_t) <= length) {
+        uint32_t size = 0;
+        memcpy(&size, p + offset, sizeof(size));
+        if (swap) {
+          size = Swap32(size);
+        }
+        offset += sizeof(uint32_t);
+        if (offset + size > length) {
+          break;
+        }
+        // "L[\0l" ̌`. l̓oCîƂ̂ł̂܂ܕێ.
+        const char* kv = reinterpret_cast<const char*>(p + offset);
+        auto keyLength = strnlen(kv, size);
+        std::string key(kv, keyLength);
+        std::string value;
+        if (keyLength + 1 < size) {
+          value.assign(kv + keyLength + 1, size - keyLength - 1);
+          // ̒l͏I[ \0 ܂.
+          if (!value.empty() && value.back() == '\0') {
+            value.pop_back();
+          }
+        }
+        texture.keyValues.emplace_back(key, value);
+        offset = Align(offset + size, 4);
+      }
+    }
+
+    // t@C̓ǂݏo. ͌ɂ܂Ƃ߂ďݐփRs[.
+    struct SourceRange
+    {
+      uint64_t srcOffset;
+      uint64_t srcRowPitch;
+      uint64_t rowBytes;
+      uint32_t swapSize;  // KTX1 ̃GfBAϊP (0 ȂϊȂ)
+    };
+
+    // 1 Tu\[X̔zu data ̖ (16 oCgE) ɒǉ.
+    // srcRowPitch s̃oCg傫Ƃ̓Rs[ɋlߕ菜.
+    bool AddSubresource(
+      TextureData& texture, const FormatInfo& info,
+      uint32_t level, uint32_t layer, uint32_t width, uint32_t height, uint32_t depth,
+      uint64_t fileSize, uint64_t srcOffset, uint64_t srcRowPitch, uint32_t swapSize,
+      std::vector<SourceRange>& sources)
+    {
+      uint64_t blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+      uint64_t blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+      uint64_t rowBytes = blocksX * info.blockBytes;
+      uint64_t rows = blocksY * depth;
+      if (srcOffset + srcRowPitch * rows > fileSize) {
+        return false;
+      }
+      Subresource sub{};
+      sub.level = level;
+      sub.layer = layer;
+      sub.width = width;
+      sub.height = height;
+      sub.depth = depth;
+      sub.offset = Align(texture.dataSize, SubresourceAlignment);
+      sub.size = rowBytes * rows;
+      texture.dataSize = sub.offset + sub.size;
+      texture.subresources.push_back(sub);
+      sources.push_back({ srcOffset, srcRowPitch, rowBytes, swapSize });
+      return true;
+    }
+
+    void CopySubresources(const TextureData& texture, const std::vector<SourceRange>& sources, const uint8_t* fileData, uint8_t* dst)
+    {
+      for (size_t i = 0; i < texture.subresources.size(); ++i) {
+        const auto& sub = texture.subresources[i];
+        const auto& src = sources[i];
+        auto* p = dst + sub.offset;
+        if (src.srcRowPitch == src.rowBytes) {
+          memcpy(p, fileData + src.srcOffset, size_t(sub.size));
+        } else {
+          for (uint64_t r = 0; r * src.rowBytes < sub.size; ++r) {
+            memcpy(p + r * src.rowBytes, fileData + src.srcOffset + r * src.srcRowPitch, size_t(src.rowBytes));
+          }
+        }
+        if (src.swapSize == 2 || src.swapSize == 4) {
+          for (uint64_t j = 0; j + src.swapSize <= sub.size; j += src.swapSize) {
+            std::reverse(p + j, p + j + src.swapSize);
+          }
+        }
+      }
+    }
+
+    bool LoadKtx1(const uint8_t* fileData, size_t fileSize, TextureData& texture, std::vector<SourceRange>& sources, std::string* error)
+    {
+      if (fileSize < sizeof(Ktx1Header)) {
+        return SetError(error, "KTX: file too small.");
+      }
+      Ktx1Header header;
+      memcpy(&header, fileData, sizeof(header));
+      bool swap = false;
+      if (header.endianness != Ktx1EndianReference) {
+        if (Swap32(header.endianness) != Ktx1EndianReference) {
+          return SetError(error, "KTX: invalid endianness.");
+        }
+        swap = true;
+        uint32_t* fields = &header.endianness;
+        for (int i = 0; i < 13; ++i) {
+          fields[i] = Swap32(fields[i]);
+        }
+      }
+
+      texture.format = ConvertGLInternalFormat(header.glInternalFormat);
+      FormatInfo info;
+      if (!GetFormatInfo(texture.format, info)) {
+        return SetError(error, "KTX: unsupported glInternalFormat.");
+      }
+      texture.width = header.pixelWidth;
+      texture.height = std::max(header.pixelHeight, 1u);
+      texture.depth = std::max(header.pixelDepth, 1u);
+      texture.isArray = header.numberOfArrayElements > 0;
+      texture.arrayElements = std::max(header.numberOfArrayElements, 1u);
+      texture.faces = std::max(header.numberOfFaces, 1u);
+      texture.mipLevels = std::max(header.numberOfMipmapLevels, 1u);
+      if (texture.width == 0 || (texture.faces != 1 && texture.faces != 6)) {
+        return SetError(error, "KTX: invalid dimensions.");
+      }
+      if (texture.mipLevels > MaxMipLevels(texture.width, texture.height, texture.depth)) {
+        return SetError(error, "KTX: too many mip levels.");
+      }
+
+      uint64_t offset = sizeof(Ktx1Header);
+      if (offset + header.bytesOfKeyValueData > fileSize) {
+        return SetError(error, "KTX: truncated key/value data.");
+      }
+      ParseKeyValues(fileData + offset, header.bytesOfKeyValueData, swap, texture);
+      offset += header.bytesOfKeyValueData;
+
+      for (uint32_t level = 0; level < texture.mipLevels; ++level) {
+        if (offset + sizeof(uint32_t) > fileSize) {
+          return SetError(error, "KTX: truncated image data.");
+        }
+        // imageSize ͓ǂݔ΂Aeʂ̃TCY͐@狁߂.
+        offset += sizeof(uint32_t);
+        uint32_t width = std::max(texture.width >> level, 1u);
+        uint32_t height = std::max(texture.height >> level, 1u);
+        uint32_t depth = std::max(texture.depth >> level, 1u);
+        uint64_t blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+        uint64_t blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+        // 񈳏ktH[}bg̍s 4 oCgEɑĂ (GL_UNPACK_ALIGNMENT).
+        uint64_t rowPitch = blocksX * info.blockBytes;
+        if (info.family == FormatFamily_Uncompressed) {
+          rowPitch = Align(rowPitch, 4);
+        }
+        uint64_t faceSize = rowPitch * blocksY * depth;
+        for (uint32_t element = 0; element < texture.arrayElements; ++element) {
+          for (uint32_t face = 0; face < texture.faces; ++face) {
+            auto layer = element * texture.faces + face;
+            uint32_t swapSize = swap ? header.glTypeSize : 0;
+            if (!AddSubresource(texture, info, level, layer, width, height, depth, fileSize, offset, rowPitch, swapSize, sources)) {
+              return SetError(error, "KTX: truncated image data.");
+            }
+            offset = Align(offset + faceSize, 4);  // cubePadding
+          }
+        }
+        offset = Align(offset, 4);  // mipPadding
+      }
+      return true;
+    }
+
+    bool LoadKtx2(const uint8_t* fileData, size_t fileSize, TextureData& texture, std::vector<SourceRange>& sources, std::string* error)
+    {
+      if (fileSize < sizeof(Ktx2Header)) {
+        return SetError(error, "KTX2: file too small.");
+      }
+      Ktx2Header header;
+      memcpy(&header, fileData, sizeof(header));
+      if (header.supercompressionScheme != 0) {
+        return SetError(error, "KTX2: supercompression is not supported.");
+      }
+      if (header.vkFormat == VK_FORMAT_UNDEFINED) {
+        return SetError(error, "KTX2: Basis Universal textures are not supported.");
+      }
+      texture.format = VkFormat(header.vkFormat);
+      FormatInfo info;
+      if (!GetFormatInfo(texture.format, info)) {
+        return SetError(error, "KTX2: unsupported vkFormat.");
+      }
+      texture.width = header.pixelWidth;
+      texture.height = std::max(header.pixelHeight, 1u);
+      texture.depth = std::max(header.pixelDepth, 1u);
+      texture.isArray = header.layerCount > 0;
+      texture.arrayElements = std::max(header.layerCount, 1u);
+      texture.faces = std::max(header.faceCount, 1u);
+      // levelCount 0 ́usɐv̈Ӗ. i[Ă̂̓x 0 ̂.
+      texture.mipLevels = std::max(header.levelCount, 1u);
+      if (texture.width == 0 || (texture.faces != 1 && texture.faces != 6)) {
+        return SetError(error, "KTX2: invalid dimensions.");
+      }
+      if (texture.mipLevels > MaxMipLevels(texture.width, texture.height, texture.depth)) {
+        return SetError(error, "KTX2: too many mip levels.");
+      }
+
+      uint64_t indexOffset = sizeof(Ktx2Header);
+      if (indexOffset + sizeof(Ktx2LevelIndex) * texture.mipLevels > fileSize) {
+        return SetError(error, "KTX2: truncated level index.");
+      }
+      if (header.kvdByteLength > 0) {
+        if (uint64_t(header.kvdByteOffset) + header.kvdByteLength > fileSize) {
+          return SetError(error, "KTX2: truncated key/value data.");
+        }
+        ParseKeyValues(fileData + header.kvdByteOffset, header.kvdByteLength, false, texture);
+      }
+
+      for (uint32_t level = 0; level < texture.mipLevels; ++level) {
+        Ktx2LevelIndex index;
+        memcpy(&index, fileData + indexOffset + sizeof(Ktx2LevelIndex) * level, sizeof(index));
+        if (index.byteOffset + index.byteLength > fileSize) {
+          return SetError(error, "KTX2: truncated image data.");
+        }
+        uint32_t width = std::max(texture.width >> level, 1u);
+        uint32_t height = std::max(texture.height >> level, 1u);
+        uint32_t depth = std::max(texture.depth >> level, 1u);
+        uint64_t blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+        uint64_t blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+        uint64_t rowPitch = blocksX * info.blockBytes;
+        uint64_t imageSize = rowPitch * blocksY * depth;
+        // x̓C[ -> ʂ̏ɋl߂ĕł.
+        uint64_t offset = index.byteOffset;
+        for (uint32_t layer = 0; layer < texture.GetLayerCount(); ++layer) {
+          if (offset + imageSize > index.byteOffset + index.byteLength) {
+            return SetError(error, "KTX2: level size mismatch.");
+          }
+          if (!AddSubresource(texture, info, level, layer, width, height, depth, fileSize, offset, rowPitch, 0, sources)) {
+            return SetError(error, "KTX2: truncated image data.");
+          }
+          offset += imageSize;
+        }
+      }
+      return true;
+    }
+  }
+
+  bool GetFormatInfo(VkFormat format, FormatInfo& info)
+  {
+    info = FormatInfo{};
+    switch (format) {
+    case VK_FORMAT_R8_UNORM: info.blockBytes = 1; return true;
+    case VK_FORMAT_R8G8_UNORM: info.blockBytes = 2; return true;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_R16G16_SFLOAT:
+    case VK_FORMAT_R32_SFLOAT: info.blockBytes = 4; return true;
+    case VK_FORMAT_R16_SFLOAT: info.blockBytes = 2; return true;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R32G32_SFLOAT: info.blockBytes = 8; return true;
+    case VK_FORMAT_R32G32B32A32_SFLOAT: info.blockBytes = 16; return true;
+    default:
+      break;
+    }
+
+    info.blockWidth = 4;
+    info.blockHeight = 4;
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+      info.blockBytes = 8;
+      info.family = FormatFamily_BC;
+      return true;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+      info.blockBytes = 16;
+      info.family = FormatFamily_BC;
+      return true;
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+      info.blockBytes = 8;
+      info.family = FormatFamily_ETC2;
+      return true;
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+      info.blockBytes = 16;
+      info.family = FormatFamily_ETC2;
+      return true;
+    default:
+      break;
+    }
+
+    // ASTC  UNORM/SRGB ݂ 4x4  12x12 ܂ŕł.
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) {
+      const uint32_t blockSizes[][2] = {
+        { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+        { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 },
+      };
+      auto index = (format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2;
+      info.blockWidth = blockSizes[index][0];
+      info.blockHeight = blockSizes[index][1];
+      info.blockBytes = 16;
+      info.family = FormatFamily_ASTC;
+      return true;
+    }
+    info = FormatInfo{};
+    return false;
+  }
+
+  VkFormat ConvertGLInternalFormat(uint32_t glInternalFormat)
+  {
+    switch (glInternalFormat) {
+    // 񈳏k
+    case 0x8229: return VK_FORMAT_R8_UNORM;             // GL_R8
+    case 0x822B: return VK_FORMAT_R8G8_UNORM;           // GL_RG8
+    case 0x8058: return VK_FORMAT_R8G8B8A8_UNORM;       // GL_RGBA8
+    case 0x8C43: return VK_FORMAT_R8G8B8A8_SRGB;        // GL_SRGB8_ALPHA8
+    case 0x822D: return VK_FORMAT_R16_SFLOAT;           // GL_R16F
+    case 0x822F: return VK_FORMAT_R16G16_SFLOAT;        // GL_RG16F
+    case 0x881A: return VK_FORMAT_R16G16B16A16_SFLOAT;  // GL_RGBA16F
+    case 0x822E: return VK_FORMAT_R32_SFLOAT;           // GL_R32F
+    case 0x8230: return VK_FORMAT_R32G32_SFLOAT;        // GL_RG32F
+    case 0x8814: return VK_FORMAT_R32G32B32A32_SFLOAT;  // GL_RGBA32F
+    // S3TC / RGTC / BPTC
+    case 0x83F0: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    case 0x83F1: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK; // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+    case 0x83F2: return VK_FORMAT_BC2_UNORM_BLOCK;      // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+    case 0x83F3: return VK_FORMAT_BC3_UNORM_BLOCK;      // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    case 0x8C4C: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;   // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+    case 0x8C4D: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;  // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+    case 0x8C4E: return VK_FORMAT_BC2_SRGB_BLOCK;       // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+    case 0x8C4F: return VK_FORMAT_BC3_SRGB_BLOCK;       // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+    case 0x8DBB: return VK_FORMAT_BC4_UNORM_BLOCK;      // GL_COMPRESSED_RED_RGTC1
+    case 0x8DBC: return VK_FORMAT_BC4_SNORM_BLOCK;      // GL_COMPRESSED_SIGNED_RED_RGTC1
+    case 0x8DBD: return VK_FORMAT_BC5_UNORM_BLOCK;      // GL_COMPRESSED_RG_RGTC2
+    case 0x8DBE: return VK_FORMAT_BC5_SNORM_BLOCK;      // GL_COMPRESSED_SIGNED_RG_RGTC2
+    case 0x8E8F: return VK_FORMAT_BC6H_UFLOAT_BLOCK;    // GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+    case 0x8E8E: return VK_FORMAT_BC6H_SFLOAT_BLOCK;    // GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+    case 0x8E8C: return VK_FORMAT_BC7_UNORM_BLOCK;      // GL_COMPRESSED_RGBA_BPTC_UNORM
+    case 0x8E8D: return VK_FORMAT_BC7_SRGB_BLOCK;       // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+    // ETC1 / ETC2 / EAC (ETC1  ETC2  RGB ƌ݊)
+    case 0x8D64: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;   // GL_ETC1_RGB8_OES
+    case 0x9274: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;   // GL_COMPRESSED_RGB8_ETC2
+    case 0x9275: return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;    // GL_COMPRESSED_SRGB8_ETC2
+    case 0x9276: return VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK; // GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+    case 0x9277: return VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK;  // GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2
+    case 0x9278: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK; // GL_COMPRESSED_RGBA8_ETC2_EAC
+    case 0x9279: return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;  // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+    case 0x9270: return VK_FORMAT_EAC_R11_UNORM_BLOCK;       // GL_COMPRESSED_R11_EAC
+    case 0x9271: return VK_FORMAT_EAC_R11_SNORM_BLOCK;       // GL_COMPRESSED_SIGNED_R11_EAC
+    case 0x9272: return VK_FORMAT_EAC_R11G11_UNORM_BLOCK;    // GL_COMPRESSED_RG11_EAC
+    case 0x9273: return VK_FORMAT_EAC_R11G11_SNORM_BLOCK;    // GL_COMPRESSED_SIGNED_RG11_EAC
+    default:
+      break;
+    }
+    // ASTC: GL_COMPRESSED_RGBA_ASTC_4x4_KHR (0x93B0) ` 12x12 (0x93BD),
+    //       GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR (0x93D0) ` 12x12 (0x93DD).
+    if (glInternalFormat >= 0x93B0 && glInternalFormat <= 0x93BD) {
+      return VkFormat(VK_FORMAT_ASTC_4x4_UNORM_BLOCK + (glInternalFormat - 0x93B0) * 2);
+    }
+    if (glInternalFormat >= 0x93D0 && glInternalFormat <= 0x93DD) {
+      return VkFormat(VK_FORMAT_ASTC_4x4_SRGB_BLOCK + (glInternalFormat - 0x93D0) * 2);
+    }
+    return VK_FORMAT_UNDEFINED;
+  }
+
+  bool LoadFromMemory(const uint8_t* fileData, size_t fileSize, TextureData& texture, std::string* error)
+  {
+    return LoadFromMemory(fileData, fileSize, texture, Allocator(), error);
+  }
+
+  bool LoadFromMemory(const uint8_t* fileData, size_t fileSize, TextureData& texture, const Allocator& allocator, std::string* error)
+  {
+    texture = TextureData{};
+    std::vector<SourceRange> sources;
+    bool parsed = false;
+    if (fileSize >= sizeof(Ktx1Identifier) && memcmp(fileData, Ktx1Identifier, sizeof(Ktx1Identifier)) == 0) {
+      parsed = LoadKtx1(fileData, fileSize, texture, sources, error);
+    } else if (fileSize >= sizeof(Ktx2Identifier) && memcmp(fileData, Ktx2Identifier, sizeof(Ktx2Identifier)) == 0) {
+      parsed = LoadKtx2(fileData, fileSize, texture, sources, error);
+    } else {
+      return SetError(error, "KTX: unknown file identifier.");
+    }
+    if (!parsed) {
+      return false;
+    }
+
+    // zu܂Ă珑ݐmۂAt@C璼ڃRs[.
+    uint8_t* dst = nullptr;
+    if (allocator) {
+      dst = allocator(texture.dataSize);
+    } else {
+      texture.data.resize(size_t(texture.dataSize));
+      dst = texture.data.data();
+    }
+    if (dst == nullptr && texture.dataSize > 0) {
+      return SetError(error, "KTX: failed to allocate destination memory.");
+    }
+    CopySubresources(texture, sources, fileData, dst);
+    return true;
+  }
+
+  bool Load(const std::filesystem::path& fileName, TextureData& texture, std::string* error)
+  {
+    return Load(fileName, texture, Allocator(), error);
+  }
+
+  bool Load(const std::filesystem::path& fileName, TextureData& texture, const Allocator& allocator, std::string* error)
+  {
+    std::ifstream infile(fileName, std::ios::binary);
+    if (!infile) {
+      return SetError(error, "KTX: file not found.");
+    }
+    std::vector<uint8_t> fileData(
+      (std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+    return LoadFromMemory(fileData.data(), fileData.size(), texture, allocator, error);
+  }
+}
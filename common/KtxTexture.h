@@ -0,0 +1,79 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <cstdint>
+#include <functional>
+
+// KTX (1.1) / KTX2 eNX`t@C̓ǂݍ.
+// ~bvxAz񃌃C[AL[u}bvA3D eNX`
+// BC1-7 / ETC2 / EAC / ASTC ̃ubNktH[}bg.
+// KTX2  supercompression (BasisLZ/Zstandard) ɂ͑ΉȂ.
+namespace ktx_texture
+{
+  // k̕. foCX@\ (textureCompressionXXX) ̊mFɎg.
+  enum FormatFamily {
+    FormatFamily_Uncompressed = 0,
+    FormatFamily_BC,
+    FormatFamily_ETC2,
+    FormatFamily_ASTC,
+  };
+  struct FormatInfo
+  {
+    uint32_t blockWidth = 1;
+    uint32_t blockHeight = 1;
+    uint32_t blockBytes = 0;
+    FormatFamily family = FormatFamily_Uncompressed;
+  };
+  // ΉĂȂtH[}bĝƂ false.
+  bool GetFormatInfo(VkFormat format, FormatInfo& info);
+
+  // KTX1  glInternalFormat  VkFormat ɕϊ. ΉȂ VK_FORMAT_UNDEFINED.
+  VkFormat ConvertGLInternalFormat(uint32_t glInternalFormat);
+
+  // 1 ̃Tu\[X (~bvx/C[/) ̔zu.
+  // data ł͍s̋lߕԂŁA16 oCgE.
+  struct Subresource
+  {
+    uint32_t level;
+    uint32_t layer;   // z񃌃C[ * ʐ +  (Vulkan  arrayLayer)
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  struct TextureData
+  {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 1;
+    uint32_t mipLevels = 1;
+    uint32_t arrayElements = 1;  // złȂ 1
+    uint32_t faces = 1;          // L[u}bvȂ 6
+    bool isArray = false;
+
+    // Tu\[X̎f[^. Allocator nēǂݍ񂾂Ƃ͋ŁAmۂꂽ̈ɏ܂.
+    std::vector<uint8_t> data;
+    uint64_t dataSize = 0;  // STu\[XׂTCY (16 oCgE)
+    std::vector<Subresource> subresources;
+    std::vector<std::pair<std::string, std::string>> keyValues;
+
+    uint32_t GetLayerCount() const { return arrayElements * faces; }
+    bool IsCubemap() const { return faces == 6; }
+  };
+
+  // gqł͂Ȃ擪̎ʎq KTX1/KTX2 𔻕ʂ.
+  bool Load(const std::filesystem::path& fileName, TextureData& texture, std::string* error = nullptr);
+  bool LoadFromMemory(const uint8_t* fileData, size_t fileSize, TextureData& texture, std::string* error = nullptr);
+
+  // Tu\[X̏ݐĂяopӂ (Xe[WOobt@֒ړWJꍇȂ).
+  // wb_[̉͌ dataSize  1 xĂ΂. nullptr ԂƓǂݍ݂͎s.
+  using Allocator = std::function<uint8_t*(uint64_t size)>;
+  bool Load(const std::filesystem::path& fileName, TextureData& texture, const Allocator& allocator, std::string* error = nullptr);
+  bool LoadFromMemory(const uint8_t* fileData, size_t fileSize, TextureData& texture, const Allocator& allocator, std::string* error = nullptr);
+}
@@ -0,0 +1,371 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+
+namespace mesh_optimizer
+{
+  VertexCacheStatistics AnalyzeVertexCache(
+    const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+  {
+    VertexCacheStatistics stats{};
+    stats.triangleCount = uint32_t(indices.size() / 3);
+    if (indices.empty() || vertexCount == 0) {
+      return stats;
+    }
+
+    // e_LbVɓL^ FIFO LbV\.
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint32_t timestamp = cacheSize + 1;
+    for (auto index : indices) {
+      if (timestamp - cacheTimestamps[index] > cacheSize) {
+        cacheTimestamps[index] = timestamp++;
+        stats.transformedVertices++;
+      }
+      if (!used[index]) {
+        used[index] = true;
+        stats.vertexCount++;
+      }
+    }
+    stats.acmr = float(stats.transformedVertices) / float(stats.triangleCount);
+    stats.atvr = float(stats.transformedVertices) / float(stats.vertexCount);
+    return stats;
+  }
+
+  uint32_t GenerateVertexRemap(
+    std::vector<uint32_t>& remap,
+    const std::vector<uint32_t>& indices, uint32_t vertexCount,
+    const std::vector<VertexStream>& streams)
+  {
+    // _CfbNXL[ɂāAXg[eŃnbV/r.
+    auto hasher = [&](uint32_t v) {
+      uint64_t h = 14695981039346656037ull;
+      for (const auto& s : streams) {
+        const auto* p = static_cast<const uint8_t*>(s.data) + s.stride * v;
+        for (size_t i = 0; i < s.stride; ++i) {
+          h = (h ^ p[i]) * 1099511628211ull;
+        }
+      }
+      return size_t(h);
+    };
+    auto equal = [&](uint32_t a, uint32_t b) {
+      for (const auto& s : streams) {
+        const auto* base = static_cast<const uint8_t*>(s.data);
+        if (memcmp(base + s.stride * a, base + s.stride * b, s.stride) != 0) {
+          return false;
+        }
+      }
+      return true;
+    };
+    std::unordered_map<uint32_t, uint32_t, decltype(hasher), decltype(equal)> table(vertexCount, hasher, equal);
+
+    remap.assign(vertexCount, ~0u);
+    uint32_t next = 0;
+    for (auto index : indices) {
+      if (remap[index] != ~0u) {
+        continue;
+      }
+      auto it = table.find(index);
+      if (it != table.end()) {
+        remap[index] = it->second;
+      } else {
+        table.emplace(index, next);
+        remap[index] = next++;
+      }
+    }
+    return next;
+  }
+
+  void RemapIndexBuffer(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap)
+  {
+    for (auto& index : indices) {
+      index = remap[index];
+    }
+  }
+
+  namespace
+  {
+    const int   MaxVertexCacheSize = 32;
+    const float CacheDecayPower = 1.5f;
+    const float LastTriScore = 0.75f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+
+    float ComputeVertexScore(int cachePosition, uint32_t activeTriangles)
+    {
+      if (activeTriangles == 0) {
+        // SĂ̎Op`o͍ς݂̒_͎gȂ.
+        return -1.0f;
+      }
+      float score = 0.0f;
+      if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+          // O̎Op`Ŏgꂽ_͈ꗥ̃XRAƂ.
+          score = LastTriScore;
+        } else {
+          const float scaler = 1.0f / (MaxVertexCacheSize - 3);
+          score = 1.0f - (cachePosition - 3) * scaler;
+          score = std::pow(score, CacheDecayPower);
+        }
+      }
+      // c̎Op`Ȃ_D悵ĕЕt.
+      score += ValenceBoostScale * std::pow(float(activeTriangles), -ValenceBoostPower);
+      return score;
+    }
+  }
+
+  void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+  {
+    const auto triangleCount = uint32_t(indices.size() / 3);
+    if (triangleCount == 0) {
+      return;
+    }
+
+    // _ -> Op` ̗אڃXg.
+    std::vector<uint32_t> activeCount(vertexCount, 0);
+    for (auto index : indices) {
+      activeCount[index]++;
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+      adjacencyOffset[v + 1] = adjacencyOffset[v] + activeCount[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+      std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+      for (uint32_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k) {
+          auto v = indices[t * 3 + k];
+          adjacency[fill[v]++] = t;
+        }
+      }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+      vertexScore[v] = ComputeVertexScore(-1, activeCount[v]);
+    }
+    std::vector<bool> emitted(triangleCount, false);
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(MaxVertexCacheSize + 3);
+    nextCache.reserve(MaxVertexCacheSize + 3);
+
+    uint32_t scanCursor = 0;
+    int bestTriangle = -1;
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+      if (bestTriangle < 0) {
+        // LbVɌ₪Ƃ͖o͂̎Op`̏ŏE.
+        while (scanCursor < triangleCount && emitted[scanCursor]) {
+          ++scanCursor;
+        }
+        bestTriangle = int(scanCursor);
+      }
+      const auto tri = uint32_t(bestTriangle);
+      emitted[tri] = true;
+
+      const uint32_t triVertices[3] = {
+        indices[tri * 3 + 0], indices[tri * 3 + 1], indices[tri * 3 + 2]
+      };
+      for (auto v : triVertices) {
+        result.push_back(v);
+
+        // אڃXgo͍ς݂̎Op`菜.
+        auto begin = adjacency.begin() + adjacencyOffset[v];
+        auto end = begin + activeCount[v];
+        auto it = std::find(begin, end, tri);
+        if (it != end) {
+          std::iter_swap(it, end - 1);
+          activeCount[v]--;
+        }
+      }
+
+      // o͂Op`̒_LbV̐擪ɐς.
+      nextCache.clear();
+      nextCache.insert(nextCache.end(), triVertices, triVertices + 3);
+      for (auto v : cache) {
+        if (v != triVertices[0] && v != triVertices[1] && v != triVertices[2]) {
+          nextCache.push_back(v);
+        }
+      }
+      std::swap(cache, nextCache);
+
+      for (int i = 0; i < int(cache.size()); ++i) {
+        auto v = cache[i];
+        cachePosition[v] = i < MaxVertexCacheSize ? i : -1;
+        vertexScore[v] = ComputeVertexScore(cachePosition[v], activeCount[v]);
+      }
+
+      // LbV̒_ɗאڂOp`̃XRAXVĎ̌߂.
+      bestTriangle = -1;
+      float bestScore = -1.0f;
+      for (auto v : cache) {
+        auto begin = adjacencyOffset[v];
+        for (uint32_t a = 0; a < activeCount[v]; ++a) {
+          auto t = adjacency[begin + a];
+          float score =
+            vertexScore[indices[t * 3 + 0]] +
+            vertexScore[indices[t * 3 + 1]] +
+            vertexScore[indices[t * 3 + 2]];
+          if (score > bestScore) {
+            bestScore = score;
+            bestTriangle = int(t);
+          }
+        }
+      }
+      if (cache.size() > MaxVertexCacheSize) {
+        cache.resize(MaxVertexCacheSize);
+      }
+    }
+    indices.swap(result);
+  }
+
+  void OptimizeOverdraw(
+    std::vector<uint32_t>& indices,
+    const float* positions, size_t positionStride, uint32_t vertexCount,
+    float threshold)
+  {
+    const auto triangleCount = uint32_t(indices.size() / 3);
+    if (triangleCount < 2) {
+      return;
+    }
+    auto position = [&](uint32_t v) {
+      return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + positionStride * v);
+    };
+
+    // _LbVւɂȂʒuNX^̋EƂ.
+    const uint32_t cacheSize = 16;
+    std::vector<uint32_t> clusterStart;
+    {
+      std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+      uint32_t timestamp = cacheSize + 1;
+      for (uint32_t t = 0; t < triangleCount; ++t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) {
+          auto v = indices[t * 3 + k];
+          if (timestamp - cacheTimestamps[v] > cacheSize) {
+            cacheTimestamps[v] = timestamp++;
+            misses++;
+          }
+        }
+        if (t == 0 || misses == 3) {
+          clusterStart.push_back(t);
+        }
+      }
+    }
+    const auto clusterCount = uint32_t(clusterStart.size());
+    if (clusterCount < 2) {
+      return;
+    }
+    clusterStart.push_back(triangleCount);
+
+    // bVŜ̏dS.
+    float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    struct Cluster {
+      float center[3];
+      float normal[3];
+      float area;
+    };
+    std::vector<Cluster> clusters(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+      auto& cl = clusters[c];
+      cl = Cluster{};
+      for (uint32_t t = clusterStart[c]; t < clusterStart[c + 1]; ++t) {
+        const float* p0 = position(indices[t * 3 + 0]);
+        const float* p1 = position(indices[t * 3 + 1]);
+        const float* p2 = position(indices[t * 3 + 2]);
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float n[3] = {
+          e1[1] * e2[2] - e1[2] * e2[1],
+          e1[2] * e2[0] - e1[0] * e2[2],
+          e1[0] * e2[1] - e1[1] * e2[0],
+        };
+        float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int k = 0; k < 3; ++k) {
+          cl.center[k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+          cl.normal[k] += n[k];
+        }
+        cl.area += area;
+      }
+      for (int k = 0; k < 3; ++k) {
+        meshCenter[k] += cl.center[k];
+      }
+      meshArea += cl.area;
+      if (cl.area > 0.0f) {
+        for (int k = 0; k < 3; ++k) {
+          cl.center[k] /= cl.area;
+        }
+      }
+    }
+    if (meshArea > 0.0f) {
+      for (int k = 0; k < 3; ++k) {
+        meshCenter[k] /= meshArea;
+      }
+    }
+
+    // dSOĂNX^قǎOɗ₷̂Őɕ`悷.
+    std::vector<float> sortKey(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+      const auto& cl = clusters[c];
+      float len = std::sqrt(cl.normal[0] * cl.normal[0] + cl.normal[1] * cl.normal[1] + cl.normal[2] * cl.normal[2]);
+      float dot = 0.0f;
+      if (len > 0.0f) {
+        for (int k = 0; k < 3; ++k) {
+          dot += (cl.center[k] - meshCenter[k]) * (cl.normal[k] / len);
+        }
+      }
+      sortKey[c] = dot;
+    }
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+      order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (auto c : order) {
+      result.insert(result.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+    }
+
+    // LbV̈e͈͂𒴂ꍇ͌̏ێ.
+    auto before = AnalyzeVertexCache(indices, vertexCount);
+    auto after = AnalyzeVertexCache(result, vertexCount);
+    if (after.acmr <= before.acmr * threshold) {
+      indices.swap(result);
+    }
+  }
+
+  uint32_t OptimizeVertexFetchRemap(std::vector<uint32_t>& remap, std::vector<uint32_t>& indices, uint32_t vertexCount)
+  {
+    remap.assign(vertexCount, ~0u);
+    uint32_t next = 0;
+    for (auto& index : indices) {
+      if (remap[index] == ~0u) {
+        remap[index] = next++;
+      }
+      index = remap[index];
+    }
+    return next;
+  }
+
+  std::vector<uint32_t> BuildVertexOrder(const std::vector<uint32_t>& remap, uint32_t newVertexCount)
+  {
+    std::vector<uint32_t> order(newVertexCount, ~0u);
+    for (uint32_t i = 0; i < uint32_t(remap.size()); ++i) {
+      auto dst = remap[i];
+      if (dst != ~0u && order[dst] == ~0u) {
+        order[dst] = i;
+      }
+    }
+    return order;
+  }
+}
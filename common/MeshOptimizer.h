@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// fǂݍݎ DrawBatch PʂœKp郁bVœK.
+// - _̏d
+// - _LbV̎Op`ёւ (Tom Forsyth )
+// - I[o[h[팸̂߂̎Op`NX^ёւ
+// - _tFb`̋Ǐ̂߂̒_ёւ
+namespace mesh_optimizer
+{
+  // _LbV̎wW.
+  //  ACMR: 1 Op`̒_VF[_[s (0.5 ` 3.0)
+  //  ATVR: 1 _̒_VF[_[s (1.0 z)
+  struct VertexCacheStatistics
+  {
+    uint32_t transformedVertices = 0;
+    uint32_t triangleCount = 0;
+    uint32_t vertexCount = 0;
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+  };
+
+  // dɎg_Xg[.
+  struct VertexStream
+  {
+    const void* data;
+    size_t stride;
+  };
+
+  // FIFO LbVV~[g ACMR/ATVR ߂.
+  VertexCacheStatistics AnalyzeVertexCache(
+    const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+  // SXg[̓ev钸_𓯈ꎋ remap e[u.
+  // remap[CfbNX] = VCfbNX. QƂȂ_ ~0u.
+  // ߂l̓j[NȒ_.
+  uint32_t GenerateVertexRemap(
+    std::vector<uint32_t>& remap,
+    const std::vector<uint32_t>& indices, uint32_t vertexCount,
+    const std::vector<VertexStream>& streams);
+
+  // CfbNXobt@ remap Kp.
+  void RemapIndexBuffer(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap);
+
+  // _LbṼqbgオ悤ɎOp`ёւ.
+  void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+  // LbV threshold {܂ň邱ƂeāA
+  // ONX^ɕ`悳悤ɕёւ.
+  void OptimizeOverdraw(
+    std::vector<uint32_t>& indices,
+    const float* positions, size_t positionStride, uint32_t vertexCount,
+    float threshold = 1.05f);
+
+  // CfbNXŎQƂ鏇ɒ_ёւ邽߂ remap ACfbNX.
+  // ߂l̓j[NȒ_.
+  uint32_t OptimizeVertexFetchRemap(std::vector<uint32_t>& remap, std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+  // remap uVCfbNX -> CfbNXv̑Ή\.
+  std::vector<uint32_t> BuildVertexOrder(const std::vector<uint32_t>& remap, uint32_t newVertexCount);
+}
@@ -0,0 +1,187 @@
+#include "NodeHierarchy.h"
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define NODE_HIERARCHY_USE_SSE 1
+#endif
+
+uint32_t NodeNameTable::Hash(const char* name, size_t length)
+{
+  // FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= uint8_t(name[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool NodeNameTable::Insert(const char* name, size_t length, uint32_t value)
+{
+  if ((m_keys.size() + 1) * 2 > m_slots.size()) {
+    Rehash(std::max<size_t>(16, m_slots.size() * 2));
+  }
+  const auto hash = Hash(name, length);
+  const size_t mask = m_slots.size() - 1;
+  for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+    auto& slot = m_slots[i];
+    if (slot.entry == InvalidIndex) {
+      slot.hash = hash;
+      slot.entry = uint32_t(m_keys.size());
+      m_keys.emplace_back(name, length);
+      m_values.push_back(value);
+      return true;
+    }
+    if (slot.hash == hash && m_keys[slot.entry].compare(0, std::string::npos, name, length) == 0) {
+      return false;
+    }
+  }
+}
+
+uint32_t NodeNameTable::Find(const char* name, size_t length) const
+{
+  if (m_slots.empty()) {
+    return InvalidIndex;
+  }
+  const auto hash = Hash(name, length);
+  const size_t mask = m_slots.size() - 1;
+  for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+    const auto& slot = m_slots[i];
+    if (slot.entry == InvalidIndex) {
+      return InvalidIndex;
+    }
+    if (slot.hash == hash && m_keys[slot.entry].compare(0, std::string::npos, name, length) == 0) {
+      return m_values[slot.entry];
+    }
+  }
+}
+
+void NodeNameTable::Rehash(size_t slotCount)
+{
+  m_slots.assign(slotCount, Slot{ 0, InvalidIndex });
+  const size_t mask = slotCount - 1;
+  for (uint32_t e = 0; e < uint32_t(m_keys.size()); ++e) {
+    const auto hash = Hash(m_keys[e].data(), m_keys[e].size());
+    size_t i = hash & mask;
+    while (m_slots[i].entry != InvalidIndex) {
+      i = (i + 1) & mask;
+    }
+    m_slots[i] = Slot{ hash, e };
+  }
+}
+
+void NodeNameTable::Clear()
+{
+  m_slots.clear();
+  m_keys.clear();
+  m_values.clear();
+}
+
+size_t NodeNameTable::GetMemorySize() const
+{
+  size_t size = m_slots.size() * sizeof(Slot) + m_keys.size() * (sizeof(std::string) + sizeof(uint32_t));
+  for (const auto& key : m_keys) {
+    size += key.capacity();
+  }
+  return size;
+}
+
+uint32_t NodeHierarchy::AddNode(const std::string& name, uint32_t parent, const glm::mat4& local)
+{
+  assert(parent == InvalidIndex || parent < GetNodeCount());
+  uint32_t index = GetNodeCount();
+  m_localMatrices.push_back(local);
+  m_worldMatrices.push_back(local);
+  m_parents.push_back(parent);
+  m_dirty.push_back(1);
+  m_names.push_back(name);
+  m_nameTable.Insert(name, index);
+  return index;
+}
+
+void NodeHierarchy::Clear()
+{
+  m_localMatrices.clear();
+  m_worldMatrices.clear();
+  m_parents.clear();
+  m_dirty.clear();
+  m_names.clear();
+  m_nameTable.Clear();
+  m_rootMatrix = glm::mat4(1.0f);
+}
+
+void NodeHierarchy::MarkAllDirty()
+{
+  std::fill(m_dirty.begin(), m_dirty.end(), uint8_t(1));
+}
+
+uint32_t NodeHierarchy::UpdateWorldMatrices(const glm::mat4& rootMatrix)
+{
+  if (rootMatrix != m_rootMatrix) {
+    m_rootMatrix = rootMatrix;
+    MarkAllDirty();
+  }
+
+  // e͎qOɂ̂ŁAe̍XVtOq֓`dȂ 1 ŏł.
+  const auto count = GetNodeCount();
+  const auto* parents = m_parents.data();
+  const auto* locals = m_localMatrices.data();
+  auto* worlds = m_worldMatrices.data();
+  auto* dirty = m_dirty.data();
+  uint32_t updated = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto parent = parents[i];
+    if (parent != InvalidIndex) {
+      dirty[i] |= dirty[parent];
+    }
+    if (!dirty[i]) {
+      continue;
+    }
+    MultiplyMatrix(parent != InvalidIndex ? worlds[parent] : m_rootMatrix, locals[i], worlds[i]);
+    updated++;
+  }
+  memset(dirty, 0, count);
+  return updated;
+}
+
+size_t NodeHierarchy::GetMemorySize() const
+{
+  size_t size = GetNodeCount() * (sizeof(glm::mat4) * 2 + sizeof(uint32_t) + sizeof(uint8_t) + sizeof(std::string));
+  for (const auto& name : m_names) {
+    size += name.capacity();
+  }
+  return size + m_nameTable.GetMemorySize();
+}
+
+void NodeHierarchy::MultiplyMatrix(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#if NODE_HIERARCHY_USE_SSE
+  // out ̗ j = a ̊e b[j] ̗vfŏdݕta.
+  const float* pa = &a[0][0];
+  const float* pb = &b[0][0];
+  const __m128 a0 = _mm_loadu_ps(pa + 0);
+  const __m128 a1 = _mm_loadu_ps(pa + 4);
+  const __m128 a2 = _mm_loadu_ps(pa + 8);
+  const __m128 a3 = _mm_loadu_ps(pa + 12);
+  __m128 r[4];
+  for (int j = 0; j < 4; ++j) {
+    const float* col = pb + j * 4;
+    __m128 v = _mm_mul_ps(a0, _mm_set1_ps(col[0]));
+    v = _mm_add_ps(v, _mm_mul_ps(a1, _mm_set1_ps(col[1])));
+    v = _mm_add_ps(v, _mm_mul_ps(a2, _mm_set1_ps(col[2])));
+    v = _mm_add_ps(v, _mm_mul_ps(a3, _mm_set1_ps(col[3])));
+    r[j] = v;
+  }
+  // out  a/b Ɠꍇ̂ŁASvZĂ珑.
+  float* po = &out[0][0];
+  _mm_storeu_ps(po + 0, r[0]);
+  _mm_storeu_ps(po + 4, r[1]);
+  _mm_storeu_ps(po + 8, r[2]);
+  _mm_storeu_ps(po + 12, r[3]);
+#else
+  out = a * b;
+#endif
+}
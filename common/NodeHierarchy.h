@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// m[h -> ԍ ̕\. I[vAhX@ (`T) ŁA\̑傫͗vf 2 {ȏ 2 ׂ̂ɕۂ.
+// O 2 o^Ƃ͍ŏ̂̂c.
+class NodeNameTable
+{
+public:
+  static const uint32_t InvalidIndex = ~0u;
+
+  // o^ł true. ɂ閼OȂ false ŁAl͕ςȂ.
+  bool Insert(const char* name, size_t length, uint32_t value);
+  bool Insert(const std::string& name, uint32_t value) { return Insert(name.data(), name.size(), value); }
+  uint32_t Find(const char* name, size_t length) const;
+  uint32_t Find(const std::string& name) const { return Find(name.data(), name.size()); }
+  void Clear();
+
+  size_t GetCount() const { return m_keys.size(); }
+  size_t GetMemorySize() const;
+
+  static uint32_t Hash(const char* name, size_t length);
+private:
+  void Rehash(size_t slotCount);
+
+  struct Slot {
+    uint32_t hash;
+    uint32_t entry; // m_keys/m_values ̔ԍ. 󂫂 InvalidIndex
+  };
+  std::vector<Slot> m_slots;
+  std::vector<std::string> m_keys;
+  std::vector<uint32_t> m_values;
+};
+
+// f̃m[hKw ({[܂) zŎ.
+// m[h͐eKqOɗ鏇 (g|WJ) ɕׂ̂ŁA
+// [hs̍XV͐擪 1 ̃[vōς.
+// s local/world ƂɘAzɂ܂Ƃ߁A|C^HȂ.
+class NodeHierarchy
+{
+public:
+  static const uint32_t InvalidIndex = ~0u;
+
+  // parent ͒ǉς݂̃m[h InvalidIndex ([g). ߂l͒ǉm[h̔ԍ.
+  uint32_t AddNode(const std::string& name, uint32_t parent, const glm::mat4& local);
+  void Clear();
+
+  uint32_t GetNodeCount() const { return uint32_t(m_parents.size()); }
+  const std::string& GetName(uint32_t index) const { return m_names[index]; }
+  uint32_t GetParent(uint32_t index) const { return m_parents[index]; }
+
+  const glm::mat4& GetLocalMatrix(uint32_t index) const { return m_localMatrices[index]; }
+  // [JsƁÃm[hȉ UpdateWorldMatrices ōXV.
+  void SetLocalMatrix(uint32_t index, const glm::mat4& local)
+  {
+    m_localMatrices[index] = local;
+    m_dirty[index] = 1;
+  }
+  void MarkAllDirty();
+
+  const glm::mat4& GetWorldMatrix(uint32_t index) const { return m_worldMatrices[index]; }
+  const glm::mat4* GetWorldMatrices() const { return m_worldMatrices.data(); }
+
+  // ύX̂m[hƂ̎q[hsvZ. ߂l͌vZm[h.
+  uint32_t UpdateWorldMatrices(const glm::mat4& rootMatrix = glm::mat4(1.0f));
+
+  // OŌ (nbV\). Ȃ InvalidIndex.
+  uint32_t FindNode(const std::string& name) const { return m_nameTable.Find(name); }
+
+  size_t GetMemorySize() const;
+
+  // a * b (D 4x4). SSE gƂ͗񂲂Ƃɂ܂Ƃ߂ČvZ.
+  static void MultiplyMatrix(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+private:
+  std::vector<glm::mat4> m_localMatrices;
+  std::vector<glm::mat4> m_worldMatrices;
+  std::vector<uint32_t> m_parents;
+  std::vector<uint8_t> m_dirty;
+  std::vector<std::string> m_names;
+  NodeNameTable m_nameTable;
+  glm::mat4 m_rootMatrix = glm::mat4(1.0f);
+};
@@ -0,0 +1,103 @@
+#include "VertexCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vertex_compression
+{
+  void OctahedralEncode(const float* normal, int16_t* out)
+  {
+    float x = normal[0], y = normal[1], z = normal[2];
+    float len = std::abs(x) + std::abs(y) + std::abs(z);
+    if (len <= 0.0f) {
+      // @Ȃ_ (0,0,1) ƂĈ.
+      out[0] = 0;
+      out[1] = 0;
+      return;
+    }
+    x /= len; y /= len; z /= len;
+    if (z < 0.0f) {
+      // ͑ΊpŐ܂Ԃ.
+      float ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+      float oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+      x = ox; y = oy;
+    }
+    out[0] = QuantizeSnorm16(x);
+    out[1] = QuantizeSnorm16(y);
+  }
+
+  uint16_t FloatToHalf(float v)
+  {
+    uint32_t bits = 0;
+    memcpy(&bits, &v, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = int32_t((bits >> 23) & 0xFFu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (((bits >> 23) & 0xFFu) == 0xFFu) {
+      // Inf / NaN
+      return uint16_t(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+    if (exponent >= 31) {
+      return uint16_t(sign | 0x7C00u);
+    }
+    if (exponent <= 0) {
+      if (exponent < -10) {
+        return uint16_t(sign);
+      }
+      // 񐳋K.
+      mantissa |= 0x800000u;
+      uint32_t shift = uint32_t(14 - exponent);
+      uint32_t half = mantissa >> shift;
+      uint32_t rest = mantissa & ((1u << shift) - 1u);
+      uint32_t halfway = 1u << (shift - 1);
+      if (rest > halfway || (rest == halfway && (half & 1u))) {
+        half++;
+      }
+      return uint16_t(sign | half);
+    }
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+      half++; // JオŎwɈĂlɂȂ.
+    }
+    return uint16_t(half);
+  }
+
+  uint16_t QuantizeUnorm16(float v)
+  {
+    v = std::min(std::max(v, 0.0f), 1.0f);
+    return uint16_t(v * 65535.0f + 0.5f);
+  }
+
+  uint8_t QuantizeUnorm8(float v)
+  {
+    v = std::min(std::max(v, 0.0f), 1.0f);
+    return uint8_t(v * 255.0f + 0.5f);
+  }
+
+  int16_t QuantizeSnorm16(float v)
+  {
+    v = std::min(std::max(v, -1.0f), 1.0f);
+    return int16_t(std::round(v * 32767.0f));
+  }
+
+  void QuantizeWeights(const float* weights, uint8_t* out)
+  {
+    int total = 0;
+    int maxIndex = 0;
+    for (int i = 0; i < 4; ++i) {
+      out[i] = QuantizeUnorm8(weights[i]);
+      total += out[i];
+      if (weights[i] > weights[maxIndex]) {
+        maxIndex = i;
+      }
+    }
+    // ۂߌ덷͈ԑ傫EFCgɊ񂹂čv 1.0 ɕۂ.
+    if (total > 0) {
+      int fixed = int(out[maxIndex]) + (255 - total);
+      out[maxIndex] = uint8_t(std::min(std::max(fixed, 0), 255));
+    }
+  }
+}
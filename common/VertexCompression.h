@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+// _ GPU ̏ȃtH[}bgɕϊ鏈.
+// n[hEFA̒_tFb`œWJł` (SNORM/UNORM/SFLOAT) ŏo͂.
+namespace vertex_compression
+{
+  // PʃxNg𔪖ʑ̃}bsO [-1,1]  2 ɂ.
+  // ʂ R16G16_SNORM ̒l.
+  void OctahedralEncode(const float* normal, int16_t* out);
+
+  // float -> half (IEEE754 binary16). R16G16_SFLOAT .
+  uint16_t FloatToHalf(float v);
+
+  // [0,1] ̒l UNORM ɗʎq.
+  uint16_t QuantizeUnorm16(float v);
+  uint8_t QuantizeUnorm8(float v);
+
+  // [-1,1] ̒l SNORM16 ɗʎq.
+  int16_t QuantizeSnorm16(float v);
+
+  // v 1 ̃EFCg 4 Av 255 ƂȂ悤 UNORM8 ֗ʎq.
+  void QuantizeWeights(const float* weights, uint8_t* out);
+}
@@ -1,10 +1,97 @@
 #include "VulkanAppBase.h"
 #include "VulkanBookUtil.h"
+#include "VertexCompression.h"
+#include "KtxTexture.h"
 
 #include "imgui.h"
 #include "backends/imgui_impl_vulkan.h"
 #include "backends/imgui_impl_glfw.h"
 
+#include <cstdlib>
+#include <cstring>
+
+// stb_image ̊mېXe[WOXũA[iɌ.
+// LoadTexture A[iݒ肵ĂԂ́AfR[hʂ̂܂܃Xe[WOobt@ɏoオ.
+// A[iɎ܂ȂƁAA[iݒ莞̓q[vmۂ.
+struct StbArena
+{
+  uint8_t* base = nullptr;
+  size_t capacity = 0;
+  size_t offset = 0;
+  uint32_t heapAllocations = 0;
+
+  bool Contains(const void* p) const
+  {
+    auto u = static_cast<const uint8_t*>(p);
+    return base != nullptr && u >= base && u < base + capacity;
+  }
+};
+static thread_local StbArena* s_stbArena = nullptr;
+// emۂ̒OɃTCYu. 16 oCgEۂ 16 oCgg.
+static const size_t StbArenaHeaderSize = 16;
+
+static void* StbArenaMalloc(size_t size)
+{
+  auto arena = s_stbArena;
+  if (arena) {
+    size_t head = arena->offset;
+    size_t end = (head + StbArenaHeaderSize + size + 15) & ~size_t(15);
+    if (end <= arena->capacity) {
+      memcpy(arena->base + head, &size, sizeof(size));
+      arena->offset = end;
+      return arena->base + head + StbArenaHeaderSize;
+    }
+    arena->heapAllocations++;
+  }
+  return malloc(size);
+}
+static void StbArenaFree(void* p)
+{
+  auto arena = s_stbArena;
+  if (arena && arena->Contains(p)) {
+    // Ō̊mۂȂ犪߂. ȊO̓A[iƎ̂Ă̂ŉȂ.
+    size_t size;
+    auto header = static_cast<uint8_t*>(p) - StbArenaHeaderSize;
+    memcpy(&size, header, sizeof(size));
+    size_t end = (size_t(header - arena->base) + StbArenaHeaderSize + size + 15) & ~size_t(15);
+    if (end == arena->offset) {
+      arena->offset = size_t(header - arena->base);
+    }
+    return;
+  }
+  free(p);
+}
+static void* StbArenaRealloc(void* p, size_t newSize)
+{
+  auto arena = s_stbArena;
+  if (p == nullptr) {
+    return StbArenaMalloc(newSize);
+  }
+  if (arena && arena->Contains(p)) {
+    size_t size;
+    auto header = static_cast<uint8_t*>(p) - StbArenaHeaderSize;
+    memcpy(&size, header, sizeof(size));
+    size_t begin = size_t(header - arena->base);
+    size_t end = (begin + StbArenaHeaderSize + size + 15) & ~size_t(15);
+    size_t newEnd = (begin + StbArenaHeaderSize + newSize + 15) & ~size_t(15);
+    if (end == arena->offset && newEnd <= arena->capacity) {
+      // ̊mۂ͂̏ŐL΂.
+      memcpy(header, &newSize, sizeof(newSize));
+      arena->offset = newEnd;
+      return p;
+    }
+    auto q = StbArenaMalloc(newSize);
+    if (q) {
+      memcpy(q, p, std::min(size, newSize));
+    }
+    return q;
+  }
+  return realloc(p, newSize);
+}
+
+#define STBI_MALLOC(sz) StbArenaMalloc(sz)
+#define STBI_REALLOC(p, newsz) StbArenaRealloc(p, newsz)
+#define STBI_FREE(p) StbArenaFree(p)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -12,6 +99,9 @@
 #include <vector>
 #include <sstream>
 #include <stack>
+#include <cfloat>
+#include <cmath>
+#include <cwctype>
 
 #include <glm/gtc/type_ptr.hpp>
 
@@ -103,50 +193,453 @@ static glm::mat4 ConvertMatrix(const aiMatrix4x4& mtx)
   return glm::transpose(m);
 }
 
-struct KTXHeader {
-  char identifier[12];
-  char endianness[4] = { 1, 2, 3, 4 };
-  uint32_t glType;
-  uint32_t glTypeSize;
-  uint32_t glFormat;
-  uint32_t glInternalFormat;
-  uint32_t glBaseInternalFormat;
-  uint32_t pixelWidth;
-  uint32_t pixelHeight;
-  uint32_t pixelDepth;
-  uint32_t numberOfArrayElements;
-  uint32_t numberOfFaces;
-  uint32_t numberOfMipmapLevels;
-  uint32_t bytesOfKeyValueData;
+static bool IsNearlyEqual(const glm::mat4& a, const glm::mat4& b, float epsilon = 1.0e-5f)
+{
+  for (int c = 0; c < 4; ++c) {
+    for (int r = 0; r < 4; ++r) {
+      if (std::abs(a[c][r] - b[c][r]) > epsilon) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// bVœKʂ̃LbVt@C.
+struct MeshCacheHeader {
+  char magic[4] = { 'M', 'O', 'P', 'T' };
+  uint32_t version = 1;
+  uint64_t sourceFileSize = 0;
+  int64_t sourceWriteTime = 0;
+  uint32_t optionFlags = 0;
+  uint32_t batchCount = 0;
+};
+struct MeshCacheBatch {
+  uint32_t sourceVertexCount;
+  uint32_t sourceIndexCount;
+  std::vector<uint32_t> vertexOrder;
+  std::vector<uint32_t> indices;
+};
+// vf̓t@C̒lȂ̂ŁAmۂOɃt@C̎c (fileSize ܂) Ɏ܂邩m߂.
+template<class T>
+static bool ReadMeshCacheArray(std::ifstream& infile, std::vector<T>& v, uint64_t fileSize)
+{
+  uint32_t count = 0;
+  infile.read(reinterpret_cast<char*>(&count), sizeof(count));
+  if (!infile) {
+    return false;
+  }
+  auto pos = infile.tellg();
+  if (pos == std::streampos(-1) || uint64_t(pos) > fileSize || uint64_t(count) * sizeof(T) > fileSize - uint64_t(pos)) {
+    return false;
+  }
+  v.resize(count);
+  infile.read(reinterpret_cast<char*>(v.data()), sizeof(T) * count);
+  return bool(infile);
+}
+template<class T>
+static void WriteMeshCacheArray(std::ofstream& outfile, const std::vector<T>& v)
+{
+  uint32_t count = uint32_t(v.size());
+  outfile.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  outfile.write(reinterpret_cast<const char*>(v.data()), sizeof(T) * count);
+}
+
+static uint32_t EffectiveAttributeMask(const VulkanAppBase::ModelLoadOptions& options)
+{
+  return options.attributeMask | VulkanAppBase::VertexAttributeBit(VulkanAppBase::VertexAttribute_Position);
+}
+
+static MeshCacheHeader MakeMeshCacheHeader(const std::filesystem::path& fileName, const VulkanAppBase::ModelLoadOptions& options)
+{
+  MeshCacheHeader header{};
+  std::error_code ec;
+  header.sourceFileSize = std::filesystem::file_size(fileName, ec);
+  header.sourceWriteTime = int64_t(std::filesystem::last_write_time(fileName, ec).time_since_epoch().count());
+  // dɎgXg[ςƌʂς̂ő}XN܂߂.
+  header.optionFlags = (options.optimizeOverdraw ? 1u : 0u) | (EffectiveAttributeMask(options) << 8);
+  return header;
+}
+
+static bool ReadMeshCache(const std::filesystem::path& cacheFileName, const MeshCacheHeader& expect, std::vector<MeshCacheBatch>& batches)
+{
+  std::error_code ec;
+  const auto fileSize = uint64_t(std::filesystem::file_size(cacheFileName, ec));
+  std::ifstream infile(cacheFileName, std::ios::binary);
+  if (ec || !infile) {
+    return false;
+  }
+  MeshCacheHeader header{};
+  infile.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!infile ||
+    memcmp(header.magic, expect.magic, sizeof(header.magic)) != 0 ||
+    header.version != expect.version ||
+    header.sourceFileSize != expect.sourceFileSize ||
+    header.sourceWriteTime != expect.sourceWriteTime ||
+    header.optionFlags != expect.optionFlags ||
+    header.batchCount != expect.batchCount) {
+    return false;
+  }
+  batches.resize(header.batchCount);
+  for (auto& batch : batches) {
+    infile.read(reinterpret_cast<char*>(&batch.sourceVertexCount), sizeof(batch.sourceVertexCount));
+    infile.read(reinterpret_cast<char*>(&batch.sourceIndexCount), sizeof(batch.sourceIndexCount));
+    if (!infile || !ReadMeshCacheArray(infile, batch.vertexOrder, fileSize) || !ReadMeshCacheArray(infile, batch.indices, fileSize)) {
+      batches.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+// LbV̓ê܂ܒ_̕בւƃCfbNXɎĝŁA͈͊OwĂȂm߂.
+static bool IsValidMeshCacheBatch(const MeshCacheBatch& batch, uint32_t vertexCount)
+{
+  if (batch.indices.size() % 3 != 0) {
+    return false;
+  }
+  for (auto v : batch.vertexOrder) {
+    if (v >= vertexCount) {
+      return false;
+    }
+  }
+  for (auto i : batch.indices) {
+    if (i >= batch.vertexOrder.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void WriteMeshCache(const std::filesystem::path& cacheFileName, MeshCacheHeader header, const std::vector<MeshCacheBatch>& batches)
+{
+  std::ofstream outfile(cacheFileName, std::ios::binary);
+  if (!outfile) {
+    return;
+  }
+  header.batchCount = uint32_t(batches.size());
+  outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& batch : batches) {
+    outfile.write(reinterpret_cast<const char*>(&batch.sourceVertexCount), sizeof(batch.sourceVertexCount));
+    outfile.write(reinterpret_cast<const char*>(&batch.sourceIndexCount), sizeof(batch.sourceIndexCount));
+    WriteMeshCacheArray(outfile, batch.vertexOrder);
+    WriteMeshCacheArray(outfile, batch.indices);
+  }
+}
+
+// 1 bṼCfbNXœKAvertexOrder[V_ԍ] = ̒_ԍ Ԃ.
+static std::vector<uint32_t> OptimizeMeshIndices(
+  std::vector<uint32_t>& indices, uint32_t vertexCount,
+  const std::vector<mesh_optimizer::VertexStream>& streams,
+  const glm::vec3* positions, bool optimizeOverdraw)
+{
+  std::vector<uint32_t> remap;
+  auto uniqueCount = mesh_optimizer::GenerateVertexRemap(remap, indices, vertexCount, streams);
+  mesh_optimizer::RemapIndexBuffer(indices, remap);
+  mesh_optimizer::OptimizeVertexCache(indices, uniqueCount);
+
+  if (optimizeOverdraw) {
+    auto uniqueOrder = mesh_optimizer::BuildVertexOrder(remap, uniqueCount);
+    std::vector<glm::vec3> uniquePositions(uniqueCount);
+    for (uint32_t i = 0; i < uniqueCount; ++i) {
+      uniquePositions[i] = positions[uniqueOrder[i]];
+    }
+    mesh_optimizer::OptimizeOverdraw(indices, &uniquePositions[0].x, sizeof(glm::vec3), uniqueCount);
+  }
+
+  std::vector<uint32_t> fetchRemap;
+  auto fetchCount = mesh_optimizer::OptimizeVertexFetchRemap(fetchRemap, indices, uniqueCount);
+  // ̒_ -> d -> tFb` .
+  for (auto& r : remap) {
+    if (r != ~0u) {
+      r = fetchRemap[r];
+    }
+  }
+  return mesh_optimizer::BuildVertexOrder(remap, fetchCount);
+}
+
+static std::string MakeModelDatabaseKey(const std::filesystem::path& fileName, const VulkanAppBase::ModelLoadOptions& options)
+{
+  std::stringstream ss;
+  ss << std::filesystem::absolute(fileName).string() << "|"
+    << options.useFlipUV << options.optimizeMesh << options.optimizeOverdraw
+    << options.compactVertexFormat << options.quantizePositions << "|"
+    << options.vertexLayout << "|" << options.attributeMask << "|" << options.useGeometryPool << "|"
+    << options.compressAnimations;
+  if (options.compressAnimations) {
+    const auto& c = options.animationCompression;
+    ss << c.translationTolerance << "," << c.rotationTolerance << "," << c.scaleTolerance << "," << c.maxKeySpan;
+  }
+  return ss.str();
+}
+
+// aiAnimation sp̃Aj[VNbvɕϊ. Ԃ͕bPʂɂ.
+static VulkanAppBase::AnimationClip ConvertAnimation(const aiAnimation* anim, const NodeNameTable& utf8NodeNames)
+{
+  VulkanAppBase::AnimationClip clip;
+  clip.name = ConvertFromUTF8(anim->mName.C_Str());
+  // mTicksPerSecond  0 ̃t@C 25 ƂĈ̂ Assimp ̊.
+  double ticksPerSecond = anim->mTicksPerSecond != 0.0 ? anim->mTicksPerSecond : 25.0;
+  clip.duration = float(anim->mDuration / ticksPerSecond);
+  clip.channels.reserve(anim->mNumChannels);
+  for (uint32_t i = 0; i < anim->mNumChannels; ++i) {
+    const auto* src = anim->mChannels[i];
+    VulkanAppBase::AnimationChannel ch;
+    ch.nodeName = ConvertFromUTF8(src->mNodeName.C_Str());
+    ch.node = utf8NodeNames.Find(src->mNodeName.data, src->mNodeName.length);
+    // ƒlʁX̔zɋl߂. TvɎ̔z񂾂ɓǂ߂΃L[T.
+    ch.positionTimes.resize(src->mNumPositionKeys);
+    ch.positions.resize(src->mNumPositionKeys);
+    for (uint32_t k = 0; k < src->mNumPositionKeys; ++k) {
+      const auto& key = src->mPositionKeys[k];
+      ch.positionTimes[k] = float(key.mTime / ticksPerSecond);
+      ch.positions[k] = glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z);
+    }
+    ch.rotationTimes.resize(src->mNumRotationKeys);
+    ch.rotations.resize(src->mNumRotationKeys);
+    for (uint32_t k = 0; k < src->mNumRotationKeys; ++k) {
+      const auto& key = src->mRotationKeys[k];
+      ch.rotationTimes[k] = float(key.mTime / ticksPerSecond);
+      ch.rotations[k] = glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z);
+    }
+    ch.scaleTimes.resize(src->mNumScalingKeys);
+    ch.scales.resize(src->mNumScalingKeys);
+    for (uint32_t k = 0; k < src->mNumScalingKeys; ++k) {
+      const auto& key = src->mScalingKeys[k];
+      ch.scaleTimes[k] = float(key.mTime / ticksPerSecond);
+      ch.scales[k] = glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z);
+    }
+    clip.channels.push_back(std::move(ch));
+  }
+  return clip;
+}
+
+// kAj[ṼLbVt@C. wb_[̌ animation::WriteCompressedClip ̌`ŃNbv.
+// ̂܂܏ôŁAlߕłȂ悤Iȃo[Ŗ߂.
+struct AnimationCacheHeader {
+  char magic[4] = { 'A', 'C', 'M', 'P' };
+  uint32_t version = 1;
+  uint64_t sourceFileSize = 0;
+  int64_t sourceWriteTime = 0;
+  animation::CompressionSettings settings;
+  uint32_t clipCount = 0;
+  uint32_t reserved = 0;
 };
-static std::vector<char> ktx_load(const char* fileName, int* width, int* height) {
-  std::ifstream infile(fileName, std::ios::binary);
-  std::vector<char> imageData;
+static_assert(sizeof(AnimationCacheHeader) == 48, "AnimationCacheHeader must not contain padding.");
+
+static bool IsSameCompressionSettings(const animation::CompressionSettings& a, const animation::CompressionSettings& b)
+{
+  return a.translationTolerance == b.translationTolerance &&
+    a.rotationTolerance == b.rotationTolerance &&
+    a.scaleTolerance == b.scaleTolerance &&
+    a.maxKeySpan == b.maxKeySpan;
+}
+
+static AnimationCacheHeader MakeAnimationCacheHeader(const std::filesystem::path& fileName, const animation::CompressionSettings& settings)
+{
+  AnimationCacheHeader header{};
+  std::error_code ec;
+  header.sourceFileSize = std::filesystem::file_size(fileName, ec);
+  header.sourceWriteTime = int64_t(std::filesystem::last_write_time(fileName, ec).time_since_epoch().count());
+  header.settings = settings;
+  return header;
+}
 
+static bool ReadAnimationCache(const std::filesystem::path& cacheFileName, const AnimationCacheHeader& expect, std::vector<animation::CompressedClip>& clips)
+{
+  std::ifstream infile(cacheFileName, std::ios::binary);
   if (!infile) {
-    return imageData;
+    return false;
+  }
+  AnimationCacheHeader header{};
+  infile.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!infile ||
+    memcmp(header.magic, expect.magic, sizeof(header.magic)) != 0 ||
+    header.version != expect.version ||
+    header.sourceFileSize != expect.sourceFileSize ||
+    header.sourceWriteTime != expect.sourceWriteTime ||
+    !IsSameCompressionSettings(header.settings, expect.settings) ||
+    header.clipCount != expect.clipCount) {
+    return false;
+  }
+  clips.resize(header.clipCount);
+  for (auto& clip : clips) {
+    if (!animation::ReadCompressedClip(infile, clip)) {
+      clips.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+static void WriteAnimationCache(const std::filesystem::path& cacheFileName, AnimationCacheHeader header, const std::vector<animation::CompressedClip>& clips)
+{
+  std::ofstream outfile(cacheFileName, std::ios::binary);
+  if (!outfile) {
+    return;
+  }
+  header.clipCount = uint32_t(clips.size());
+  outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& clip : clips) {
+    animation::WriteCompressedClip(outfile, clip);
+  }
+}
+
+// Assimp ĂL[̃TCY ( double).
+static size_t GetAssimpAnimationSize(const aiAnimation* anim)
+{
+  size_t size = sizeof(aiAnimation);
+  for (uint32_t i = 0; i < anim->mNumChannels; ++i) {
+    const auto* ch = anim->mChannels[i];
+    size += sizeof(aiNodeAnim);
+    size += ch->mNumPositionKeys * sizeof(aiVectorKey) + ch->mNumRotationKeys * sizeof(aiQuatKey) + ch->mNumScalingKeys * sizeof(aiVectorKey);
+  }
+  return size;
+}
+
+// RpNg_tH[}bgɕϊ.
+struct CompactVertexData {
+  std::vector<uint8_t> streams[VulkanAppBase::VertexAttribute_Count];
+  std::vector<uint8_t> indices;
+};
+
+template<class T>
+static void AppendBytes(std::vector<uint8_t>& dst, const T* src, size_t count)
+{
+  const auto* p = reinterpret_cast<const uint8_t*>(src);
+  dst.insert(dst.end(), p, p + sizeof(T) * count);
+}
+
+static void BuildCompactVertexData(
+  VulkanAppBase::ModelAsset& model, bool quantizePositions,
+  const std::vector<uint32_t>& batchVertexCounts,
+  const std::vector<glm::vec3>& vbPos, const std::vector<glm::vec3>& vbNrm,
+  const std::vector<glm::vec2>& vbUV0, const std::vector<glm::vec3>& vbTan,
+  const std::vector<glm::ivec4>& vbBIndices, const std::vector<glm::vec4>& vbBWeights,
+  const std::vector<uint32_t>& ibIndices,
+  CompactVertexData& compact)
+{
+  using namespace vertex_compression;
+  auto& formats = model.vertexFormats;
+  auto& sizes = model.attributeSizes;
+  const auto vertexCount = vbPos.size();
+  model.compactVertexFormat = true;
+
+  // ʒu: DrawBatch Ƃ AABB  16bit ʎq (w  1.0 Œ).
+  auto& pos = compact.streams[VulkanAppBase::VertexAttribute_Position];
+  if (quantizePositions) {
+    formats[VulkanAppBase::VertexAttribute_Position] = VK_FORMAT_R16G16B16A16_UNORM;
+    sizes[VulkanAppBase::VertexAttribute_Position] = sizeof(uint16_t) * 4;
+    pos.reserve(sizeof(uint16_t) * 4 * vertexCount);
+    for (size_t b = 0; b < model.DrawBatches.size(); ++b) {
+      auto& batch = model.DrawBatches[b];
+      auto start = batch.vertexOffsetCount;
+      auto count = batchVertexCounts[b];
+      glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+      for (uint64_t v = start; v < start + count; ++v) {
+        bmin = glm::min(bmin, vbPos[v]);
+        bmax = glm::max(bmax, vbPos[v]);
+      }
+      glm::vec3 extent = count > 0 ? glm::max(bmax - bmin, glm::vec3(1e-6f)) : glm::vec3(1.0f);
+      batch.positionScale = glm::vec4(extent, 1.0f);
+      batch.positionOffset = glm::vec4(count > 0 ? bmin : glm::vec3(0.0f), 0.0f);
+      for (uint64_t v = start; v < start + count; ++v) {
+        auto t = (vbPos[v] - bmin) / extent;
+        uint16_t q[4] = { QuantizeUnorm16(t.x), QuantizeUnorm16(t.y), QuantizeUnorm16(t.z), 0xFFFF };
+        AppendBytes(pos, q, 4);
+      }
+    }
+  } else {
+    AppendBytes(pos, vbPos.data(), vertexCount);
   }
-  std::vector<char> fileHeader(sizeof(KTXHeader));
-  infile.read(fileHeader.data(), fileHeader.size());
 
-  const unsigned char ktxIdentifier[] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
-  const auto* header = reinterpret_cast<const KTXHeader*>(fileHeader.data());
-  if (memcmp(ktxIdentifier, header->identifier, sizeof(ktxIdentifier)) != 0) {
-    return imageData;
+  // @/ڐ: ʑ̃GR[h.
+  auto encodeOctahedral = [&](const std::vector<glm::vec3>& src, VulkanAppBase::VertexAttribute attr) {
+    auto& dst = compact.streams[attr];
+    formats[attr] = VK_FORMAT_R16G16_SNORM;
+    sizes[attr] = sizeof(int16_t) * 2;
+    dst.reserve(sizeof(int16_t) * 2 * vertexCount);
+    for (const auto& n : src) {
+      int16_t e[2];
+      OctahedralEncode(&n.x, e);
+      AppendBytes(dst, e, 2);
+    }
+  };
+  encodeOctahedral(vbNrm, VulkanAppBase::VertexAttribute_Normal);
+  encodeOctahedral(vbTan, VulkanAppBase::VertexAttribute_Tangent);
+
+  // UV: [0,1] Ɏ܂Ă UNORM16A^CÔ half.
+  bool uvInUnitRange = std::all_of(vbUV0.begin(), vbUV0.end(), [](const glm::vec2& uv) {
+    return uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f;
+  });
+  auto& uv0 = compact.streams[VulkanAppBase::VertexAttribute_UV0];
+  formats[VulkanAppBase::VertexAttribute_UV0] = uvInUnitRange ? VK_FORMAT_R16G16_UNORM : VK_FORMAT_R16G16_SFLOAT;
+  sizes[VulkanAppBase::VertexAttribute_UV0] = sizeof(uint16_t) * 2;
+  uv0.reserve(sizeof(uint16_t) * 2 * vertexCount);
+  for (const auto& uv : vbUV0) {
+    uint16_t e[2];
+    if (uvInUnitRange) {
+      e[0] = QuantizeUnorm16(uv.x);
+      e[1] = QuantizeUnorm16(uv.y);
+    } else {
+      e[0] = FloatToHalf(uv.x);
+      e[1] = FloatToHalf(uv.y);
+    }
+    AppendBytes(uv0, e, 2);
   }
 
-  *width = header->pixelWidth;
-  *height = header->pixelHeight;
+  // {[: CfbNX DrawBatch ̔ԍȂ̂ 256 Ȃ 8bit.
+  if (!vbBIndices.empty()) {
+    size_t maxBones = 0;
+    for (const auto& batch : model.DrawBatches) {
+      maxBones = std::max(maxBones, batch.boneRemap.size());
+    }
+    auto& indices = compact.streams[VulkanAppBase::VertexAttribute_BoneIndices];
+    if (maxBones <= 256) {
+      formats[VulkanAppBase::VertexAttribute_BoneIndices] = VK_FORMAT_R8G8B8A8_UINT;
+      sizes[VulkanAppBase::VertexAttribute_BoneIndices] = sizeof(uint8_t) * 4;
+      for (const auto& v : vbBIndices) {
+        uint8_t e[4] = { uint8_t(v.x), uint8_t(v.y), uint8_t(v.z), uint8_t(v.w) };
+        AppendBytes(indices, e, 4);
+      }
+    } else {
+      formats[VulkanAppBase::VertexAttribute_BoneIndices] = VK_FORMAT_R16G16B16A16_UINT;
+      sizes[VulkanAppBase::VertexAttribute_BoneIndices] = sizeof(uint16_t) * 4;
+      for (const auto& v : vbBIndices) {
+        uint16_t e[4] = { uint16_t(v.x), uint16_t(v.y), uint16_t(v.z), uint16_t(v.w) };
+        AppendBytes(indices, e, 4);
+      }
+    }
+
+    auto& weights = compact.streams[VulkanAppBase::VertexAttribute_BoneWeights];
+    formats[VulkanAppBase::VertexAttribute_BoneWeights] = VK_FORMAT_R8G8B8A8_UNORM;
+    sizes[VulkanAppBase::VertexAttribute_BoneWeights] = sizeof(uint8_t) * 4;
+    for (const auto& w : vbBWeights) {
+      uint8_t e[4];
+      QuantizeWeights(&w.x, e);
+      AppendBytes(weights, e, 4);
+    }
+  }
 
-  // Float 32bit ̃eNX`̂݃T|[g.
-  if (header->glInternalFormat != 0x8814 /*GL_RGBA32F*/) {
-    return imageData;
+  // CfbNX: DrawBatch ̒_ 65536 ȉȂ 16bit.
+  // 1 ̃obt@ɍ݂̂ŁAe DrawBatch ̊JnʒuoCgPʂŎ.
+  for (size_t b = 0; b < model.DrawBatches.size(); ++b) {
+    auto& batch = model.DrawBatches[b];
+    const auto* src = ibIndices.data() + batch.indexOffsetCount;
+    if (batchVertexCounts[b] <= 0x10000) {
+      batch.indexType = VK_INDEX_TYPE_UINT16;
+      batch.indexBufferOffset = compact.indices.size();
+      for (uint32_t i = 0; i < batch.indexCount; ++i) {
+        auto index = uint16_t(src[i]);
+        AppendBytes(compact.indices, &index, 1);
+      }
+    } else {
+      compact.indices.resize((compact.indices.size() + 3) & ~size_t(3));
+      batch.indexType = VK_INDEX_TYPE_UINT32;
+      batch.indexBufferOffset = compact.indices.size();
+      AppendBytes(compact.indices, src, batch.indexCount);
+    }
   }
-  uint32_t imageSize = 0;
-  infile.read((char*)&imageSize, sizeof(imageSize));
-  imageData.resize(imageSize);
-  infile.read(imageData.data(), imageSize);
-  return imageData;
 }
 
 bool VulkanAppBase::OnSizeChanged(uint32_t width, uint32_t height)
@@ -251,6 +744,7 @@ void VulkanAppBase::Initialize(GLFWwindow* window, VkFormat format, bool isFulls
   // ŏ̃foCXgp.
   m_physicalDevice = physicalDevices[0];
   vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_physicalMemProps);
+  DetectDeviceMemoryMode();
 
   // OtBbNX̃L[CfbNX擾.
   SelectGraphicsQueue();
@@ -319,10 +813,26 @@ void VulkanAppBase::Terminate()
   DisableDebugReport();
 #endif
 
+  // R̃fcĂĂobt@͔j.
+  while (!m_modelDatabase.empty()) {
+    auto key = m_modelDatabase.begin()->first;
+    m_modelDatabase.begin()->second.refCount = 1;
+    ReleaseModelGeometry(key);
+  }
   for (auto& t : m_textureDatabase) {
-    DestroyImage(t.second);
+    DestroyImage(t.second.image);
   }
   m_textureDatabase.clear();
+  m_textureKeys.clear();
+  DestroyPendingTextures(true);
+  DestroyStagingSlabs();
+  for (auto& pool : m_geometryPools) {
+    for (auto& b : pool.vertexBuffers) {
+      DestroyBuffer(b);
+    }
+    DestroyBuffer(pool.indexBuffer);
+  }
+  m_geometryPools.clear();
 
   m_renderPassStore->Cleanup();
   m_descriptorSetLayoutStore->Cleanup();
@@ -340,8 +850,13 @@ void VulkanAppBase::Terminate()
   m_vkInstance = VK_NULL_HANDLE;
 }
 
-VulkanAppBase::BufferObject VulkanAppBase::CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
+VulkanAppBase::BufferObject VulkanAppBase::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
 {
+  if (size > m_maxMemoryAllocationSize) {
+    std::stringstream ss;
+    ss << "CreateBuffer: " << size << " bytes exceeds maxMemoryAllocationSize (" << m_maxMemoryAllocationSize << ").";
+    throw book_util::VulkanException(ss.str());
+  }
   BufferObject obj;
   VkBufferCreateInfo bufferCI{
     VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -362,21 +877,94 @@ VulkanAppBase::BufferObject VulkanAppBase::CreateBuffer(uint32_t size, VkBufferU
     reqs.size,
     GetMemoryTypeIndex(reqs.memoryTypeBits, props)
   };
-  vkAllocateMemory(m_device, &info, nullptr, &obj.memory);
+  if (info.memoryTypeIndex >= m_physicalMemProps.memoryTypeCount) {
+    vkDestroyBuffer(m_device, obj.buffer, nullptr);
+    throw book_util::VulkanException("CreateBuffer: no memory type matches the requested properties.");
+  }
+  auto heapSize = m_physicalMemProps.memoryHeaps[m_physicalMemProps.memoryTypes[info.memoryTypeIndex].heapIndex].size;
+  if (reqs.size > heapSize) {
+    vkDestroyBuffer(m_device, obj.buffer, nullptr);
+    std::stringstream ss;
+    ss << "CreateBuffer: " << reqs.size << " bytes exceeds the memory heap (" << heapSize << ").";
+    throw book_util::VulkanException(ss.str());
+  }
+  result = vkAllocateMemory(m_device, &info, nullptr, &obj.memory);
+  if (result != VK_SUCCESS) {
+    vkDestroyBuffer(m_device, obj.buffer, nullptr);
+  }
+  ThrowIfFailed(result, "vkAllocateMemory Failed.");
   vkBindBufferMemory(m_device, obj.buffer, obj.memory, 0);
   obj.size = size;
+  obj.memoryProps = m_physicalMemProps.memoryTypes[info.memoryTypeIndex].propertyFlags;
   return obj;
 }
 
-VulkanAppBase::ImageObject VulkanAppBase::CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkMemoryPropertyFlags memPropsFlags)
+void VulkanAppBase::DetectDeviceMemoryMode()
+{
+  // 1  vkAllocateMemory Ŋmۂł (Vulkan 1.1).
+  VkPhysicalDeviceMaintenance3Properties maintenance3{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_3_PROPERTIES };
+  VkPhysicalDeviceProperties2 props2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+  props2.pNext = &maintenance3;
+  vkGetPhysicalDeviceProperties2(m_physicalDevice, &props2);
+  const auto& props = props2.properties;
+  m_maxMemoryAllocationSize = maintenance3.maxMemoryAllocationSize;
+  // Rq[g̃tbV͈͂͂̒PʂɑKv.
+  m_nonCoherentAtomSize = std::max<VkDeviceSize>(props.limits.nonCoherentAtomSize, 1);
+
+  VkDeviceSize largestDeviceLocalHeap = 0;
+  for (uint32_t i = 0; i < m_physicalMemProps.memoryHeapCount; ++i) {
+    const auto& heap = m_physicalMemProps.memoryHeaps[i];
+    if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+      largestDeviceLocalHeap = std::max(largestDeviceLocalHeap, heap.size);
+    }
+  }
+
+  // DEVICE_LOCAL | HOST_VISIBLE | HOST_COHERENT ̃^CvT.
+  // fBXN[g GPU ł͏] 256MB  BAR ̑̂ŁAq[v VRAM ̑唼߂Ƃg.
+  const VkMemoryPropertyFlags direct =
+    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  m_deviceMemoryMode = DeviceMemoryMode_Discrete;
+  VkDeviceSize directHeapSize = 0;
+  for (uint32_t i = 0; i < m_physicalMemProps.memoryTypeCount; ++i) {
+    const auto& type = m_physicalMemProps.memoryTypes[i];
+    if ((type.propertyFlags & direct) != direct) {
+      continue;
+    }
+    directHeapSize = m_physicalMemProps.memoryHeaps[type.heapIndex].size;
+    if (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+      m_deviceMemoryMode = DeviceMemoryMode_Unified;
+    } else if (directHeapSize >= largestDeviceLocalHeap / 10 * 9) {
+      m_deviceMemoryMode = DeviceMemoryMode_ResizableBar;
+    }
+    break;
+  }
+
+  const char* modeNames[] = { "discrete (staging)", "unified memory (direct)", "resizable BAR (direct)" };
+  std::stringstream ss;
+  ss << "[Upload] " << props.deviceName << ": " << modeNames[m_deviceMemoryMode]
+    << ", host visible device local heap " << (directHeapSize >> 20) << " MB / device local " << (largestDeviceLocalHeap >> 20) << " MB"
+    << ", max allocation " << (m_maxMemoryAllocationSize >> 20) << " MB" << std::endl;
+  OutputDebugStringA(ss.str().c_str());
+}
+
+VkMemoryPropertyFlags VulkanAppBase::GetUploadTargetMemoryProps() const
+{
+  if (IsDirectUploadEnabled()) {
+    return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  }
+  return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+}
+
+VulkanAppBase::ImageObject VulkanAppBase::CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkMemoryPropertyFlags memPropsFlags, uint32_t mipLevels)
 {
   ImageObject obj;
+  obj.mipLevels = mipLevels;
   VkImageCreateInfo imageCI{
     VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
     nullptr, 0,
     VK_IMAGE_TYPE_2D,
     format, { width, height, 1 },
-    1, 1, VK_SAMPLE_COUNT_1_BIT,
+    mipLevels, 1, VK_SAMPLE_COUNT_1_BIT,
     VK_IMAGE_TILING_OPTIMAL,
     usage,
     VK_SHARING_MODE_EXCLUSIVE,
@@ -412,7 +1000,50 @@ VulkanAppBase::ImageObject VulkanAppBase::CreateTexture(uint32_t width, uint32_t
     VK_IMAGE_VIEW_TYPE_2D,
     imageCI.format,
     book_util::DefaultComponentMapping(),
-    { imageAspect, 0, 1, 0, 1}
+    { imageAspect, 0, mipLevels, 0, 1}
+  };
+  result = vkCreateImageView(m_device, &viewCI, nullptr, &obj.view);
+  ThrowIfFailed(result, "vkCreateImageView Failed.");
+  return obj;
+}
+
+VulkanAppBase::ImageObject VulkanAppBase::CreateTextureLayered(uint32_t width, uint32_t height, uint32_t depth, VkFormat format, VkImageUsageFlags usage, uint32_t mipLevels, uint32_t arrayLayers, VkImageViewType viewType)
+{
+  ImageObject obj;
+  obj.width = width;
+  obj.height = height;
+  obj.format = format;
+  obj.mipLevels = mipLevels;
+  obj.arrayLayers = arrayLayers;
+  VkImageCreateInfo imageCI{
+    VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+    nullptr, 0,
+    viewType == VK_IMAGE_VIEW_TYPE_3D ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D,
+    format, { width, height, depth },
+    mipLevels, arrayLayers, VK_SAMPLE_COUNT_1_BIT,
+    VK_IMAGE_TILING_OPTIMAL,
+    usage,
+    VK_SHARING_MODE_EXCLUSIVE,
+    0, nullptr,
+    VK_IMAGE_LAYOUT_UNDEFINED
+  };
+  if (viewType == VK_IMAGE_VIEW_TYPE_CUBE || viewType == VK_IMAGE_VIEW_TYPE_CUBE_ARRAY) {
+    imageCI.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+  }
+  auto result = vkCreateImage(m_device, &imageCI, nullptr, &obj.image);
+  ThrowIfFailed(result, "vkCreateImage Failed.");
+
+  obj.memory = AllocateMemory(obj.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  vkBindImageMemory(m_device, obj.image, obj.memory, 0);
+
+  VkImageViewCreateInfo viewCI{
+    VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+    nullptr, 0,
+    obj.image,
+    viewType,
+    imageCI.format,
+    book_util::DefaultComponentMapping(),
+    { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, arrayLayers }
   };
   result = vkCreateImageView(m_device, &viewCI, nullptr, &obj.view);
   ThrowIfFailed(result, "vkCreateImageView Failed.");
@@ -551,7 +1182,7 @@ VkRect2D VulkanAppBase::GetSwapchainRenderArea() const
   };
 }
 
-std::vector<VulkanAppBase::BufferObject> VulkanAppBase::CreateUniformBuffers(uint32_t bufferSize, uint32_t imageCount)
+std::vector<VulkanAppBase::BufferObject> VulkanAppBase::CreateUniformBuffers(VkDeviceSize bufferSize, uint32_t imageCount)
 {
   std::vector<BufferObject> buffers(imageCount);
   for (auto& b : buffers)
@@ -562,6 +1193,94 @@ std::vector<VulkanAppBase::BufferObject> VulkanAppBase::CreateUniformBuffers(uin
   return buffers;
 }
 
+std::vector<VulkanAppBase::BufferObject> VulkanAppBase::CreateStorageBuffers(VkDeviceSize bufferSize, uint32_t imageCount)
+{
+  std::vector<BufferObject> buffers(imageCount);
+  for (auto& b : buffers)
+  {
+    VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    b = CreateBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, props);
+  }
+  return buffers;
+}
+
+VkDeviceSize VulkanAppBase::UpdateBonePalette(ModelAsset& model, uint32_t imageIndex, SkinningMethod method)
+{
+  if (imageIndex >= model.boneMatrixPalette.size()) {
+    return 0;
+  }
+  return WriteBonePalette(model, model.boneMatrixPalette[imageIndex].memory, method);
+}
+
+VkDeviceSize VulkanAppBase::WriteBonePalette(const ModelAsset& model, VkDeviceMemory memory, SkinningMethod method)
+{
+  if (model.skeletonNodes.empty()) {
+    return 0;
+  }
+  // Ԃ̔z炸Ƀ}bv̈֒ڏ.
+  void* p;
+  vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &p);
+  auto written = ComposeBonePalette(model, model.nodes.GetWorldMatrices(), method, p);
+  VkMappedMemoryRange range{};
+  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  range.memory = memory;
+  range.offset = 0;
+  range.size = VK_WHOLE_SIZE;
+  vkFlushMappedMemoryRanges(m_device, 1, &range);
+  vkUnmapMemory(m_device, memory);
+  return written;
+}
+
+VkDeviceSize VulkanAppBase::GetBonePaletteStride(SkinningMethod method)
+{
+  return method == SkinningMethod_DualQuaternion ? sizeof(glm::vec4) * 2 : sizeof(glm::mat4);
+}
+
+VkDeviceSize VulkanAppBase::ComposeBonePalette(const ModelAsset& model, const glm::mat4* worldMatrices, SkinningMethod method, void* dst)
+{
+  const auto boneCount = model.skeletonNodes.size();
+  if (method == SkinningMethod_DualQuaternion) {
+    // VF[_[ vec4 (xyzw) 2 Ƃēǂ.
+    auto* dq4 = static_cast<glm::vec4*>(dst);
+    for (size_t i = 0; i < boneCount; ++i) {
+      auto mtx = model.invGlobalTransform * worldMatrices[model.skeletonNodes[i]] * model.skeletonOffsets[i];
+      auto dq = animation::MakeDualQuaternion(mtx);
+      dq4[i * 2 + 0] = glm::vec4(dq.real.x, dq.real.y, dq.real.z, dq.real.w);
+      dq4[i * 2 + 1] = glm::vec4(dq.dual.x, dq.dual.y, dq.dual.z, dq.dual.w);
+    }
+  } else {
+    auto* matrices = static_cast<glm::mat4*>(dst);
+    for (size_t i = 0; i < boneCount; ++i) {
+      matrices[i] = model.invGlobalTransform * worldMatrices[model.skeletonNodes[i]] * model.skeletonOffsets[i];
+    }
+  }
+  return GetBonePaletteStride(method) * boneCount;
+}
+
+uint64_t VulkanAppBase::HashSkeletonPose(const ModelAsset& model)
+{
+  // FNV-1a. s̗vfrbĝ܂ 32bit Pʂō.
+  uint64_t hash = 14695981039346656037ull;
+  const auto* worldMatrices = model.nodes.GetWorldMatrices();
+  for (auto node : model.skeletonNodes) {
+    uint32_t words[16];
+    memcpy(words, &worldMatrices[node], sizeof(words));
+    for (auto w : words) {
+      hash ^= w;
+      hash *= 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+void VulkanAppBase::CreateSkinnedVertexBuffer(ModelAsset& model)
+{
+  model.SkinnedVertices = CreateBuffer(
+    book_util::CheckedBufferSize(model.totalVertexCount, SkinnedVertexStride),
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
 void VulkanAppBase::WriteToHostVisibleMemory(VkDeviceMemory memory, uint64_t size, const void* pData)
 {
   void* p;
@@ -596,38 +1315,190 @@ void VulkanAppBase::FreeCommandBufferSecondary(uint32_t count, VkCommandBuffer*
 
 void VulkanAppBase::TransferStageBufferToImage(
   const BufferObject& srcBuffer, const ImageObject& dstImage, const VkBufferImageCopy* region)
-{ 
-  VkImageMemoryBarrier imb{
-    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
-    0, VK_ACCESS_TRANSFER_WRITE_BIT,
-    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-    dstImage.image,
-    { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+{
+  TransferStageBufferToImage(srcBuffer, dstImage, 1, region, false);
+}
+
+void VulkanAppBase::TransferStageBufferToImage(
+  const BufferObject& srcBuffer, const ImageObject& dstImage, uint32_t regionCount, const VkBufferImageCopy* regions, bool generateMipmaps)
+{
+  TextureUpload upload;
+  upload.srcBuffer = srcBuffer.buffer;
+  upload.dstImage = dstImage;
+  upload.regions.assign(regions, regions + regionCount);
+  upload.generateMipmaps = generateMipmaps;
+  TransferStageBuffersToImages({ upload });
+}
+
+void VulkanAppBase::TransferStageBuffersToImages(const std::vector<TextureUpload>& uploads)
+{
+  if (uploads.empty()) {
+    return;
+  }
+  auto fullRange = [](const ImageObject& image) {
+    return VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, image.mipLevels, 0, image.arrayLayers };
+  };
+  auto makeBarrier = [](VkImage image, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange range) {
+    return VkImageMemoryBarrier{
+      VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+      srcAccess, dstAccess,
+      oldLayout, newLayout,
+      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+      image, range
+    };
   };
 
-  // Staging ].
+  // VC[WȂ̂ňȑO̓e҂Kv͖. SC[W 1  TRANSFER_DST .
+  std::vector<VkImageMemoryBarrier> barriers;
+  for (const auto& u : uploads) {
+    barriers.push_back(makeBarrier(u.dstImage.image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, fullRange(u.dstImage)));
+  }
   auto command = CreateCommandBuffer();
   vkCmdPipelineBarrier(command,
-    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-    0, 0, nullptr,
-    0, nullptr, 1, &imb);
-
-  vkCmdCopyBufferToImage(
-    command, 
-    srcBuffer.buffer, dstImage.image,
-    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, region);
-  imb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-  imb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  imb.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-  imb.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+    0, 0, nullptr, 0, nullptr,
+    uint32_t(barriers.size()), barriers.data());
+
+  uint32_t regionCount = 0;
+  for (const auto& u : uploads) {
+    vkCmdCopyBufferToImage(command,
+      u.srcBuffer, u.dstImage.image,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(u.regions.size()), u.regions.data());
+    regionCount += uint32_t(u.regions.size());
+  }
+
+  // ~bv. 1 ̃x]ɂāASC[W̓x܂Ƃ߂ďkĂ.
+  // kɂx TRANSFER_SRC ̂܂܎cAŌ̑Jڂł܂Ƃ߂ăVF[_[ǂݎֈڂ.
+  uint32_t maxLevels = 0;
+  for (const auto& u : uploads) {
+    if (u.generateMipmaps) {
+      maxLevels = std::max(maxLevels, u.dstImage.mipLevels);
+    }
+  }
+  for (uint32_t level = 1; level < maxLevels; ++level) {
+    barriers.clear();
+    for (const auto& u : uploads) {
+      if (u.generateMipmaps && level < u.dstImage.mipLevels) {
+        barriers.push_back(makeBarrier(u.dstImage.image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+          { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, u.dstImage.arrayLayers }));
+      }
+    }
+    vkCmdPipelineBarrier(command,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0, 0, nullptr, 0, nullptr,
+      uint32_t(barriers.size()), barriers.data());
+
+    for (const auto& u : uploads) {
+      if (!u.generateMipmaps || level >= u.dstImage.mipLevels) {
+        continue;
+      }
+      auto width = int32_t(u.dstImage.width), height = int32_t(u.dstImage.height);
+      VkImageBlit blit{};
+      blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, u.dstImage.arrayLayers };
+      blit.srcOffsets[1] = { std::max(width >> (level - 1), 1), std::max(height >> (level - 1), 1), 1 };
+      blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, u.dstImage.arrayLayers };
+      blit.dstOffsets[1] = { std::max(width >> level, 1), std::max(height >> level, 1), 1 };
+      vkCmdBlitImage(command,
+        u.dstImage.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        u.dstImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1, &blit, VK_FILTER_LINEAR);
+    }
+  }
+
+  // SC[WVF[_[ǂ߂Ԃ. ǂރXe[W҂.
+  barriers.clear();
+  VkPipelineStageFlags dstStages = 0;
+  for (const auto& u : uploads) {
+    const auto& image = u.dstImage;
+    uint32_t srcLevels = 0;
+    if (u.generateMipmaps && image.mipLevels > 1) {
+      srcLevels = image.mipLevels - 1;
+      barriers.push_back(makeBarrier(image.image, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, srcLevels, 0, image.arrayLayers }));
+    }
+    barriers.push_back(makeBarrier(image.image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      { VK_IMAGE_ASPECT_COLOR_BIT, srcLevels, image.mipLevels - srcLevels, 0, image.arrayLayers }));
+    dstStages |= u.dstStageMask;
+  }
   vkCmdPipelineBarrier(command,
-    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-    0, 0, nullptr,
-    0, nullptr,
-    1, &imb);
+    VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages,
+    0, 0, nullptr, 0, nullptr,
+    uint32_t(barriers.size()), barriers.data());
   FinishCommandBuffer(command);
   DestroyCommandBuffer(command);
+
+  m_uploadStats.imageSubmitCount++;
+  if (uploads.size() > 1) {
+    std::stringstream ss;
+    ss << "[Upload] texture batch: " << uploads.size() << " images, " << regionCount << " regions, 1 submit" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+}
+
+void VulkanAppBase::BeginTextureUploadBatch()
+{
+  m_textureUploadBatchDepth++;
+}
+
+void VulkanAppBase::EndTextureUploadBatch()
+{
+  assert(m_textureUploadBatchDepth > 0);
+  if (--m_textureUploadBatchDepth == 0) {
+    FlushTextureUploadBatch();
+  }
+}
+
+void VulkanAppBase::FlushTextureUploadBatch()
+{
+  TransferStageBuffersToImages(m_pendingTextureUploads);
+  for (const auto& alloc : m_pendingTextureUploadSlabs) {
+    ReleaseStagingSlab(alloc);
+  }
+  m_pendingTextureUploads.clear();
+  m_pendingTextureUploadSlabs.clear();
+  m_pendingTextureUploadBytes = 0;
+}
+
+uint32_t VulkanAppBase::CalcMipLevels(uint32_t width, uint32_t height)
+{
+  uint32_t levels = 1;
+  auto size = std::max(width, height);
+  while (size > 1) {
+    size >>= 1;
+    levels++;
+  }
+  return levels;
+}
+
+bool VulkanAppBase::IsMipmapBlitSupported(VkFormat format) const
+{
+  VkFormatProperties props{};
+  vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &props);
+  VkFormatFeatureFlags required =
+    VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+  return (props.optimalTilingFeatures & required) == required;
+}
+
+bool VulkanAppBase::IsTextureFormatSupported(VkFormat format) const
+{
+  ktx_texture::FormatInfo info;
+  if (!ktx_texture::GetFormatInfo(format, info)) {
+    return false;
+  }
+  VkPhysicalDeviceFeatures features{};
+  vkGetPhysicalDeviceFeatures(m_physicalDevice, &features);
+  if ((info.family == ktx_texture::FormatFamily_BC && !features.textureCompressionBC) ||
+    (info.family == ktx_texture::FormatFamily_ETC2 && !features.textureCompressionETC2) ||
+    (info.family == ktx_texture::FormatFamily_ASTC && !features.textureCompressionASTC_LDR)) {
+    return false;
+  }
+  VkFormatProperties props{};
+  vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &props);
+  return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
 }
 
 
@@ -702,10 +1573,51 @@ VkRenderPass VulkanAppBase::CreateRenderPass(VkFormat colorFormat, VkFormat dept
   return renderPass;
 }
 
-void VulkanAppBase::WriteToDeviceLocalMemory(BufferObject dstBuffer, const void* pSrcData, size_t size, VkCommandBuffer command, BufferObject* stagingBufferUsed)
+void VulkanAppBase::WriteToDeviceLocalMemory(BufferObject dstBuffer, const void* pSrcData, VkDeviceSize size, VkCommandBuffer command, BufferObject* stagingBufferUsed, VkDeviceSize dstOffset)
 {
+  if (dstOffset > dstBuffer.size || size > dstBuffer.size - dstOffset) {
+    std::stringstream ss;
+    ss << "WriteToDeviceLocalMemory: range [" << dstOffset << ", +" << size << ") is out of the buffer (" << dstBuffer.size << ").";
+    throw book_util::VulkanException(ss.str());
+  }
+  if (dstBuffer.memoryProps & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    // zXg猩foCX[JȂ̂ŁAXe[WO GPU Rs[g킸ɏ.
+    // tbV͈͂AgE֍L悤Aobt@Ŝ}bvďtbV.
+    void* p;
+    vkMapMemory(m_device, dstBuffer.memory, 0, VK_WHOLE_SIZE, 0, &p);
+    memcpy(static_cast<uint8_t*>(p) + dstOffset, pSrcData, size_t(size));
+    if (!(dstBuffer.memoryProps & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+      FlushMappedRange(dstBuffer.memory, dstOffset, size, dstBuffer.size);
+    }
+    vkUnmapMemory(m_device, dstBuffer.memory);
+    if (stagingBufferUsed) {
+      *stagingBufferUsed = BufferObject{};
+    }
+    m_uploadStats.directCount++;
+    m_uploadStats.directBytes += size;
+    std::stringstream ss;
+    ss << "[Upload] direct  " << size << " bytes" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+    return;
+  }
+  m_uploadStats.stagingCount++;
+  m_uploadStats.stagingBytes += size;
+  if (size > m_stagingChunkSize) {
+    // ȃXe[WOobt@炸ɁAŒTCỸ`Nŗ.
+    WriteToDeviceLocalMemoryChunked(dstBuffer, static_cast<const uint8_t*>(pSrcData), size, dstOffset);
+    if (stagingBufferUsed) {
+      *stagingBufferUsed = BufferObject{};
+    }
+    return;
+  }
+  {
+    std::stringstream ss;
+    ss << "[Upload] staging " << size << " bytes" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+
   VkBufferUsageFlags srcUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-  auto stagingBuffer = CreateBuffer(uint32_t(size), srcUsage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+  auto stagingBuffer = CreateBuffer(size, srcUsage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
   WriteToHostVisibleMemory(stagingBuffer.memory, size, pSrcData);
 
   VkCommandBuffer xferCommand = command;
@@ -714,6 +1626,7 @@ void VulkanAppBase::WriteToDeviceLocalMemory(BufferObject dstBuffer, const void*
   }
 
   VkBufferCopy region{};
+  region.dstOffset = dstOffset;
   region.size = size;
   vkCmdCopyBuffer(xferCommand, stagingBuffer.buffer, dstBuffer.buffer, 1, &region);
   if (command == VK_NULL_HANDLE) {
@@ -726,6 +1639,80 @@ void VulkanAppBase::WriteToDeviceLocalMemory(BufferObject dstBuffer, const void*
   }
 }
 
+void VulkanAppBase::FlushMappedRange(VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize memorySize)
+{
+  // ̓ItZbg 0 oChĂ̂ŁA擪AgE֐؂艺A͐؂グ.
+  // ؂グƃobt@𒴂ꍇ VK_WHOLE_SIZE ɂ (蓖Ă̖܂łΏۂɂȂ).
+  auto atom = m_nonCoherentAtomSize;
+  auto begin = offset / atom * atom;
+  auto end = (offset + size + atom - 1) / atom * atom;
+  VkMappedMemoryRange range{};
+  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  range.memory = memory;
+  range.offset = begin;
+  range.size = end > memorySize ? VK_WHOLE_SIZE : end - begin;
+  vkFlushMappedMemoryRanges(m_device, 1, &range);
+}
+
+void VulkanAppBase::WriteToDeviceLocalMemoryChunked(BufferObject dstBuffer, const uint8_t* pSrcData, VkDeviceSize size, VkDeviceSize dstOffset)
+{
+  // Xe[WO 2 ݂ɎgAGPU Rs[ĂԂɎ̃`N.
+  struct Chunk {
+    BufferObject staging;
+    void* mapped = nullptr;
+    VkCommandBuffer command = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+  };
+  Chunk chunks[2];
+  VkFenceCreateInfo fenceCI{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+  for (auto& c : chunks) {
+    c.staging = CreateBuffer(m_stagingChunkSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    vkMapMemory(m_device, c.staging.memory, 0, VK_WHOLE_SIZE, 0, &c.mapped);
+    auto result = vkCreateFence(m_device, &fenceCI, nullptr, &c.fence);
+    ThrowIfFailed(result, "vkCreateFence Failed.");
+  }
+
+  uint64_t chunkCount = 0;
+  for (VkDeviceSize offset = 0; offset < size; offset += m_stagingChunkSize) {
+    auto& c = chunks[chunkCount % 2];
+    if (c.command != VK_NULL_HANDLE) {
+      // 2 Õ`ÑRs[҂ĂXe[WOėp.
+      vkWaitForFences(m_device, 1, &c.fence, VK_TRUE, UINT64_MAX);
+      vkResetFences(m_device, 1, &c.fence);
+      DestroyCommandBuffer(c.command);
+    }
+    auto copySize = std::min(m_stagingChunkSize, size - offset);
+    memcpy(c.mapped, pSrcData + offset, size_t(copySize));
+
+    c.command = CreateCommandBuffer();
+    VkBufferCopy region{ 0, dstOffset + offset, copySize };
+    vkCmdCopyBuffer(c.command, c.staging.buffer, dstBuffer.buffer, 1, &region);
+    vkEndCommandBuffer(c.command);
+    VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &c.command;
+    auto result = vkQueueSubmit(m_deviceQueue, 1, &submitInfo, c.fence);
+    ThrowIfFailed(result, "vkQueueSubmit Failed.");
+    chunkCount++;
+  }
+  for (auto& c : chunks) {
+    if (c.command != VK_NULL_HANDLE) {
+      vkWaitForFences(m_device, 1, &c.fence, VK_TRUE, UINT64_MAX);
+      DestroyCommandBuffer(c.command);
+    }
+    vkDestroyFence(m_device, c.fence, nullptr);
+    vkUnmapMemory(m_device, c.staging.memory);
+    DestroyBuffer(c.staging);
+  }
+
+  m_uploadStats.chunkedCount++;
+  m_uploadStats.chunkCount += chunkCount;
+  std::stringstream ss;
+  ss << "[Upload] staging " << size << " bytes in " << chunkCount << " chunks of " << (m_stagingChunkSize >> 20) << " MB" << std::endl;
+  OutputDebugStringA(ss.str().c_str());
+}
+
 
 void VulkanAppBase::PrepareImGui()
 {
@@ -779,81 +1766,359 @@ void VulkanAppBase::CleanupImGui()
 
 
 VulkanAppBase::ModelAsset VulkanAppBase::LoadModelData(std::filesystem::path fileName, bool useFlipUV)
+{
+  ModelLoadOptions options{};
+  options.useFlipUV = useFlipUV;
+  return LoadModelData(fileName, options);
+}
+
+VulkanAppBase::ModelAsset VulkanAppBase::LoadModelData(std::filesystem::path fileName, const ModelLoadOptions& options)
+{
+  // t@C/IvṼWIg͋LACX^XŗL̏Ԃ.
+  auto key = MakeModelDatabaseKey(fileName, options);
+  auto it = m_modelDatabase.find(key);
+  if (it == m_modelDatabase.end()) {
+    ModelDatabaseEntry entry{};
+    entry.geometry = LoadModelGeometry(fileName, options);
+    entry.geometry.geometryKey = key;
+    it = m_modelDatabase.emplace(key, std::move(entry)).first;
+  } else {
+    std::stringstream ss;
+    ss << "[ModelDatabase] " << it->second.geometry.name << " shared (refs " << it->second.refCount + 1 << ")" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+  it->second.refCount++;
+  return CreateModelInstance(it->second.geometry);
+}
+
+VulkanAppBase::ModelAsset VulkanAppBase::CreateModelInstance(const ModelAsset& geometry)
+{
+  // obt@/}eA/DrawBatch ̕`͈͂͋L̂܂܎QƂ.
+  ModelAsset model = geometry;
+
+  // m[hKw̓CfbNXŎQƂĂ̂ŁÃRs[ŃCX^XƂ̎pɂȂĂ.
+
+  uint32_t imageCount = m_swapchain->GetImageCount();
+  for (auto& batch : model.DrawBatches) {
+    batch.descriptorSets.clear();
+    auto bufferSize = uint32_t(sizeof(ModelMeshParameters));
+    batch.modelMeshParameterUBO = CreateUniformBuffers(bufferSize, imageCount);
+  }
+  // {[s̓XPgPʂ 1 . 傫̏ UBO ł͂ȂXg[Wobt@̐ɂȂ.
+  model.boneMatrixPalette.clear();
+  if (!model.skeletonNodes.empty()) {
+    auto bufferSize = VkDeviceSize(sizeof(glm::mat4)) * model.skeletonNodes.size();
+    model.boneMatrixPalette = CreateStorageBuffers(bufferSize, imageCount);
+  }
+  model.extraBuffers.clear();
+  model.pipelineLayout = VK_NULL_HANDLE;
+  return model;
+}
+
+void VulkanAppBase::ReleaseModelGeometry(const std::string& key)
+{
+  auto it = m_modelDatabase.find(key);
+  if (it == m_modelDatabase.end()) {
+    return;
+  }
+  auto& entry = it->second;
+  if (--entry.refCount > 0) {
+    return;
+  }
+  auto& geometry = entry.geometry;
+  for (auto& m : geometry.materials) {
+    ReleaseTexture(m.albedo);
+    ReleaseTexture(m.specular);
+  }
+  // {[ԍ̕ϊ\̓v[ɓȂ̂ŁAŔj.
+  DestroyBuffer(geometry.BoneRemap);
+  if (geometry.geometryPoolIndex >= 0) {
+    // v[̗̈Ԃ. 󂫗̈͗אڂ̂ƌ.
+    auto& pool = m_geometryPools[geometry.geometryPoolIndex];
+    pool.vertexAllocator.Free(geometry.poolVertexBase);
+    pool.indexAllocator.Free(geometry.poolIndexBase);
+    ReportGeometryPool("release", geometry.geometryPoolIndex);
+    m_modelDatabase.erase(it);
+    return;
+  }
+  DestroyBuffer(geometry.Position);
+  DestroyBuffer(geometry.Normal);
+  DestroyBuffer(geometry.UV0);
+  DestroyBuffer(geometry.Indices);
+  DestroyBuffer(geometry.BoneIndices);
+  DestroyBuffer(geometry.BoneWeights);
+  DestroyBuffer(geometry.Tangent);
+  DestroyBuffer(geometry.VertexData);
+  m_modelDatabase.erase(it);
+}
+
+bool VulkanAppBase::AllocateFromGeometryPool(ModelAsset& model, const std::vector<VertexAttribute>& attributes, uint64_t vertexCount, VkDeviceSize indexDataSize)
+{
+  // _tH[}bgƑ\vv[T.
+  int poolIndex = -1;
+  for (int i = 0; i < int(m_geometryPools.size()); ++i) {
+    const auto& pool = m_geometryPools[i];
+    if (pool.attributeMask == model.attributeMask && pool.vertexFormats == model.vertexFormats) {
+      poolIndex = i;
+      break;
+    }
+  }
+  if (poolIndex < 0) {
+    GeometryPool pool;
+    pool.attributeMask = model.attributeMask;
+    pool.vertexFormats = model.vertexFormats;
+    pool.attributeSizes = model.attributeSizes;
+    VkMemoryPropertyFlags props = GetUploadTargetMemoryProps();
+    // lߒ̃Rs[ɂȂ̂ TRANSFER_SRC tĂ.
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    for (auto attr : attributes) {
+      pool.vertexBuffers[attr] = CreateBuffer(book_util::CheckedBufferSize(m_geometryPoolVertexCapacity, pool.attributeSizes[attr]), usage, props);
+    }
+    usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    pool.indexBuffer = CreateBuffer(m_geometryPoolIndexCapacity, usage, props);
+    pool.vertexAllocator.Reset(m_geometryPoolVertexCapacity);
+    pool.indexAllocator.Reset(m_geometryPoolIndexCapacity);
+    poolIndex = int(m_geometryPools.size());
+    m_geometryPools.push_back(pool);
+  }
+
+  auto& pool = m_geometryPools[poolIndex];
+  auto vertexBase = pool.vertexAllocator.Allocate(vertexCount);
+  if (vertexBase == GeometryRangeAllocator::InvalidOffset) {
+    OutputDebugStringA("[GeometryPool] vertex pool is full. use dedicated buffers.\n");
+    return false;
+  }
+  // 16bit/32bit CfbNX݂̂ 4 oCgEɒu.
+  auto indexBase = pool.indexAllocator.Allocate(indexDataSize, sizeof(uint32_t));
+  if (indexBase == GeometryRangeAllocator::InvalidOffset) {
+    pool.vertexAllocator.Free(vertexBase);
+    OutputDebugStringA("[GeometryPool] index pool is full. use dedicated buffers.\n");
+    return false;
+  }
+
+  model.geometryPoolIndex = poolIndex;
+  model.poolVertexBase = vertexBase;
+  model.poolIndexBase = indexBase;
+  BufferObject* vertexBuffers[VertexAttribute_Count] = {
+    &model.Position, &model.Normal, &model.UV0, &model.Tangent, &model.BoneIndices, &model.BoneWeights,
+  };
+  for (auto attr : attributes) {
+    *vertexBuffers[attr] = pool.vertexBuffers[attr];
+  }
+  model.Indices = pool.indexBuffer;
+
+  // DrawBatch ͈̔͂v[ɕtւ.
+  for (auto& batch : model.DrawBatches) {
+    batch.vertexOffsetCount += vertexBase;
+    batch.indexBufferOffset += indexBase;
+    auto indexSize = (batch.indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+    batch.indexOffsetCount = batch.indexBufferOffset / indexSize;
+  }
+  ReportGeometryPool("load", poolIndex);
+  return true;
+}
+
+void VulkanAppBase::ReportGeometryPool(const char* reason, int poolIndex)
+{
+  const auto& pool = m_geometryPools[poolIndex];
+  std::stringstream ss;
+  ss << "[GeometryPool] #" << poolIndex << " " << reason << std::endl;
+  ss << "  vertex " << pool.vertexAllocator.GetUsedSize() << " / " << pool.vertexAllocator.GetCapacity()
+    << " (free ranges " << pool.vertexAllocator.GetFreeRangeCount() << ", fragmentation " << pool.vertexAllocator.GetFragmentation() * 100.0f << "%)" << std::endl;
+  ss << "  index  " << pool.indexAllocator.GetUsedSize() << " / " << pool.indexAllocator.GetCapacity()
+    << " bytes (free ranges " << pool.indexAllocator.GetFreeRangeCount() << ", fragmentation " << pool.indexAllocator.GetFragmentation() * 100.0f << "%)" << std::endl;
+  OutputDebugStringA(ss.str().c_str());
+}
+
+void VulkanAppBase::CompactGeometryPools()
+{
+  vkDeviceWaitIdle(m_device);
+
+  std::vector<BufferObject> tempBuffers;
+  auto command = CreateCommandBuffer();
+  // obt@Ŕ͈͂dȂRs[͂łȂ̂ŁAꎞobt@֑ޔĂ珑߂.
+  auto moveRanges = [&](const BufferObject& buffer, const std::vector<GeometryRangeAllocator::Relocation>& moves, VkDeviceSize unitSize) {
+    if (moves.empty() || buffer.buffer == VK_NULL_HANDLE) {
+      return;
+    }
+    std::vector<VkBufferCopy> toTemp, fromTemp;
+    VkDeviceSize tempSize = 0;
+    for (const auto& m : moves) {
+      toTemp.push_back({ m.oldOffset * unitSize, tempSize, m.size * unitSize });
+      fromTemp.push_back({ tempSize, m.newOffset * unitSize, m.size * unitSize });
+      tempSize += m.size * unitSize;
+    }
+    auto temp = CreateBuffer(tempSize,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    tempBuffers.push_back(temp);
+    vkCmdCopyBuffer(command, buffer.buffer, temp.buffer, uint32_t(toTemp.size()), toTemp.data());
+    VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(command,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      1, &barrier, 0, nullptr, 0, nullptr);
+    vkCmdCopyBuffer(command, temp.buffer, buffer.buffer, uint32_t(fromTemp.size()), fromTemp.data());
+  };
+
+  std::vector<bool> moved(m_geometryPools.size(), false);
+  for (int p = 0; p < int(m_geometryPools.size()); ++p) {
+    auto& pool = m_geometryPools[p];
+    std::vector<GeometryRangeAllocator::Relocation> vertexMoves, indexMoves;
+    pool.vertexAllocator.Compact(vertexMoves);
+    pool.indexAllocator.Compact(indexMoves, sizeof(uint32_t));
+    if (vertexMoves.empty() && indexMoves.empty()) {
+      continue;
+    }
+    moved[p] = true;
+    for (int attr = 0; attr < VertexAttribute_Count; ++attr) {
+      moveRanges(pool.vertexBuffers[attr], vertexMoves, pool.attributeSizes[attr]);
+    }
+    moveRanges(pool.indexBuffer, indexMoves, 1);
+
+    // LWIg DrawBatch 炷.
+    for (auto& entry : m_modelDatabase) {
+      auto& geometry = entry.second.geometry;
+      if (geometry.geometryPoolIndex != p) {
+        continue;
+      }
+      int64_t vertexDelta = 0, indexDelta = 0;
+      for (const auto& m : vertexMoves) {
+        if (m.oldOffset == geometry.poolVertexBase) {
+          vertexDelta = int64_t(m.newOffset) - int64_t(m.oldOffset);
+        }
+      }
+      for (const auto& m : indexMoves) {
+        if (m.oldOffset == geometry.poolIndexBase) {
+          indexDelta = int64_t(m.newOffset) - int64_t(m.oldOffset);
+        }
+      }
+      geometry.poolVertexBase += vertexDelta;
+      geometry.poolIndexBase += indexDelta;
+      for (auto& batch : geometry.DrawBatches) {
+        batch.vertexOffsetCount = uint64_t(int64_t(batch.vertexOffsetCount) + vertexDelta);
+        batch.indexBufferOffset = VkDeviceSize(int64_t(batch.indexBufferOffset) + indexDelta);
+        auto indexSize = (batch.indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+        batch.indexOffsetCount = batch.indexBufferOffset / indexSize;
+      }
+    }
+  }
+  FinishCommandBuffer(command);
+  DestroyCommandBuffer(command);
+  for (auto& b : tempBuffers) {
+    DestroyBuffer(b);
+  }
+  for (int p = 0; p < int(m_geometryPools.size()); ++p) {
+    if (moved[p]) {
+      ReportGeometryPool("compact", p);
+    }
+  }
+}
+
+void VulkanAppBase::RefreshModelInstance(ModelAsset& model)
+{
+  auto it = m_modelDatabase.find(model.geometryKey);
+  if (it == m_modelDatabase.end()) {
+    return;
+  }
+  const auto& geometry = it->second.geometry;
+  model.poolVertexBase = geometry.poolVertexBase;
+  model.poolIndexBase = geometry.poolIndexBase;
+  for (size_t i = 0; i < model.DrawBatches.size(); ++i) {
+    auto& dst = model.DrawBatches[i];
+    const auto& src = geometry.DrawBatches[i];
+    dst.vertexOffsetCount = src.vertexOffsetCount;
+    dst.indexOffsetCount = src.indexOffsetCount;
+    dst.indexBufferOffset = src.indexBufferOffset;
+  }
+}
+
+VulkanAppBase::ModelAsset VulkanAppBase::LoadModelGeometry(std::filesystem::path fileName, const ModelLoadOptions& options)
 {
   ModelAsset model;
-  model.importer = new Assimp::Importer();
+  // Importer/aiScene ͓ǂݍݒgAKvȏo.
+  Assimp::Importer importer;
   uint32_t flags = 0;
   flags |= aiProcess_Triangulate | aiProcess_CalcTangentSpace;
   if (fileName.extension() == ".pmx") {
     flags |= aiProcess_FlipUVs;
   }
-  if (useFlipUV) {
+  if (options.useFlipUV) {
     flags |= aiProcess_FlipUVs;
   }
-  model.scene = model.importer->ReadFile(fileName.string(), flags);
+  const aiScene* scene = importer.ReadFile(fileName.string(), flags);
   model.name = fileName.filename().string();
-  auto scene = model.scene;
-  UINT totalVertexCount = 0, totalIndexCount = 0;
+  // v 64bit ŐAobt@TCY̌vZ (CheckedBufferSize) ŃI[o[t[o.
+  uint64_t totalVertexCount = 0, totalIndexCount = 0;
+  uint32_t drawBatchCount = 0;
   bool hasBone = false;
 
-  std::stack<std::shared_ptr<Node>> nodes;
-  model.rootNode = std::make_shared<Node>();
-  nodes.push(model.rootNode);
-
-  std::stack<aiNode*> nodeStack;
-  nodeStack.push(scene->mRootNode);
-  while (!nodeStack.empty()) {
-    auto* node = nodeStack.top();
-    nodeStack.pop();
-
-    auto nodeTarget = nodes.top(); nodes.pop();
-
-    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
-      nodeStack.push(node->mChildren[i]);
-    }
-    // p̎qm[h𐶐.
-    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
-      auto child = std::make_shared<Node>();
-      nodeTarget->children.push_back(child);
-      nodes.push(child);
-    }
+  // eɒǉ鏇 (s) Ńm[hKw\z.
+  // {[Aj[V̎QƂ UTF-8 ̂܂܂̖Oň悤ɂĂAϊȂ.
+  model.nodes.Clear();
+  NodeNameTable utf8NodeNames;
+  std::stack<std::pair<aiNode*, uint32_t>> hierarchyStack;
+  hierarchyStack.push({ scene->mRootNode, NodeHierarchy::InvalidIndex });
+  while (!hierarchyStack.empty()) {
+    auto* node = hierarchyStack.top().first;
+    auto parentIndex = hierarchyStack.top().second;
+    hierarchyStack.pop();
 
     auto name = ConvertFromUTF8(node->mName.C_Str());
     auto meshCount = node->mNumMeshes;
-    nodeTarget->name = name;
+    auto nodeIndex = model.nodes.AddNode(name, parentIndex, ConvertMatrix(node->mTransformation));
+    utf8NodeNames.Insert(node->mName.data, node->mName.length, nodeIndex);
+    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
+      hierarchyStack.push({ node->mChildren[i], nodeIndex });
+    }
 
     if (meshCount > 0) {
       for (uint32_t i = 0; i < node->mNumMeshes; ++i) {
         auto meshIndex = node->mMeshes[i];
         const auto* mesh = scene->mMeshes[meshIndex];
         totalVertexCount += mesh->mNumVertices;
-        totalIndexCount += mesh->mNumFaces * 3;
+        totalIndexCount += uint64_t(mesh->mNumFaces) * 3;
         hasBone |= mesh->HasBones();
       }
+      drawBatchCount += meshCount;
     }
-    nodeTarget->transform = ConvertMatrix(node->mTransformation);
   }
 
-  uint32_t bufferSize = sizeof(glm::vec3) * totalVertexCount;
-  VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-  VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-  model.Position = CreateBuffer(bufferSize, usage, props);
-  model.Normal = CreateBuffer(bufferSize, usage, props);
-  model.Tangent = CreateBuffer(bufferSize, usage, props);
-
-  bufferSize = sizeof(glm::vec2) * totalVertexCount;
-  model.UV0 = CreateBuffer(bufferSize, usage, props);
-  if (hasBone) {
-    bufferSize = sizeof(glm::ivec4) * totalVertexCount;
-    model.BoneIndices = CreateBuffer(bufferSize, usage, props);
-
-    bufferSize = sizeof(glm::vec4) * totalVertexCount;
-    model.BoneWeights = CreateBuffer(bufferSize, usage, props);
+  // vꂽ_̃Xg[\z. ʒu͏ɕKv.
+  const uint32_t attributeMask = EffectiveAttributeMask(options);
+  auto useAttribute = [&](VertexAttribute attr) { return (attributeMask & VertexAttributeBit(attr)) != 0; };
+  const bool useNormal = useAttribute(VertexAttribute_Normal);
+  const bool useUV0 = useAttribute(VertexAttribute_UV0);
+  const bool useTangent = useAttribute(VertexAttribute_Tangent);
+  // {[̃CfbNXƃEFCg͕ЕvĂ\z (ݒ̈̑|ő΂ɂĈ).
+  const bool useBoneStreams = hasBone && (useAttribute(VertexAttribute_BoneIndices) || useAttribute(VertexAttribute_BoneWeights));
+  std::vector<VertexAttribute> activeAttributes;
+  for (int i = 0; i < VertexAttribute_Count; ++i) {
+    auto attr = VertexAttribute(i);
+    bool isBone = (attr == VertexAttribute_BoneIndices || attr == VertexAttribute_BoneWeights);
+    if (useAttribute(attr) && (!isBone || hasBone)) {
+      activeAttributes.push_back(attr);
+    }
+  }
+  model.attributeMask = 0;
+  for (auto attr : activeAttributes) {
+    model.attributeMask |= VertexAttributeBit(attr);
   }
 
-  bufferSize = sizeof(uint32_t) * totalIndexCount;
-  usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-  model.Indices = CreateBuffer(bufferSize, usage, props);
+  // bVœǨʂ̓LbVt@Cǂ߂΍ėp.
+  auto cacheHeader = MakeMeshCacheHeader(fileName, options);
+  auto cacheFileName = fileName;
+  {
+    std::stringstream ss;
+    ss << "." << std::hex << cacheHeader.optionFlags << ".meshcache";
+    cacheFileName += ss.str();
+  }
+  // LbṼob`͂̃f DrawBatch ƈvȂ΂ȂȂ.
+  cacheHeader.batchCount = drawBatchCount;
+  std::vector<MeshCacheBatch> meshCache;
+  bool useMeshCache = options.optimizeMesh && options.useMeshCache;
+  bool meshCacheLoaded = useMeshCache && ReadMeshCache(cacheFileName, cacheHeader, meshCache);
+  bool meshCacheDirty = false;
 
   // _f[^̍\z.
   std::vector<glm::vec3> vbPos, vbNrm, vbTan;
@@ -862,17 +2127,32 @@ VulkanAppBase::ModelAsset VulkanAppBase::LoadModelData(std::filesystem::path fil
   std::vector<glm::vec4> vbBWeights;
   std::vector<uint32_t> ibIndices;
   vbPos.reserve(totalVertexCount);
-  vbNrm.reserve(totalVertexCount);
-  vbUV0.reserve(totalVertexCount);
-  vbTan.reserve(totalVertexCount);
+  vbNrm.reserve(useNormal ? totalVertexCount : 0);
+  vbUV0.reserve(useUV0 ? totalVertexCount : 0);
+  vbTan.reserve(useTangent ? totalVertexCount : 0);
   ibIndices.reserve(totalIndexCount);
-  if (hasBone) {
-    vbBIndices.resize(totalVertexCount, glm::ivec4(-1, -1, -1, -1));
-    vbBWeights.resize(totalVertexCount, glm::vec4(-1.0f, -1.0f, -1.0f, -1.0f));
+  if (useBoneStreams) {
+    vbBIndices.reserve(totalVertexCount);
+    vbBWeights.reserve(totalVertexCount);
   }
 
+  mesh_optimizer::VertexCacheStatistics statsBefore{}, statsAfter{};
+  auto accumulateStats = [](mesh_optimizer::VertexCacheStatistics& total, const mesh_optimizer::VertexCacheStatistics& v) {
+    total.transformedVertices += v.transformedVertices;
+    total.triangleCount += v.triangleCount;
+    total.vertexCount += v.vertexCount;
+  };
+
   totalVertexCount = 0;
   totalIndexCount = 0;
+  uint32_t batchIndex = 0;
+  std::vector<uint32_t> batchVertexCounts;
+  // UTF-8 ̃{[ -> model.skeletonNodes ̔ԍ.
+  NodeNameTable skeletonSlots;
+  uint32_t boneRemapHits = 0;
+  model.skeletonNodes.clear();
+  model.skeletonOffsets.clear();
+  std::stack<aiNode*> nodeStack;
   nodeStack.push(scene->mRootNode);
   while (!nodeStack.empty()) {
     auto* node = nodeStack.top();
@@ -882,109 +2162,334 @@ VulkanAppBase::ModelAsset VulkanAppBase::LoadModelData(std::filesystem::path fil
       nodeStack.push(node->mChildren[i]);
     }
 
-    auto name = ConvertFromUTF8(node->mName.C_Str());
     auto meshCount = node->mNumMeshes;
 
     if (meshCount > 0) {
       for (uint32_t i = 0; i < node->mNumMeshes; ++i) {
         auto meshIndex = node->mMeshes[i];
         const auto* mesh = scene->mMeshes[meshIndex];
+        const auto vertexCount = mesh->mNumVertices;
 
         DrawBatch batch{};
         batch.vertexOffsetCount = totalVertexCount;
         batch.indexOffsetCount = totalIndexCount;
-        batch.indexCount = mesh->mNumFaces * 3;
+        batch.indexBufferOffset = sizeof(uint32_t) * totalIndexCount;
         batch.materialIndex = mesh->mMaterialIndex;
 
+        // bVPʂŒ_f[^W߂ĂœK.
         const auto* vPosStart = reinterpret_cast<const glm::vec3*>(mesh->mVertices);
-        vbPos.insert(vbPos.end(), vPosStart, vPosStart + mesh->mNumVertices);
-
-        const auto* vNrmStart = reinterpret_cast<const glm::vec3*>(mesh->mNormals);
-        vbNrm.insert(vbNrm.end(), vNrmStart, vNrmStart + mesh->mNumVertices);
-
-        std::vector<glm::vec2> uvWork(mesh->mNumVertices);
-        for (int j = 0; j < int(mesh->mNumVertices); ++j) {
-          const auto& src = mesh->mTextureCoords[0][j];
-          uvWork[j].x = src.x;
-          uvWork[j].y = src.y;
+        std::vector<glm::vec3> meshPos(vPosStart, vPosStart + vertexCount);
+        // ĂȂ 0 Ŗ߂ (bVԂŃXg[𑵂̒).
+        std::vector<glm::vec3> meshNrm(useNormal ? vertexCount : 0), meshTan(useTangent ? vertexCount : 0);
+        std::vector<glm::vec2> meshUV0(useUV0 ? vertexCount : 0);
+        if (useNormal && mesh->HasNormals()) {
+          const auto* vNrmStart = reinterpret_cast<const glm::vec3*>(mesh->mNormals);
+          meshNrm.assign(vNrmStart, vNrmStart + vertexCount);
         }
-
-        vbUV0.insert(vbUV0.end(), uvWork.begin(), uvWork.end());
-
-        if (mesh->HasTangentsAndBitangents()) {
+        if (useUV0 && mesh->HasTextureCoords(0)) {
+          for (int j = 0; j < int(vertexCount); ++j) {
+            const auto& src = mesh->mTextureCoords[0][j];
+            meshUV0[j].x = src.x;
+            meshUV0[j].y = src.y;
+          }
+        }
+        if (useTangent && mesh->HasTangentsAndBitangents()) {
           const auto* vTanStart = reinterpret_cast<const glm::vec3*>(mesh->mTangents);
-          vbTan.insert(vbTan.end(), vTanStart, vTanStart + mesh->mNumVertices);
+          meshTan.assign(vTanStart, vTanStart + vertexCount);
         }
 
+        std::vector<uint32_t> meshIndices;
+        meshIndices.reserve(mesh->mNumFaces * 3);
         for (int f = 0; f < int(mesh->mNumFaces); ++f) {
           for (int fi = 0; fi < int(mesh->mFaces[f].mNumIndices); ++fi) {
             auto vertexIndex = mesh->mFaces[f].mIndices[fi];
-            ibIndices.push_back(vertexIndex);
+            meshIndices.push_back(vertexIndex);
           }
         }
 
-        uint32_t imageCount = m_swapchain->GetImageCount();
-        bufferSize = uint32_t(sizeof(ModelMeshParameters));
-        batch.modelMeshParameterUBO = CreateUniformBuffers(bufferSize, imageCount);
+        std::vector<glm::ivec4> meshBIndices;
+        std::vector<glm::vec4> meshBWeights;
+        if (useBoneStreams) {
+          meshBIndices.resize(vertexCount, glm::ivec4(-1, -1, -1, -1));
+          meshBWeights.resize(vertexCount, glm::vec4(-1.0f, -1.0f, -1.0f, -1.0f));
+        }
 
         if (hasBone) {
           if (mesh->HasBones()) {
             // Lȃ{[̂𒊏o.
-            std::vector<std::string> boneNameList;
             std::vector<aiBone*> activeBones;
-            std::vector<int> boneIndexList;
             for (uint32_t j = 0; j < mesh->mNumBones; ++j) {
               const auto bone = mesh->mBones[j];
-              auto name = ConvertFromUTF8(bone->mName.C_Str());
               if (bone->mNumWeights > 0) {
-                boneIndexList.push_back(int(boneNameList.size()));
-                boneNameList.push_back(name);
                 activeBones.push_back(bone);
               }
             }
 
-            auto vertexBase = batch.vertexOffsetCount;
-            for (int boneIndex = 0; boneIndex < int(activeBones.size()); ++boneIndex) {
+            for (int boneIndex = 0; useBoneStreams && boneIndex < int(activeBones.size()); ++boneIndex) {
               auto bone = activeBones[boneIndex];
               for (int j = 0; j < int(bone->mNumWeights); ++j) {
                 auto weightInfo = bone->mWeights[j];
-                auto vertexIndex = vertexBase + weightInfo.mVertexId;
+                auto vertexIndex = weightInfo.mVertexId;
                 auto weight = weightInfo.mWeight;
 
-                AddVertexIndex(vbBIndices[vertexIndex], boneIndex);
-                AddVertexWeight(vbBWeights[vertexIndex], weight);
+                AddVertexIndex(meshBIndices[vertexIndex], boneIndex);
+                AddVertexWeight(meshBWeights[vertexIndex], weight);
               }
             }
 
-            batch.boneList = activeBones;
-
+            // XPgL郁bV͓{[ׂ̂ŁA
+            // x{[̓XPg̔ԍ\ɂ.
             for (int boneIndex = 0; boneIndex < int(activeBones.size()); ++boneIndex) {
-              auto bone = activeBones[boneIndex];
-              auto name = ConvertFromUTF8(bone->mName.C_Str());
+              const auto& boneName = activeBones[boneIndex]->mName;
+              auto offset = ConvertMatrix(activeBones[boneIndex]->mOffsetMatrix);
+              auto slot = skeletonSlots.Find(boneName.data, boneName.length);
+              if (slot != NodeNameTable::InvalidIndex && !IsNearlyEqual(model.skeletonOffsets[slot], offset)) {
+                // {[łbVƂɃoCh|[YႤ. pbg̕ʂ̗vfg.
+                auto node = model.skeletonNodes[slot];
+                slot = uint32_t(model.skeletonNodes.size());
+                model.skeletonNodes.push_back(node);
+                model.skeletonOffsets.push_back(offset);
+              } else if (slot == NodeNameTable::InvalidIndex) {
+                auto node = utf8NodeNames.Find(boneName.data, boneName.length);
+                assert(node != NodeHierarchy::InvalidIndex);
+                slot = uint32_t(model.skeletonNodes.size());
+                model.skeletonNodes.push_back(node);
+                model.skeletonOffsets.push_back(offset);
+                skeletonSlots.Insert(boneName.data, boneName.length, slot);
+              } else {
+                boneRemapHits++;
+              }
+              batch.boneRemap.push_back(slot);
+            }
+          }
+        }
 
-              auto node = model.FindNode(name);
-              assert(node != nullptr);
-              node->offsetMatrix = ConvertMatrix(bone->mOffsetMatrix);
-              batch.boneList2.push_back(node);
+        // bVœK. vertexOrder[V_ԍ] = bV̌̒_ԍ.
+        const auto sourceIndexCount = uint32_t(meshIndices.size());
+        accumulateStats(statsBefore, mesh_optimizer::AnalyzeVertexCache(meshIndices, vertexCount));
+        std::vector<uint32_t> vertexOrder;
+        if (options.optimizeMesh) {
+          // ꂽGg̓LbV~XƂĈAœKď.
+          bool cacheHit = meshCacheLoaded && batchIndex < meshCache.size() &&
+            meshCache[batchIndex].sourceVertexCount == vertexCount &&
+            meshCache[batchIndex].sourceIndexCount == sourceIndexCount &&
+            IsValidMeshCacheBatch(meshCache[batchIndex], vertexCount);
+          if (cacheHit) {
+            vertexOrder = meshCache[batchIndex].vertexOrder;
+            meshIndices = meshCache[batchIndex].indices;
+          } else {
+            // \zXg[ŏd肷.
+            std::vector<mesh_optimizer::VertexStream> streams{
+              { meshPos.data(), sizeof(glm::vec3) },
+            };
+            if (useNormal) {
+              streams.push_back({ meshNrm.data(), sizeof(glm::vec3) });
+            }
+            if (useUV0) {
+              streams.push_back({ meshUV0.data(), sizeof(glm::vec2) });
             }
+            if (useTangent) {
+              streams.push_back({ meshTan.data(), sizeof(glm::vec3) });
+            }
+            if (useBoneStreams) {
+              streams.push_back({ meshBIndices.data(), sizeof(glm::ivec4) });
+              streams.push_back({ meshBWeights.data(), sizeof(glm::vec4) });
+            }
+            vertexOrder = OptimizeMeshIndices(meshIndices, vertexCount, streams, meshPos.data(), options.optimizeOverdraw);
+            meshCacheDirty = true;
+          }
+          if (meshCache.size() <= batchIndex) {
+            meshCache.resize(batchIndex + 1);
+          }
+          meshCache[batchIndex] = MeshCacheBatch{ vertexCount, sourceIndexCount, vertexOrder, meshIndices };
+        } else {
+          vertexOrder.resize(vertexCount);
+          for (uint32_t v = 0; v < vertexCount; ++v) {
+            vertexOrder[v] = v;
+          }
+        }
+        accumulateStats(statsAfter, mesh_optimizer::AnalyzeVertexCache(meshIndices, uint32_t(vertexOrder.size())));
 
-            uint32_t bufferSize = uint32_t(sizeof(glm::mat4) * activeBones.size());
-            usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-            batch.boneMatrixPalette = CreateUniformBuffers(bufferSize, imageCount);
+        for (auto v : vertexOrder) {
+          vbPos.push_back(meshPos[v]);
+          if (useNormal) {
+            vbNrm.push_back(meshNrm[v]);
+          }
+          if (useUV0) {
+            vbUV0.push_back(meshUV0[v]);
+          }
+          if (useTangent) {
+            vbTan.push_back(meshTan[v]);
+          }
+          if (useBoneStreams) {
+            vbBIndices.push_back(meshBIndices[v]);
+            vbBWeights.push_back(meshBWeights[v]);
           }
         }
-        totalVertexCount += mesh->mNumVertices;
-        totalIndexCount += mesh->mNumFaces * 3;
+        ibIndices.insert(ibIndices.end(), meshIndices.begin(), meshIndices.end());
+
+        batch.indexCount = uint32_t(meshIndices.size());
+        batch.vertexCount = uint32_t(vertexOrder.size());
+        totalVertexCount += vertexOrder.size();
+        totalIndexCount += batch.indexCount;
 
         model.DrawBatches.emplace_back(batch);
-        hasBone |= mesh->HasBones();
+        batchVertexCounts.push_back(uint32_t(vertexOrder.size()));
+        batchIndex++;
       }
     }
   }
 
-  for (int i = 0; i<int(model.scene->mNumMaterials); ++i) {
+  if (useMeshCache && (meshCacheDirty || meshCache.size() != batchIndex)) {
+    meshCache.resize(batchIndex);
+    WriteMeshCache(cacheFileName, cacheHeader, meshCache);
+  }
+
+  auto finishStats = [](mesh_optimizer::VertexCacheStatistics& v) {
+    v.acmr = v.triangleCount > 0 ? float(v.transformedVertices) / float(v.triangleCount) : 0.0f;
+    v.atvr = v.vertexCount > 0 ? float(v.transformedVertices) / float(v.vertexCount) : 0.0f;
+  };
+  finishStats(statsBefore);
+  finishStats(statsAfter);
+  model.cacheStatsBefore = statsBefore;
+  model.cacheStatsAfter = statsAfter;
+  {
+    std::stringstream ss;
+    ss << "[MeshOptimizer] " << model.name << (meshCacheLoaded && !meshCacheDirty ? " (cached)" : "") << std::endl;
+    ss << "  vertices " << statsBefore.vertexCount << " -> " << statsAfter.vertexCount << std::endl;
+    ss << "  ACMR " << statsBefore.acmr << " -> " << statsAfter.acmr << std::endl;
+    ss << "  ATVR " << statsBefore.atvr << " -> " << statsAfter.atvr << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+
+  // {[񖢐ݒ̈|.
+  if (useBoneStreams) {
+    for (auto& v : vbBIndices) {
+      if (v.x < 0) { v.x = 0; }
+      if (v.y < 0) { v.y = 0; }
+      if (v.z < 0) { v.z = 0; }
+      if (v.w < 0) { v.w = 0; }
+    }
+    for (auto& v : vbBWeights) {
+      if (v.x < 0.0f) { v.x = 0.0f; }
+      if (v.y < 0.0f) { v.y = 0.0f; }
+      if (v.z < 0.0f) { v.z = 0.0f; }
+      if (v.w < 0.0f) { v.w = 0.0f; }
+
+      float total = v.x + v.y + v.z + v.w;
+      assert(std::abs(total) > 0.999f && std::abs(total) < 1.01f);
+    }
+  }
+
+  // GPU ɓ]钸_Xg[. ł fp32 ̔ẑ܂܎g.
+  const void* streamData[VertexAttribute_Count] = {
+    vbPos.data(), vbNrm.data(), vbUV0.data(), vbTan.data(), vbBIndices.data(), vbBWeights.data(),
+  };
+  const void* indexData = ibIndices.data();
+  VkDeviceSize indexDataSize = sizeof(uint32_t) * ibIndices.size();
+  CompactVertexData compact;
+  if (options.compactVertexFormat) {
+    BuildCompactVertexData(
+      model, options.quantizePositions, batchVertexCounts,
+      vbPos, vbNrm, vbUV0, vbTan, vbBIndices, vbBWeights, ibIndices, compact);
+    for (int i = 0; i < VertexAttribute_Count; ++i) {
+      streamData[i] = compact.streams[i].data();
+    }
+    indexData = compact.indices.data();
+    indexDataSize = compact.indices.size();
+
+    const VkDeviceSize fullStrides[VertexAttribute_Count] = {
+      sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec2), sizeof(glm::vec3), sizeof(glm::uvec4), sizeof(glm::vec4),
+    };
+    VkDeviceSize fullVertexSize = 0, compactVertexSize = 0;
+    for (auto attr : activeAttributes) {
+      fullVertexSize += fullStrides[attr] * totalVertexCount;
+      compactVertexSize += VkDeviceSize(model.attributeSizes[attr]) * totalVertexCount;
+    }
+    VkDeviceSize fullIndexSize = sizeof(uint32_t) * totalIndexCount;
+    VkDeviceSize fullTotal = fullVertexSize + fullIndexSize;
+    VkDeviceSize compactTotal = compactVertexSize + indexDataSize;
+
+    std::stringstream ss;
+    ss << "[CompactVertex] " << model.name << std::endl;
+    ss << "  vertex " << fullVertexSize << " -> " << compactVertexSize << " bytes" << std::endl;
+    ss << "  index  " << fullIndexSize << " -> " << indexDataSize << " bytes" << std::endl;
+    ss << "  total  " << fullTotal << " -> " << compactTotal << " bytes (";
+    ss << (fullTotal > 0 ? 100.0 * double(fullTotal - compactTotal) / double(fullTotal) : 0.0) << "% saved)" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+
+  // _Xg[̔zu߂ăobt@m.
+  // Rs[gVF[_[ł̃XLjOȂǂǂ߂悤ɃXg[Wobt@ƂĂg悤ɂĂ.
+  VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  VkMemoryPropertyFlags props = GetUploadTargetMemoryProps();
+  BufferObject* vertexBuffers[VertexAttribute_Count] = {
+    &model.Position, &model.Normal, &model.UV0, &model.Tangent, &model.BoneIndices, &model.BoneWeights,
+  };
+  std::vector<uint8_t> packedVertices;
+  model.vertexLayout = options.vertexLayout;
+  model.vertexStreams.clear();
+  if (options.vertexLayout == VertexLayout_Separate) {
+    bool pooled = options.useGeometryPool && AllocateFromGeometryPool(model, activeAttributes, totalVertexCount, indexDataSize);
+    model.vertexStreams.resize(VertexAttribute_Count);
+    for (auto attr : activeAttributes) {
+      if (!pooled) {
+        *vertexBuffers[attr] = CreateBuffer(book_util::CheckedBufferSize(totalVertexCount, model.attributeSizes[attr]), usage, props);
+      }
+      model.vertexStreams[attr] = VertexStream{ vertexBuffers[attr]->buffer, 0, model.attributeSizes[attr] };
+      model.attributeStreams[attr] = attr;
+      model.attributeOffsets[attr] = 0;
+    }
+  } else {
+    // 1 ̃obt@ɃXg[ׂ.
+    std::vector<std::vector<VertexAttribute>> streamAttributes;
+    if (options.vertexLayout == VertexLayout_Interleaved) {
+      streamAttributes.push_back(activeAttributes);
+    } else {
+      // [xpXňʒuǂނƂɃLbVC𖳑ʂɂȂ悤Aʒu𕪂.
+      streamAttributes.push_back({ VertexAttribute_Position });
+      if (activeAttributes.size() > 1) {
+        streamAttributes.emplace_back(activeAttributes.begin() + 1, activeAttributes.end());
+      }
+    }
+    VkDeviceSize totalSize = 0;
+    for (const auto& attributes : streamAttributes) {
+      VertexStream stream{};
+      stream.offset = (totalSize + 15) & ~VkDeviceSize(15);
+      for (auto attr : attributes) {
+        model.attributeStreams[attr] = uint32_t(model.vertexStreams.size());
+        model.attributeOffsets[attr] = stream.stride;
+        stream.stride += model.attributeSizes[attr];
+      }
+      totalSize = stream.offset + book_util::CheckedBufferSize(totalVertexCount, stream.stride);
+      model.vertexStreams.push_back(stream);
+    }
+    packedVertices.resize(size_t(totalSize));
+    for (auto attr : activeAttributes) {
+      const auto& stream = model.vertexStreams[model.attributeStreams[attr]];
+      const auto size = model.attributeSizes[attr];
+      const auto* src = static_cast<const uint8_t*>(streamData[attr]);
+      auto* dst = packedVertices.data() + stream.offset + model.attributeOffsets[attr];
+      for (uint64_t v = 0; v < totalVertexCount; ++v) {
+        memcpy(dst + size_t(stream.stride) * v, src + size_t(size) * v, size);
+      }
+    }
+    model.VertexData = CreateBuffer(totalSize, usage, props);
+    for (auto& stream : model.vertexStreams) {
+      stream.buffer = model.VertexData.buffer;
+    }
+  }
+
+  if (model.geometryPoolIndex < 0) {
+    usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    model.Indices = CreateBuffer(indexDataSize, usage, props);
+  }
+
+  // }eÃeNX`͂܂Ƃ߂ 1 œ].
+  BeginTextureUploadBatch();
+  for (int i = 0; i<int(scene->mNumMaterials); ++i) {
     Material m{};
-    auto material = model.scene->mMaterials[i];
+    auto material = scene->mMaterials[i];
 
     std::filesystem::path baseDir(fileName);
     baseDir = baseDir.parent_path();
@@ -1025,38 +2530,36 @@ VulkanAppBase::ModelAsset VulkanAppBase::LoadModelData(std::filesystem::path fil
 
     model.materials.push_back(m);
   }
+  EndTextureUploadBatch();
   model.totalVertexCount = totalVertexCount;
   model.totalIndexCount = totalIndexCount;
 
+  // e DrawBatch ̃{[ԍ̕ϊ\A 1 ̃obt@ɂ.
+  std::vector<uint32_t> boneRemap;
+  for (auto& batch : model.DrawBatches) {
+    batch.boneRemapOffset = uint32_t(boneRemap.size());
+    boneRemap.insert(boneRemap.end(), batch.boneRemap.begin(), batch.boneRemap.end());
+  }
+  const auto boneRemapSize = VkDeviceSize(sizeof(uint32_t)) * boneRemap.size();
+  if (!boneRemap.empty()) {
+    model.BoneRemap = CreateBuffer(boneRemapSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, props);
+  }
+
   std::vector<BufferObject> stagingBufferList;
   auto command = CreateCommandBuffer();
   BufferObject staging;
-  WriteToDeviceLocalMemory(model.Position, vbPos.data(), sizeof(glm::vec3)* vbPos.size(), command, &staging); stagingBufferList.push_back(staging);
-  WriteToDeviceLocalMemory(model.Normal, vbNrm.data(), sizeof(glm::vec3)*vbNrm.size(), command, &staging); stagingBufferList.push_back(staging);
-  WriteToDeviceLocalMemory(model.UV0, vbUV0.data(), sizeof(glm::vec2)*vbUV0.size(), command, &staging); stagingBufferList.push_back(staging);
-  WriteToDeviceLocalMemory(model.Indices, ibIndices.data(), sizeof(uint32_t)*ibIndices.size(), command, &staging); stagingBufferList.push_back(staging);
-  WriteToDeviceLocalMemory(model.Tangent, vbTan.data(), sizeof(glm::vec3)* vbTan.size(), command, &staging); stagingBufferList.push_back(staging);
-
-  // {[񖢐ݒ̈|.
-  if (hasBone) {
-    for (auto& v : vbBIndices) {
-      if (v.x < 0) { v.x = 0; }
-      if (v.y < 0) { v.y = 0; }
-      if (v.z < 0) { v.z = 0; }
-      if (v.w < 0) { v.w = 0; }
-    }
-    for (auto& v : vbBWeights) {
-      if (v.x < 0.0f) { v.x = 0.0f; }
-      if (v.y < 0.0f) { v.y = 0.0f; }
-      if (v.z < 0.0f) { v.z = 0.0f; }
-      if (v.w < 0.0f) { v.w = 0.0f; }
-
-      float total = v.x + v.y + v.z + v.w;
-      assert(std::abs(total) > 0.999f && std::abs(total) < 1.01f);
+  if (model.vertexLayout == VertexLayout_Separate) {
+    for (auto attr : activeAttributes) {
+      VkDeviceSize size = VkDeviceSize(model.attributeSizes[attr]) * totalVertexCount;
+      VkDeviceSize dstOffset = VkDeviceSize(model.attributeSizes[attr]) * model.poolVertexBase;
+      WriteToDeviceLocalMemory(*vertexBuffers[attr], streamData[attr], size, command, &staging, dstOffset); stagingBufferList.push_back(staging);
     }
-
-    WriteToDeviceLocalMemory(model.BoneIndices, vbBIndices.data(), sizeof(glm::uvec4)*vbBIndices.size(), command, &staging); stagingBufferList.push_back(staging);
-    WriteToDeviceLocalMemory(model.BoneWeights, vbBWeights.data(), sizeof(glm::vec4)*vbBWeights.size(), command, &staging); stagingBufferList.push_back(staging);
+  } else {
+    WriteToDeviceLocalMemory(model.VertexData, packedVertices.data(), packedVertices.size(), command, &staging); stagingBufferList.push_back(staging);
+  }
+  WriteToDeviceLocalMemory(model.Indices, indexData, indexDataSize, command, &staging, model.poolIndexBase); stagingBufferList.push_back(staging);
+  if (!boneRemap.empty()) {
+    WriteToDeviceLocalMemory(model.BoneRemap, boneRemap.data(), boneRemapSize, command, &staging); stagingBufferList.push_back(staging);
   }
   FinishCommandBuffer(command);
   DestroyCommandBuffer(command);
@@ -1068,70 +2571,583 @@ VulkanAppBase::ModelAsset VulkanAppBase::LoadModelData(std::filesystem::path fil
   auto mtx = ConvertMatrix(scene->mRootNode->mTransformation);
   model.invGlobalTransform = glm::inverse(mtx);
 
-  model.rootNode->UpdateMatrices(glm::mat4(1.0f));
+  // Aj[V͎sɎg`֕ϊĕێ.
+  if (!options.compressAnimations) {
+    model.animations.reserve(scene->mNumAnimations);
+    for (uint32_t i = 0; i < scene->mNumAnimations; ++i) {
+      model.animations.push_back(ConvertAnimation(scene->mAnimations[i], utf8NodeNames));
+    }
+  } else if (scene->mNumAnimations > 0) {
+    auto animCacheFileName = fileName;
+    animCacheFileName += ".animcache";
+    auto animCacheHeader = MakeAnimationCacheHeader(fileName, options.animationCompression);
+    animCacheHeader.clipCount = scene->mNumAnimations;
+    bool animCacheLoaded = options.useMeshCache && ReadAnimationCache(animCacheFileName, animCacheHeader, model.compressedAnimations);
+    if (animCacheLoaded) {
+      // LbVɂ̓m[hĂ̂ŁAŔԍ.
+      for (auto& clip : model.compressedAnimations) {
+        for (auto& ch : clip.channels) {
+          ch.node = model.nodes.FindNode(ch.nodeName);
+        }
+      }
+      std::stringstream ss;
+      ss << "[AnimCompression] " << model.compressedAnimations.size() << " clips loaded from " << animCacheFileName.filename().string() << std::endl;
+      OutputDebugStringA(ss.str().c_str());
+    } else {
+      model.compressedAnimations.reserve(scene->mNumAnimations);
+      for (uint32_t i = 0; i < scene->mNumAnimations; ++i) {
+        // ϊ񈳏k̃Nbv͈kシɎ̂Ă.
+        animation::CompressionReport report;
+        model.compressedAnimations.push_back(
+          animation::CompressClip(ConvertAnimation(scene->mAnimations[i], utf8NodeNames), options.animationCompression, &report));
+        const auto& clip = model.compressedAnimations.back();
+        const auto assimpBytes = GetAssimpAnimationSize(scene->mAnimations[i]);
+
+        std::stringstream ss;
+        ss << "[AnimCompression] " << clip.name << " : " << clip.channels.size() << " channels, "
+          << report.sourceKeyCount << " -> " << report.keptKeyCount << " keys" << std::endl;
+        ss << "  bytes : assimp " << assimpBytes << ", runtime " << report.sourceBytes << " -> " << report.compressedBytes
+          << " (ratio " << (report.compressedBytes ? double(assimpBytes) / report.compressedBytes : 0.0) << " : 1)" << std::endl;
+        for (const auto& e : report.channels) {
+          ss << "  " << e.nodeName << " : keys " << e.sourceKeyCount << " -> " << e.keptKeyCount
+            << ", max error T " << e.translation << " R " << glm::degrees(e.rotation) << " deg S " << e.scale << std::endl;
+        }
+        OutputDebugStringA(ss.str().c_str());
+      }
+      if (options.useMeshCache) {
+        WriteAnimationCache(animCacheFileName, animCacheHeader, model.compressedAnimations);
+      }
+    }
+  }
+  if (!model.skeletonNodes.empty()) {
+    size_t boneReferences = 0;
+    for (const auto& batch : model.DrawBatches) {
+      boneReferences += batch.boneRemap.size();
+    }
+    std::stringstream ss;
+    ss << "[Skeleton] " << model.name << ": " << model.nodes.GetNodeCount() << " nodes, "
+      << model.skeletonNodes.size() << " bones, " << boneReferences << " bone references ("
+      << boneRemapHits << " resolved by remap table)" << std::endl;
+    ss << "  palette " << model.skeletonNodes.size() << " matrices per frame (per-batch palettes would need " << boneReferences << ")" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+
+  // aiScene . ȍ~ ModelAsset f[^œ삷.
+  aiMemoryInfo sceneMemory{};
+  importer.GetMemoryRequirements(sceneMemory);
+  importer.FreeScene();
+  scene = nullptr;
+  {
+    size_t nodeCount = model.nodes.GetNodeCount(), nodeBytes = model.nodes.GetMemorySize(), animationBytes = 0;
+    for (const auto& clip : model.animations) {
+      animationBytes += clip.GetMemorySize();
+    }
+    for (const auto& clip : model.compressedAnimations) {
+      animationBytes += clip.GetMemorySize();
+    }
+    size_t retained = nodeBytes + animationBytes;
+    std::stringstream ss;
+    ss << "[ModelMemory] " << model.name << std::endl;
+    ss << "  aiScene released : " << sceneMemory.total << " bytes" << std::endl;
+    ss << "  retained nodes   : " << nodeCount << " (" << nodeBytes << " bytes)" << std::endl;
+    ss << "  retained anims   : " << model.animations.size() + model.compressedAnimations.size() << " clips (" << animationBytes << " bytes)" << std::endl;
+    ss << "  total            : " << sceneMemory.total << " -> " << retained << " bytes" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+
+  model.nodes.UpdateWorldMatrices();
   return model;
 }
 
-VulkanAppBase::ImageObject VulkanAppBase::LoadTexture(std::filesystem::path fileName)
+// 2x2 ̃{bNXtB^ŏk. TCY̒[͍Ō̗/sJԂ.
+static void DownsampleRGBA8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+  for (uint32_t y = 0; y < dstHeight; ++y) {
+    auto y0 = std::min(y * 2, srcHeight - 1), y1 = std::min(y * 2 + 1, srcHeight - 1);
+    for (uint32_t x = 0; x < dstWidth; ++x) {
+      auto x0 = std::min(x * 2, srcWidth - 1), x1 = std::min(x * 2 + 1, srcWidth - 1);
+      for (int c = 0; c < 4; ++c) {
+        uint32_t sum =
+          src[(y0 * srcWidth + x0) * 4 + c] + src[(y0 * srcWidth + x1) * 4 + c] +
+          src[(y1 * srcWidth + x0) * 4 + c] + src[(y1 * srcWidth + x1) * 4 + c];
+        dst[(y * dstWidth + x) * 4 + c] = uint8_t((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+uint64_t VulkanAppBase::HashTexturePath(const std::filesystem::path& fileName)
+{
+  // FNV-1a. t@Cwʂ̏L[ɂȂ悤A"."  ".." ċ؂ '/' ɑ.
+  // Windows ̃t@CVXeɍ킹đ啶ʂȂ.
+  uint64_t hash = 14695981039346656037ull;
+  for (auto c : fileName.lexically_normal().generic_wstring()) {
+    auto v = uint32_t(std::towlower(c));
+    for (int i = 0; i < int(sizeof(c)); ++i) {
+      hash ^= (v >> (i * 8)) & 0xFF;
+      hash *= 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+void VulkanAppBase::SetFrameDeltaTime(double t)
+{
+  m_frameDeltaTime = t;
+  m_frameNumber++;
+  DestroyPendingTextures(false);
+}
+
+void VulkanAppBase::ReleaseTexture(const ImageObject& texture)
+{
+  auto key = m_textureKeys.find(texture.image);
+  if (key != m_textureKeys.end()) {
+    auto& entry = m_textureDatabase.at(key->second);
+    if (entry.refCount > 0) {
+      entry.refCount--;
+    }
+    entry.lastUsedFrame = m_frameNumber;
+  }
+  EvictTextures();
+}
+
+void VulkanAppBase::SetTextureMemoryBudget(VkDeviceSize bytes)
+{
+  m_textureMemoryBudget = bytes;
+  EvictTextures();
+}
+
+void VulkanAppBase::EvictTextures()
+{
+  // \Z𒴂ĂԁAQƂĂȂ̂Âɒǂo.
+  while (m_textureCacheStats.residentBytes > m_textureMemoryBudget) {
+    auto victim = m_textureDatabase.end();
+    for (auto it = m_textureDatabase.begin(); it != m_textureDatabase.end(); ++it) {
+      if (it->second.refCount > 0) {
+        continue;
+      }
+      if (victim == m_textureDatabase.end() || it->second.lastUsedFrame < victim->second.lastUsedFrame) {
+        victim = it;
+      }
+    }
+    if (victim == m_textureDatabase.end()) {
+      break;
+    }
+    // L^ς݂̃R}hobt@QƂĂ邩Ȃ̂ŁAɂ͔jȂ.
+    m_pendingTextureDestroy.push_back(PendingTextureDestroy{ victim->second.image, m_frameNumber });
+    m_textureCacheStats.residentBytes -= victim->second.memorySize;
+    m_textureCacheStats.evictions++;
+    std::stringstream ss;
+    ss << "[TextureCache] evict " << victim->second.path << " (" << victim->second.memorySize << " bytes)" << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+    m_textureKeys.erase(victim->second.image.image);
+    m_textureDatabase.erase(victim);
+  }
+}
+
+void VulkanAppBase::DestroyPendingTextures(bool force)
+{
+  // Xbv`FC̃C[W̃t[߂ GPU ͎gIĂ.
+  uint64_t latency = m_swapchain ? m_swapchain->GetImageCount() : 0;
+  auto it = m_pendingTextureDestroy.begin();
+  while (it != m_pendingTextureDestroy.end()) {
+    if (force || m_frameNumber > it->frame + latency) {
+      DestroyImage(it->image);
+      it = m_pendingTextureDestroy.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+VulkanAppBase::TextureCacheStats VulkanAppBase::GetTextureCacheStats() const
+{
+  auto stats = m_textureCacheStats;
+  stats.budgetBytes = m_textureMemoryBudget;
+  stats.textureCount = uint32_t(m_textureDatabase.size());
+  stats.unreferencedCount = 0;
+  for (const auto& t : m_textureDatabase) {
+    if (t.second.refCount == 0) {
+      stats.unreferencedCount++;
+    }
+  }
+  stats.pendingDestroyCount = uint32_t(m_pendingTextureDestroy.size());
+  return stats;
+}
+
+VulkanAppBase::StagingAllocation VulkanAppBase::AcquireStagingSlab(VkDeviceSize size)
+{
+  // ]҂̃Xu̎cɂl߂. ܂̂̂c肪ŏ̂̂g.
+  auto alignUp = [&](VkDeviceSize v) { return (v + m_stagingAlignment - 1) & ~(m_stagingAlignment - 1); };
+  int found = -1;
+  VkDeviceSize foundRemain = 0;
+  for (int i = 0; i < int(m_stagingSlabs.size()); ++i) {
+    const auto& slab = m_stagingSlabs[i];
+    if (slab.buffer.buffer == VK_NULL_HANDLE) {
+      continue;
+    }
+    auto offset = alignUp(slab.used);
+    if (offset > slab.buffer.size || slab.buffer.size - offset < size) {
+      continue;
+    }
+    auto remain = slab.buffer.size - offset - size;
+    if (found < 0 || remain < foundRemain) {
+      found = i;
+      foundRemain = remain;
+    }
+  }
+  if (found >= 0) {
+    auto& slab = m_stagingSlabs[found];
+    StagingAllocation alloc;
+    alloc.slab = found;
+    alloc.offset = alignUp(slab.used);
+    alloc.size = size;
+    slab.used = alloc.offset + size;
+    slab.users++;
+    m_stagingStats.slabReuses++;
+    return alloc;
+  }
+
+  StagingSlab slab;
+  auto slabSize = std::max(size, m_stagingSlabSize);
+  VkBufferCreateInfo bufferCI{
+    VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    nullptr, 0,
+    slabSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+    VK_SHARING_MODE_EXCLUSIVE,
+    0, nullptr
+  };
+  auto result = vkCreateBuffer(m_device, &bufferCI, nullptr, &slab.buffer.buffer);
+  ThrowIfFailed(result, "vkCreateBuffer Failed.");
+
+  // fR[_[͏񂾓eǂݕԂ (PNG ̃tB^) ̂ŁALbV̌D悷.
+  VkMemoryRequirements reqs;
+  vkGetBufferMemoryRequirements(m_device, slab.buffer.buffer, &reqs);
+  auto typeIndex = GetMemoryTypeIndex(reqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+  if (typeIndex == ~0u) {
+    typeIndex = GetMemoryTypeIndex(reqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  }
+  VkMemoryAllocateInfo info{
+    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    nullptr,
+    reqs.size,
+    typeIndex
+  };
+  result = vkAllocateMemory(m_device, &info, nullptr, &slab.buffer.memory);
+  ThrowIfFailed(result, "vkAllocateMemory Failed.");
+  vkBindBufferMemory(m_device, slab.buffer.buffer, slab.buffer.memory, 0);
+  void* mapped = nullptr;
+  result = vkMapMemory(m_device, slab.buffer.memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+  ThrowIfFailed(result, "vkMapMemory Failed.");
+  slab.mapped = static_cast<uint8_t*>(mapped);
+  slab.buffer.size = slabSize;
+  slab.coherent = (m_physicalMemProps.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+  slab.used = size;
+  slab.users = 1;
+
+  m_stagingStats.slabCreates++;
+  m_stagingStats.slabCount++;
+  m_stagingStats.slabBytes += slabSize;
+  std::stringstream ss;
+  ss << "[Staging] create slab: " << (slabSize >> 20) << " MB"
+    << ((m_physicalMemProps.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) ? " cached" : " uncached")
+    << (slab.coherent ? " coherent" : "") << std::endl;
+  OutputDebugStringA(ss.str().c_str());
+
+  StagingAllocation alloc;
+  alloc.size = size;
+  // jς݂̘gΎg (gpXũCfbNX𓮂Ȃ).
+  for (int i = 0; i < int(m_stagingSlabs.size()); ++i) {
+    if (m_stagingSlabs[i].buffer.buffer == VK_NULL_HANDLE) {
+      m_stagingSlabs[i] = slab;
+      alloc.slab = i;
+      return alloc;
+    }
+  }
+  m_stagingSlabs.push_back(slab);
+  alloc.slab = int(m_stagingSlabs.size()) - 1;
+  return alloc;
+}
+
+void VulkanAppBase::ShrinkStagingAllocation(StagingAllocation& alloc, VkDeviceSize size)
+{
+  // ̊蓖ĂȂgȂ (fR[h̍Ɨ̈Ȃ) ̊蓖ĂɕԂ.
+  auto& slab = m_stagingSlabs[alloc.slab];
+  if (size < alloc.size && slab.used == alloc.offset + alloc.size) {
+    slab.used = alloc.offset + size;
+  }
+  alloc.size = std::min(alloc.size, size);
+}
+
+void VulkanAppBase::ReleaseStagingSlab(const StagingAllocation& alloc)
+{
+  auto& slab = m_stagingSlabs[alloc.slab];
+  assert(slab.users > 0);
+  if (slab.used == alloc.offset + alloc.size) {
+    slab.used = alloc.offset;
+  }
+  if (--slab.users > 0) {
+    return;
+  }
+  slab.used = 0;
+  // TCY𒴂ꎞIȃXu͕ێȂ.
+  if (slab.buffer.size > m_stagingSlabSize) {
+    vkUnmapMemory(m_device, slab.buffer.memory);
+    m_stagingStats.slabCount--;
+    m_stagingStats.slabBytes -= slab.buffer.size;
+    DestroyBuffer(slab.buffer);
+    slab = StagingSlab{};
+  }
+}
+
+void VulkanAppBase::FlushStagingSlab(const StagingAllocation& alloc)
+{
+  const auto& slab = m_stagingSlabs[alloc.slab];
+  m_stagingStats.bytesStaged += alloc.size;
+  if (slab.coherent) {
+    return;
+  }
+  FlushMappedRange(slab.buffer.memory, alloc.offset, alloc.size, slab.buffer.size);
+}
+
+void VulkanAppBase::DestroyStagingSlabs()
 {
-  auto it = m_textureDatabase.find(fileName.string());
+  for (auto& slab : m_stagingSlabs) {
+    if (slab.buffer.buffer != VK_NULL_HANDLE) {
+      vkUnmapMemory(m_device, slab.buffer.memory);
+      DestroyBuffer(slab.buffer);
+    }
+  }
+  m_stagingSlabs.clear();
+  m_stagingStats.slabCount = 0;
+  m_stagingStats.slabBytes = 0;
+}
+
+VulkanAppBase::ImageObject VulkanAppBase::LoadTexture(std::filesystem::path fileName, VkPipelineStageFlags dstStageMask)
+{
+  auto key = HashTexturePath(fileName);
+  auto it = m_textureDatabase.find(key);
   if (it != m_textureDatabase.end()) {
-    return it->second;
+    it->second.refCount++;
+    it->second.lastUsedFrame = m_frameNumber;
+    m_textureCacheStats.hits++;
+    return it->second.image;
   }
+  m_textureCacheStats.misses++;
   ImageObject texture{};
-  BufferObject stagingBuffer;
 
   int width = 0, height = 0;
-  stbi_uc* imageData = nullptr;
-  std::vector<char> imageDataKtx;
   VkFormat format;
 
   auto ext = fileName.extension().string();
+  std::vector<VkBufferImageCopy> regions;
+  bool generateMipmaps = false;
+
+  // fR[_[̓Xe[WOXu֒ڏ. Xu͓]Ɏ̓ǂݍ݂ōėp.
+  StagingAllocation staging;
+  VkDeviceSize stagingSize = 0;
+  auto ktxAllocator = [&](uint64_t size) -> uint8_t* {
+    staging = AcquireStagingSlab(size);
+    stagingSize = size;
+    return m_stagingSlabs[staging.slab].mapped + staging.offset;
+  };
+
+  // TextureCook ŕϊς݂ .ktx2 摜V΁AD悷.
+  // ǂ߂ȂA܂̓foCXΉ̃tH[}bgȂ猳摜 stb œǂݍ.
+  ktx_texture::TextureData ktx;
+  bool ktxLoaded = false;
   if (ext == ".tga" || ext == ".png" || ext == ".jpg") {
-    imageData = stbi_load(fileName.string().c_str(), &width, &height, nullptr, 4);
-    if (imageData == nullptr) {
+    auto cookedPath = fileName;
+    cookedPath.replace_extension(".ktx2");
+    std::error_code ec;
+    if (std::filesystem::exists(cookedPath, ec) &&
+      std::filesystem::last_write_time(cookedPath, ec) >= std::filesystem::last_write_time(fileName, ec)) {
+      std::string error;
+      ktxLoaded = ktx_texture::Load(cookedPath, ktx, ktxAllocator, &error);
+      if (ktxLoaded && !IsTextureFormatSupported(ktx.format)) {
+        ktxLoaded = false;
+        error = "format is not supported on this device.";
+      }
+      if (ktxLoaded) {
+        ext = ".ktx2";
+      } else {
+        if (staging.slab >= 0) {
+          ReleaseStagingSlab(staging);
+          staging = StagingAllocation{};
+        }
+        std::stringstream ss;
+        ss << "[LoadTexture] " << cookedPath.string() << ": " << error << " (fallback to source image)" << std::endl;
+        OutputDebugStringA(ss.str().c_str());
+      }
+    }
+  }
+  if (ext == ".tga" || ext == ".png" || ext == ".jpg") {
+    int components = 0;
+    if (!stbi_info(fileName.string().c_str(), &width, &height, &components)) {
       DebugBreak();//Texture Not found
     }
-    VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     format = VK_FORMAT_R8G8B8A8_UNORM;
-    texture = CreateTexture(uint32_t(width), uint32_t(height), format, usage);
-
-    VkMemoryPropertyFlags memProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    VkBufferUsageFlags usageBuffer = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    auto rowSize = uint32_t(width * sizeof(uint32_t));
-    auto bufferSize = height * rowSize;
-    stagingBuffer = CreateBuffer(bufferSize, usageBuffer, memProps);
-    WriteToHostVisibleMemory(stagingBuffer.memory, bufferSize, imageData);
-  }
-  if (ext == ".ktx") {
-    imageDataKtx = ktx_load(fileName.string().c_str(), &width, &height);
-    // KTX ł Float eNX`̂ݎbΉ.
+    // k\ł̃GCAVOƑш}邽߁A~bv`FC.
+    // Blit ɑΉĂ΃x 0 ] GPU ŏkAłȂ CPU ŏk̂].
+    auto mipLevels = CalcMipLevels(uint32_t(width), uint32_t(height));
+    generateMipmaps = mipLevels > 1 && IsMipmapBlitSupported(format);
     VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    texture = CreateTexture(uint32_t(width), uint32_t(height), format, usage);
+    if (generateMipmaps) {
+      usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
 
-    VkMemoryPropertyFlags memProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    VkBufferUsageFlags usageBuffer = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    auto rowSize = uint32_t(width * sizeof(float)*4);
-    auto bufferSize = height * rowSize;
-    stagingBuffer = CreateBuffer(bufferSize, usageBuffer, memProps);
-    WriteToHostVisibleMemory(stagingBuffer.memory, bufferSize, imageDataKtx.data());
+    // XȗO stb ̃A[iɂ. fR[hr̍Ɨ̈ (zlib WJA`lϊ) 
+    // ̂ŁAŏI摜 3 {. CPU Ń~bvƂ͂̌ɕׂ.
+    VkDeviceSize levelSize = VkDeviceSize(width) * height * 4;
+    VkDeviceSize arenaSize = levelSize * 3 + (1 << 20);
+    VkDeviceSize mipChainSize = 0;
+    if (!generateMipmaps) {
+      for (uint32_t level = 1; level < mipLevels; ++level) {
+        VkDeviceSize w = std::max(uint32_t(width) >> level, 1u), h = std::max(uint32_t(height) >> level, 1u);
+        mipChainSize += (w * h * 4 + 15) & ~VkDeviceSize(15);
+      }
+    }
+    staging = AcquireStagingSlab(arenaSize + mipChainSize);
+    auto mapped = m_stagingSlabs[staging.slab].mapped + staging.offset;
+
+    StbArena arena;
+    arena.base = mapped;
+    arena.capacity = size_t(arenaSize);
+    s_stbArena = &arena;
+    auto imageData = stbi_load(fileName.string().c_str(), &width, &height, nullptr, 4);
+    if (imageData == nullptr) {
+      s_stbArena = nullptr;
+      DebugBreak();//Texture Not found
+    }
+    VkDeviceSize levelOffset = 0;
+    if (arena.Contains(imageData)) {
+      levelOffset = VkDeviceSize(imageData - mapped);
+      m_stagingStats.decodeInPlace++;
+    } else {
+      // A[iɎ܂Ȃ. q[v̌ʂXu̐擪֎ʂ (Ɨ̈͂gĂȂ).
+      levelOffset = 0;
+      arena.offset = 0;
+      memcpy(mapped + levelOffset, imageData, size_t(levelSize));
+      stbi_image_free(imageData);
+      m_stagingStats.decodeFallback++;
+    }
+    s_stbArena = nullptr;
+    // ~bv̓A[ig̈̌ɒu.
+    VkDeviceSize mipOffset = std::max<VkDeviceSize>(arena.offset, levelOffset + levelSize);
+    texture = CreateTexture(uint32_t(width), uint32_t(height), format, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mipLevels);
+
+    uint32_t levelWidth = uint32_t(width), levelHeight = uint32_t(height);
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+      VkBufferImageCopy region{};
+      region.bufferOffset = staging.offset + levelOffset;
+      region.imageExtent = { levelWidth, levelHeight, 1 };
+      region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+      regions.push_back(region);
+      stagingSize = levelOffset + VkDeviceSize(levelWidth) * levelHeight * 4;
+      if (generateMipmaps || level + 1 == mipLevels) {
+        break;
+      }
+      auto nextWidth = std::max(levelWidth / 2, 1u), nextHeight = std::max(levelHeight / 2, 1u);
+      auto nextOffset = (std::max(mipOffset, stagingSize) + 15) & ~VkDeviceSize(15);
+      DownsampleRGBA8(mapped + levelOffset, levelWidth, levelHeight, mapped + nextOffset, nextWidth, nextHeight);
+      levelWidth = nextWidth;
+      levelHeight = nextHeight;
+      levelOffset = nextOffset;
+    }
+    // Ɨ̈̓̕XuɕԂA㑱̃eNX`l߂悤ɂ.
+    ShrinkStagingAllocation(staging, stagingSize);
+  }
+  if ((ext == ".ktx" || ext == ".ktx2") && !ktxLoaded) {
+    std::string error;
+    ktxLoaded = ktx_texture::Load(fileName, ktx, ktxAllocator, &error);
+    if (ktxLoaded && !IsTextureFormatSupported(ktx.format)) {
+      ktxLoaded = false;
+      error = "format is not supported on this device.";
+    }
+    if (!ktxLoaded) {
+      if (staging.slab >= 0) {
+        ReleaseStagingSlab(staging);
+      }
+      std::stringstream ss;
+      ss << "[LoadTexture] " << fileName.string() << ": " << error << std::endl;
+      OutputDebugStringA(ss.str().c_str());
+      return LoadTexture("assets/texture/white.png", dstStageMask);
+    }
+  }
+  if (ktxLoaded) {
+    VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+    if (ktx.depth > 1) {
+      viewType = VK_IMAGE_VIEW_TYPE_3D;
+    } else if (ktx.IsCubemap()) {
+      viewType = ktx.isArray ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+    } else if (ktx.isArray) {
+      viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    }
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    format = ktx.format;
+    width = int(ktx.width);
+    height = int(ktx.height);
+    texture = CreateTextureLayered(ktx.width, ktx.height, ktx.depth, format, usage, ktx.mipLevels, ktx.GetLayerCount(), viewType);
+
+    // STu\[X̓Xuɕł̂ŁÄׂĈxɓ].
+    for (const auto& sub : ktx.subresources) {
+      VkBufferImageCopy region{};
+      region.bufferOffset = staging.offset + sub.offset;
+      region.imageExtent = { sub.width, sub.height, sub.depth };
+      region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, sub.level, sub.layer, 1 };
+      regions.push_back(region);
+    }
   }
 
-  VkBufferImageCopy region{};
-  region.imageExtent = { uint32_t(width), uint32_t(height), 1 };
-  region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
-  TransferStageBufferToImage(stagingBuffer, texture, &region);
-
-  if (imageData) {
-    stbi_image_free(imageData);
+  if (staging.slab < 0) {
+    std::stringstream ss;
+    ss << "[LoadTexture] " << fileName.string() << ": unsupported file type." << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+    return LoadTexture("assets/texture/white.png", dstStageMask);
   }
-  DestroyBuffer(stagingBuffer);
   texture.width = width;
   texture.height = height;
   texture.format = format;
+  // œK^CÕC[W̓zXg璼ڏȂ̂ŁAłRs[œ].
+  m_uploadStats.imageCount++;
+  m_uploadStats.imageBytes += stagingSize;
+  {
+    std::stringstream ss;
+    ss << "[Upload] image   " << stagingSize << " bytes " << fileName.string() << std::endl;
+    OutputDebugStringA(ss.str().c_str());
+  }
+  FlushStagingSlab(staging);
+  TextureUpload upload;
+  upload.srcBuffer = m_stagingSlabs[staging.slab].buffer.buffer;
+  upload.dstImage = texture;
+  upload.regions = std::move(regions);
+  upload.generateMipmaps = generateMipmaps;
+  upload.dstStageMask = dstStageMask;
+  if (m_textureUploadBatchDepth > 0) {
+    // 蓖Ă܂ܗ߂. ߂ƃXe[WOcނ̂ŁAۂɋl߂ʂ\Z𒴂rőM.
+    m_pendingTextureUploads.push_back(std::move(upload));
+    m_pendingTextureUploadSlabs.push_back(staging);
+    m_pendingTextureUploadBytes += (staging.size + m_stagingAlignment - 1) & ~(m_stagingAlignment - 1);
+    if (m_pendingTextureUploadBytes > m_textureUploadBatchBudget) {
+      FlushTextureUploadBatch();
+    }
+  } else {
+    TransferStageBuffersToImages({ upload });
+    ReleaseStagingSlab(staging);
+  }
 
-  m_textureDatabase[fileName.string()] = texture;
+  TextureCacheEntry entry;
+  entry.image = texture;
+  entry.path = fileName.string();
+  entry.refCount = 1;
+  entry.lastUsedFrame = m_frameNumber;
+  VkMemoryRequirements reqs;
+  vkGetImageMemoryRequirements(m_device, texture.image, &reqs);
+  entry.memorySize = reqs.size;
+  m_textureCacheStats.residentBytes += reqs.size;
+  m_textureDatabase[key] = entry;
+  m_textureKeys[texture.image] = key;
+  EvictTextures();
   return texture;
 }
 
@@ -1268,6 +3284,7 @@ void VulkanAppBase::CreateDescriptorPool()
     { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
     { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10000 },
     { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 100},
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000 },
   };
   VkDescriptorPoolCreateInfo descPoolCI{
     VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
@@ -1349,60 +3366,98 @@ void VulkanAppBase::MsgLoopMinimizedWindow()
   } while (width == 0 || height == 0);
 }
 
-std::shared_ptr<VulkanAppBase::Node> VulkanAppBase::ModelAsset::FindNode(const std::string& name)
+void VulkanAppBase::ModelAsset::GetVertexInputDescription(
+  const std::vector<VertexAttribute>& attributes,
+  std::vector<VkVertexInputBindingDescription>& bindings,
+  std::vector<VkVertexInputAttributeDescription>& attribs) const
 {
-  std::stack<std::shared_ptr<Node>> nodes;
-  nodes.push(rootNode);
-  while (!nodes.empty()) {
-    auto node = nodes.top();
-    nodes.pop();
-
-    if (node->name == name) {
-      return node;
+  std::vector<uint32_t> streamBindings(vertexStreams.size(), ~0u);
+  for (uint32_t i = 0; i < uint32_t(attributes.size()); ++i) {
+    auto attr = attributes[i];
+    assert((attributeMask & VertexAttributeBit(attr)) && "attribute was not loaded.");
+    auto streamIndex = attributeStreams[attr];
+    if (streamBindings[streamIndex] == ~0u) {
+      streamBindings[streamIndex] = uint32_t(bindings.size());
+      // binding, stride, rate
+      bindings.push_back({ streamBindings[streamIndex], vertexStreams[streamIndex].stride, VK_VERTEX_INPUT_RATE_VERTEX });
     }
+    // location, binding, format, offset
+    attribs.push_back({ i, streamBindings[streamIndex], vertexFormats[attr], attributeOffsets[attr] });
+  }
+}
 
-    for (auto& child : node->children) {
-      nodes.push(child);
+void VulkanAppBase::ModelAsset::BindVertexBuffers(VkCommandBuffer command, const std::vector<VertexAttribute>& attributes) const
+{
+  std::vector<bool> bound(vertexStreams.size(), false);
+  std::vector<VkBuffer> buffers;
+  std::vector<VkDeviceSize> offsets;
+  for (auto attr : attributes) {
+    assert((attributeMask & VertexAttributeBit(attr)) && "attribute was not loaded.");
+    auto streamIndex = attributeStreams[attr];
+    if (bound[streamIndex]) {
+      continue;
     }
+    bound[streamIndex] = true;
+    buffers.push_back(vertexStreams[streamIndex].buffer);
+    offsets.push_back(vertexStreams[streamIndex].offset);
   }
-  return nullptr;
+  vkCmdBindVertexBuffers(command, 0, uint32_t(buffers.size()), buffers.data(), offsets.data());
 }
 
-void VulkanAppBase::ModelAsset::Release(VulkanAppBase* base)
+void VulkanAppBase::ModelAsset::GetSkinnedVertexInputDescription(
+  std::vector<VkVertexInputBindingDescription>& bindings,
+  std::vector<VkVertexInputAttributeDescription>& attribs)
 {
-  delete importer;
-  scene = nullptr;
-  importer = nullptr;
+  // binding, stride, rate
+  bindings.push_back({ 0, SkinnedVertexStride, VK_VERTEX_INPUT_RATE_VERTEX });
+  // location, binding, format, offset
+  attribs.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 });
+  attribs.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3 });
+  attribs.push_back({ 2, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 6 });
+}
+
+void VulkanAppBase::ModelAsset::BindSkinnedVertexBuffer(VkCommandBuffer command) const
+{
+  VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(command, 0, 1, &SkinnedVertices.buffer, &offset);
+}
+
+uint32_t VulkanAppBase::DrawBatch::GetFirstIndex() const
+{
+  return book_util::CheckedUint32(indexOffsetCount);
+}
 
-  base->DestroyBuffer(this->Position);
-  base->DestroyBuffer(this->Normal);
-  base->DestroyBuffer(this->UV0);
-  base->DestroyBuffer(this->Indices);
-  base->DestroyBuffer(this->BoneIndices);
-  base->DestroyBuffer(this->BoneWeights);
-  base->DestroyBuffer(this->Tangent);
+int32_t VulkanAppBase::DrawBatch::GetVertexOffset() const
+{
+  return book_util::CheckedInt32(int64_t(vertexOffsetCount));
+}
+
+int32_t VulkanAppBase::ModelAsset::GetSkinnedVertexOffset(const DrawBatch& batch) const
+{
+  return book_util::CheckedInt32(int64_t(batch.vertexOffsetCount - poolVertexBase));
+}
+
+void VulkanAppBase::ModelAsset::Release(VulkanAppBase* base)
+{
+  // WIg͋LĂ̂ŎQƃJEg炷.
+  base->ReleaseModelGeometry(geometryKey);
+  geometryKey.clear();
 
   for (auto& b : extraBuffers) {
     base->DestroyBuffer(b.second);
   }
   extraBuffers.clear();
 
+  for (auto& mtxPalette : boneMatrixPalette) {
+    base->DestroyBuffer(mtxPalette);
+  }
+  boneMatrixPalette.clear();
+  base->DestroyBuffer(SkinnedVertices);
+  SkinnedVertices = BufferObject{};
   for (auto& batch : this->DrawBatches) {
-    for (auto& mtxPalette : batch.boneMatrixPalette) {
-      base->DestroyBuffer(mtxPalette);
-    }
-    batch.boneMatrixPalette.clear();
     for (auto& modelUBO : batch.modelMeshParameterUBO) {
       base->DestroyBuffer(modelUBO);
     }
     batch.modelMeshParameterUBO.clear();
   }
 }
-
-void VulkanAppBase::Node::UpdateMatrices(glm::mat4 mtxParent)
-{
-  worldTransform = mtxParent * transform;
-  for (auto& c : children) {
-    c->UpdateMatrices(worldTransform);
-  }
-}
@@ -10,6 +10,7 @@
 #include <functional>
 #include <algorithm>
 #include <filesystem>
+#include <array>
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
@@ -24,8 +25,14 @@
 #include <assimp/postprocess.h>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include "Swapchain.h"
+#include "MeshOptimizer.h"
+#include "GeometryPool.h"
+#include "NodeHierarchy.h"
+#include "Animation.h"
+#include "AnimationCompression.h"
 
 template<class T>
 class VulkanObjectStore
@@ -92,6 +99,8 @@ public:
     VkBuffer buffer{};
     VkDeviceMemory memory{};
     VkDeviceSize size{};
+    // ۂɊ蓖Ăꂽ^Cv̑. HOST_VISIBLE Ȃ WriteToDeviceLocalMemory ͒ڏ.
+    VkMemoryPropertyFlags memoryProps{};
   };
   struct ImageObject
   {
@@ -101,10 +110,15 @@ public:
     uint32_t width;
     uint32_t height;
     VkFormat format;
+    uint32_t mipLevels = 1;
+    uint32_t arrayLayers = 1;
   };
 
-  BufferObject CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
-  ImageObject CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkMemoryPropertyFlags memPropsFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  // mۂłȂ傫 (q[v maxMemoryAllocationSize 𒴂) ̏ꍇ͗O𓊂.
+  BufferObject CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
+  ImageObject CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkMemoryPropertyFlags memPropsFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, uint32_t mipLevels = 1);
+  // z/L[u}bv/3D eNX`̐. viewType  CUBE/CUBE_ARRAY Ȃ arrayLayers  6 ̔{.
+  ImageObject CreateTextureLayered(uint32_t width, uint32_t height, uint32_t depth, VkFormat format, VkImageUsageFlags usage, uint32_t mipLevels, uint32_t arrayLayers, VkImageViewType viewType);
   VkFramebuffer CreateFramebuffer(VkRenderPass renderPass, uint32_t width, uint32_t height, uint32_t viewCount, VkImageView* views);
   VkFence CreateFence();
   VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout dsLayout);
@@ -121,37 +135,85 @@ public:
 
   VkRect2D GetSwapchainRenderArea() const;
 
-  std::vector<BufferObject> CreateUniformBuffers(uint32_t size, uint32_t imageCount);
+  std::vector<BufferObject> CreateUniformBuffers(VkDeviceSize size, uint32_t imageCount);
+  // zXg珑ރXg[Wobt@ (t[XV).
+  std::vector<BufferObject> CreateStorageBuffers(VkDeviceSize size, uint32_t imageCount);
 
   // zXg猩郁̈Ƀf[^.ȉobt@ΏۂɎgp.
   // - Xe[WOobt@
   // - jtH[obt@
   void WriteToHostVisibleMemory(VkDeviceMemory memory, uint64_t size, const void* pData);
-  void WriteToDeviceLocalMemory(BufferObject dstBuffer, const void* pSrcData, size_t size, VkCommandBuffer command = VK_NULL_HANDLE, BufferObject* stagingBufferUsed = nullptr);
+  // dstBuffer zXg猩 (/Resizable BAR) Ƃ̓}bvĒڏ݁A
+  // łȂ΃Xe[WOobt@Rs[. ڏ񂾏ꍇ stagingBufferUsed ͋ɂȂ.
+  // Xe[WÕ`NTCY𒴂] command Ɋւ炸̏ŕ]AĂ߂.
+  void WriteToDeviceLocalMemory(BufferObject dstBuffer, const void* pSrcData, VkDeviceSize size, VkCommandBuffer command = VK_NULL_HANDLE, BufferObject* stagingBufferUsed = nullptr, VkDeviceSize dstOffset = 0);
+
+  // foCX[JzXgȃ̎.
+  enum DeviceMemoryMode {
+    DeviceMemoryMode_Discrete = 0,  //  BAR  (Xe[WOK{)
+    DeviceMemoryMode_Unified,       //  GPU / \tgEFAX^CU
+    DeviceMemoryMode_ResizableBar,  // fBXN[g GPU  VRAM ŜzXg猩
+  };
+  DeviceMemoryMode GetDeviceMemoryMode() const { return m_deviceMemoryMode; }
+  // _/CfbNXȂ CPU x̃obt@Ɏg.
+  // ڏ݂\Ȃ DEVICE_LOCAL | HOST_VISIBLE | HOST_COHERENTAȊO DEVICE_LOCAL.
+  VkMemoryPropertyFlags GetUploadTargetMemoryProps() const;
+  // ڏ݂g (rpɖł). ȍ~ɍobt@甽f.
+  void SetDirectUploadEnabled(bool enable) { m_directUploadEnabled = enable; }
+  bool IsDirectUploadEnabled() const { return m_directUploadEnabled && m_deviceMemoryMode != DeviceMemoryMode_Discrete; }
+  struct UploadStats {
+    uint64_t directCount = 0;
+    VkDeviceSize directBytes = 0;
+    uint64_t stagingCount = 0;
+    VkDeviceSize stagingBytes = 0;
+    uint64_t imageCount = 0;   // eNX` (œK^COȂ̂ŏɃRs[)
+    VkDeviceSize imageBytes = 0;
+    uint64_t chunkedCount = 0; // Xe[WÔ]
+    uint64_t chunkCount = 0;
+    uint64_t imageSubmitCount = 0; // eNX`]̂߂ vkQueueSubmit 
+  };
+  UploadStats GetUploadStats() const { return m_uploadStats; }
 
   void AllocateCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands);
   void FreeCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands);
 
   void TransferStageBufferToImage(const BufferObject& srcBuffer, const ImageObject& dstImage, const VkBufferImageCopy* region);
+  // ̃~bvxւ̓]. generateMipmaps ̂Ƃ̓x 0 ]Ac vkCmdBlitImage ŏkč.
+  void TransferStageBufferToImage(const BufferObject& srcBuffer, const ImageObject& dstImage, uint32_t regionCount, const VkBufferImageCopy* regions, bool generateMipmaps);
+  // Xe[WO͈͂C[Wւ̓] 1 . regions  bufferOffset  srcBuffer ̈ʒu.
+  struct TextureUpload {
+    VkBuffer srcBuffer = VK_NULL_HANDLE;
+    ImageObject dstImage;
+    std::vector<VkBufferImageCopy> regions;
+    bool generateMipmaps = false;
+    // ]ɂ̃C[WǂރXe[W.
+    VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  };
+  // ̃C[Wւ̓] 1 ̃R}hobt@ɂ܂Ƃ߂ 1 񂾂M.
+  // CAEgJڂ͑SC[W 1  vkCmdPipelineBarrier ōs.
+  void TransferStageBuffersToImages(const std::vector<TextureUpload>& uploads);
+  // Begin/End ̊Ԃ LoadTexture ͓]𗭂߂ĂAEnd (܂͗߂Xu\Z𒴂Ƃ) ɂ܂Ƃ߂đM.
+  // ԂꂽeNX` End ̌Ŏg.
+  void BeginTextureUploadBatch();
+  void EndTextureUploadBatch();
+  // őTCY 1x1 ܂ł̃~bvx.
+  static uint32_t CalcMipLevels(uint32_t width, uint32_t height);
+  // vkCmdBlitImage ł̃~bv (jAtB^t) ɑΉtH[}bg.
+  bool IsMipmapBlitSupported(VkFormat format) const;
+  // ubNktH[}bg̃foCX@\ƃTvOۂmF.
+  bool IsTextureFormatSupported(VkFormat format) const;
 
 
   // _[pX̐.
   VkRenderPass CreateRenderPass(VkFormat colorFormat, VkFormat depthFormat = VK_FORMAT_UNDEFINED, VkImageLayout layoutColor = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
-  void SetFrameDeltaTime(double t) { m_frameDeltaTime = t; }
+  // t[Ă΂. xj҂̃eNX`ŉ.
+  void SetFrameDeltaTime(double t);
   double GetFrameDeltaTime() const { return m_frameDeltaTime; }
   
-  struct Node {
-    std::vector<std::shared_ptr<Node>> children;
-    glm::mat4 transform;
-    glm::mat4 worldTransform = glm::mat4(1.0f);
-    glm::mat4 offsetMatrix;
-    std::string name;
-
-    Node() = default;
-
-    void UpdateMatrices(glm::mat4 mtxParent);
-  };
+  // Aj[Ṽf[^ƃTv[ Animation.h ɂ.
+  using AnimationChannel = animation::AnimationChannel;
+  using AnimationClip = animation::AnimationClip;
   struct Material {
     glm::vec3 diffuse;
     float shininess;
@@ -164,18 +226,70 @@ public:
     glm::mat4 mtxWorld;
     glm::vec4 diffuse; // vec3:diffuse, w: specularShininess
     glm::vec4 ambient; // vec3:ambient, w: none
+    // ʎqꂽʒu̕p (pos = in.xyz * scale + offset).
+    glm::vec4 positionScale = glm::vec4(1.0f);
+    glm::vec4 positionOffset = glm::vec4(0.0f);
+    // x: DrawBatch::boneRemapOffset. VF[_[ł boneMatrices[boneRemap[x + _̃{[ԍ]] ň.
+    // y: SkinningMethod (pbǧ`).
+    glm::uvec4 boneRemap = glm::uvec4(0);
+  };
+  // {[pbǧ`.
+  enum SkinningMethod {
+    SkinningMethod_Linear = 0,      // s̐`uh. 64 oCg/{[
+    SkinningMethod_DualQuaternion,  // fANH[^jI (real, dual). 32 oCg/{[. XP[͖
+    SkinningMethod_Count,
+  };
+  // XLjOςݒ_ 1 ̑傫 (ʒu vec3, @ vec3, UV0 vec2).
+  static const uint32_t SkinnedVertexStride = sizeof(float) * 8;
+  // f̒_ (ModelAsset ̃obt@ɑΉ).
+  enum VertexAttribute {
+    VertexAttribute_Position = 0,
+    VertexAttribute_Normal,
+    VertexAttribute_UV0,
+    VertexAttribute_Tangent,
+    VertexAttribute_BoneIndices,
+    VertexAttribute_BoneWeights,
+    VertexAttribute_Count,
+  };
+  static uint32_t VertexAttributeBit(VertexAttribute attr) { return 1u << attr; }
+  static const uint32_t VertexAttributeMask_All = (1u << VertexAttribute_Count) - 1;
+  // _obt@̔zu.
+  enum VertexLayout {
+    VertexLayout_Separate = 0,  // Ƃɕʃobt@ (SoA)
+    VertexLayout_Interleaved,   // 1 ̃obt@ɑSC^[[u
+    VertexLayout_HotCold,       // 1 ̃obt@ ʒû݂̃Xg[ + ̑C^[[uXg[
+    VertexLayout_Count,
+  };
+  // _obt@̃oChP.
+  struct VertexStream {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    uint32_t stride = 0;
   };
   struct DrawBatch {
-    uint32_t vertexOffsetCount;
+    // _/CfbNX̊Jnʒu 64bit ŎA`R}hɓnƂɔ͈͂m߂ďk߂.
+    uint64_t vertexOffsetCount;
+    uint32_t vertexCount = 0;
     uint32_t indexCount;
-    uint32_t indexOffsetCount;
+    uint64_t indexOffsetCount;
     uint32_t materialIndex;
+    // vkCmdDrawIndexed  firstIndex / vertexOffset. 32bit Ɏ܂ȂΗO𓊂.
+    uint32_t GetFirstIndex() const;
+    int32_t GetVertexOffset() const;
+
+    // CfbNXobt@̊Jnʒu(oCg)ƌ^. RpNg`ł 16bit ݂.
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    VkDeviceSize indexBufferOffset = 0;
+    // ʎqꂽʒu̕p.
+    glm::vec4 positionScale = glm::vec4(1.0f);
+    glm::vec4 positionOffset = glm::vec4(0.0f);
 
     std::vector<VkDescriptorSet> descriptorSets;
 
-    std::vector<aiBone*> boneList;
-    std::vector<std::shared_ptr<Node>> boneList2;
-    std::vector<BufferObject> boneMatrixPalette;
+    // {[ i (_̃{[ԍ)  ModelAsset::skeletonNodes ł̔ԍ.
+    std::vector<uint32_t> boneRemap;
+    // ModelAsset::BoneRemap ̒ł̃ob` boneRemap n܂ʒu.
+    uint32_t boneRemapOffset = 0;
     std::vector<BufferObject> modelMeshParameterUBO;
   };
   struct ModelAsset {
@@ -185,25 +299,180 @@ public:
     BufferObject Indices;
 
     std::vector<DrawBatch> DrawBatches;
-    Assimp::Importer* importer;
-    const aiScene* scene;
-    uint32_t totalVertexCount;
-    uint32_t totalIndexCount;
+    uint64_t totalVertexCount;
+    uint64_t totalIndexCount;
 
     glm::mat4 invGlobalTransform;
-    std::shared_ptr<Node> rootNode;
+    // m[hKw. lƂĎ̂ŃCX^XƂ̓̕Rs[ōς.
+    NodeHierarchy nodes;
+    // ꂩ̃bVQƂ{[̃m[hԍƃItZbgs. DrawBatch::boneRemap ̎QƐ.
+    // {[̓bVԂ 1 ɂ܂Ƃ߂ (ItZbgs񂪈ႤƂʂ̗vfɂȂ).
+    std::vector<uint32_t> skeletonNodes;
+    std::vector<glm::mat4> skeletonOffsets;
+    // S DrawBatch  boneRemap A (uint32). WIgƈꏏɋL.
+    BufferObject BoneRemap;
+    // XPgŜ̃{[spbg (Xg[Wobt@). CX^XƁAXbv`FCC[W.
+    std::vector<BufferObject> boneMatrixPalette;
+    // XLjOς݂̒_ (SkinnedVertexStride ŃC^[[u). т͂̃f̒_ŁAv[ł͂Ȃ.
+    // 1 t[ 1 񏑂݁AfvXvpX GBuffer ȂǕ̃pX畁ʂ̒_obt@Ƃēǂ.
+    BufferObject SkinnedVertices;
     std::vector<Material> materials;
-    std::shared_ptr<Node> FindNode(const std::string& name);
+    std::vector<AnimationClip> animations;
+    std::vector<animation::CompressedClip> compressedAnimations;
+    // Ȃ NodeHierarchy::InvalidIndex.
+    uint32_t FindNode(const std::string& name) const { return nodes.FindNode(name); }
 
     std::unordered_map<std::string, BufferObject> extraBuffers;
+    // LWIg̃L[ (m_modelDatabase).
+    std::string geometryKey;
+    // WIgv[ɔzuꂽꍇ̃v[ԍƊmۈʒu (_/oCg). DrawBatch ͈̔͂̓v[.
+    int geometryPoolIndex = -1;
+    uint64_t poolVertexBase = 0;
+    uint64_t poolIndexBase = 0;
     
     void Release(VulkanAppBase* base);
     std::string name;
     VkPipelineLayout pipelineLayout;
+
+    // bVœKO̒_LbV.
+    mesh_optimizer::VertexCacheStatistics cacheStatsBefore;
+    mesh_optimizer::VertexCacheStatistics cacheStatsAfter;
+
+    // _Ƃ̃tH[}bgƃTCY.
+    std::array<VkFormat, VertexAttribute_Count> vertexFormats{
+      VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+      VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_UINT, VK_FORMAT_R32G32B32A32_SFLOAT,
+    };
+    std::array<uint32_t, VertexAttribute_Count> attributeSizes{
+      sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec2),
+      sizeof(glm::vec3), sizeof(glm::uvec4), sizeof(glm::vec4),
+    };
+    // \zꂽ_ (VertexAttributeBit ̑gݍ킹).
+    uint32_t attributeMask = 0;
+    // @/ڐʑ̃GR[hĂ邩 (VF[_[œWJKv).
+    bool compactVertexFormat = false;
+
+    // _obt@̔zu. Separate ȊOł VertexData 1 ɂ܂Ƃ߂Ċmۂ.
+    VertexLayout vertexLayout = VertexLayout_Separate;
+    BufferObject VertexData;
+    std::vector<VertexStream> vertexStreams;
+    std::array<uint32_t, VertexAttribute_Count> attributeStreams{};  // i[ĂXg[ԍ
+    std::array<uint32_t, VertexAttribute_Count> attributeOffsets{};  // Xg[ 1 _ł̃ItZbg
+
+    // attributes ̕я location  0 犄蓖Ă_͒`.
+    // binding ͑܂ރXg[̏o.
+    void GetVertexInputDescription(
+      const std::vector<VertexAttribute>& attributes,
+      std::vector<VkVertexInputBindingDescription>& bindings,
+      std::vector<VkVertexInputAttributeDescription>& attribs) const;
+    // GetVertexInputDescription ƓŒ_obt@oCh.
+    void BindVertexBuffers(VkCommandBuffer command, const std::vector<VertexAttribute>& attributes) const;
+    // SkinnedVertices  binding 0 Ƃēǂޒ_͒`. location 0/1/2 = ʒu/@/UV0 ŁA
+    // GetVertexInputDescription({ Position, Normal, UV0 }) Ɠ蓖ĂȂ̂œ_VF[_[g.
+    static void GetSkinnedVertexInputDescription(
+      std::vector<VkVertexInputBindingDescription>& bindings,
+      std::vector<VkVertexInputAttributeDescription>& attribs);
+    void BindSkinnedVertexBuffer(VkCommandBuffer command) const;
+    // SkinnedVertices ł DrawBatch ̐擪_ (vkCmdDrawIndexed  vertexOffset).
+    int32_t GetSkinnedVertexOffset(const DrawBatch& batch) const;
+  };
+  struct ModelLoadOptions {
+    bool useFlipUV = false;
+    // DrawBatch PʂŒ_d/_LbV/_tFb`̍œKs.
+    bool optimizeMesh = true;
+    // I[o[h[팸̕ёւs.
+    bool optimizeOverdraw = false;
+    // œKʂ "<ft@C>.<IvV>.meshcache" ɕۑĎȍ~ėp.
+    // fʂ̐ݒœǂރTvmŃLbV㏑Ȃ悤AIvVƂɕʃt@Cɂ.
+    bool useMeshCache = true;
+    // RpNgȒ_tH[}bgg.
+    //  CfbNX: DrawBatch ̒_܂ 16bit
+    //  @/ڐ: ʑ̃GR[h (R16G16_SNORM)
+    //  UV: UNORM16 ܂ half
+    //  {[: CfbNX uint8 / EFCg unorm8
+    bool compactVertexFormat = false;
+    // compactVertexFormat Ɉʒu DrawBatch  AABB  16bit ʎq.
+    bool quantizePositions = false;
+    // _obt@̔zu.
+    VertexLayout vertexLayout = VertexLayout_Separate;
+    // \z/]钸_ (VertexAttributeBit ̑gݍ킹). ʒu͏Ɋ܂܂.
+    // {[̓f{[Ƃ\z.
+    uint32_t attributeMask = VertexAttributeMask_All;
+    // VertexLayout_Separate ̂ƂA_/CfbNXWIgv[ɔzu.
+    // tH[}bg̃f͓obt@L̂ŁAoChɕ`ł.
+    bool useGeometryPool = true;
+    // Aj[Vk ModelAsset::compressedAnimations ɕێ (animations ͋ɂȂ).
+    // useMeshCache LȂ爳kʂ "<ft@C>.animcache" ɕۑĎȍ~ėp.
+    bool compressAnimations = false;
+    animation::CompressionSettings animationCompression;
+  };
+  // _tH[}bg/\̃fl߂Ĕzu郁Kobt@.
+  struct GeometryPool {
+    uint32_t attributeMask = 0;
+    std::array<VkFormat, VertexAttribute_Count> vertexFormats{};
+    std::array<uint32_t, VertexAttribute_Count> attributeSizes{};
+    std::array<BufferObject, VertexAttribute_Count> vertexBuffers{};
+    BufferObject indexBuffer;
+    GeometryRangeAllocator vertexAllocator;  // _P
+    GeometryRangeAllocator indexAllocator;   // oCgP
   };
 
+  // t@C/IvVœǂݍ񂾃f͒_/CfbNXobt@A}eAAAj[VL.
+  // m[hAbVp[^ UBOA{[pbgAfBXNv^Zbg̓CX^XƂɍ.
+  // eCX^X ModelAsset::Release ŉAŌ̎QƂOꂽ_ŃWIgj.
   ModelAsset LoadModelData(std::filesystem::path fileName, bool useFlipUV = false);
-  ImageObject LoadTexture(std::filesystem::path fileName);
+  ModelAsset LoadModelData(std::filesystem::path fileName, const ModelLoadOptions& options);
+  // ModelAsset::boneMatrixPalette[imageIndex] ɃXPg̃{[s.
+  // s̍̓{[ 1 {ɂ 1 ŁADrawBatch ԂŋL{[dČvZȂ.
+  // ߂l͏񂾃oCg.
+  VkDeviceSize UpdateBonePalette(ModelAsset& model, uint32_t imageIndex, SkinningMethod method = SkinningMethod_Linear);
+  // Cӂ̃zXgփpbg. 傫̓{[ x (64 ܂ 32) oCgKv.
+  VkDeviceSize WriteBonePalette(const ModelAsset& model, VkDeviceMemory memory, SkinningMethod method);
+  // m[h̃[hs̔z񂩂pbg dst ֏. }bvς݂̗̈֕Xbh珑ƂɎg.
+  static VkDeviceSize ComposeBonePalette(const ModelAsset& model, const glm::mat4* worldMatrices, SkinningMethod method, void* dst);
+  static VkDeviceSize GetBonePaletteStride(SkinningMethod method);
+  // XPg̃[hs̃nbV. OƓȂXLjOʂg񂹂.
+  static uint64_t HashSkeletonPose(const ModelAsset& model);
+  // ModelAsset::SkinnedVertices . Rs[gVF[_[珑A_obt@Ƃēǂ.
+  void CreateSkinnedVertexBuffer(ModelAsset& model);
+  // eNX`̓pX̃nbVL[ɃLbVAQƃJEgŊǗ.
+  // gI ReleaseTexture Ă. QƂ̖ȂeNX`͗\Z𒴂܂ŃLbVɎcA
+  // ͍ŌɎgꂽÂ̂xj.
+  // PNG/JPG/TGA ͓ .ktx2 (TextureCook ̏o) ΂ǂݍ.
+  // dstStageMask ͂̃eNX`ǂރVF[_[Xe[W. ]̃CAEgJڂ͂̃Xe[W҂.
+  ImageObject LoadTexture(std::filesystem::path fileName, VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+  void ReleaseTexture(const ImageObject& texture);
+  struct TextureCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    VkDeviceSize residentBytes = 0;
+    VkDeviceSize budgetBytes = 0;
+    uint32_t textureCount = 0;
+    uint32_t unreferencedCount = 0;
+    uint32_t pendingDestroyCount = 0;
+  };
+  TextureCacheStats GetTextureCacheStats() const;
+  void SetTextureMemoryBudget(VkDeviceSize bytes);
+
+  // eNX`]p̃Xe[WOXu.
+  // i}bvzXgobt@ŁAfR[_[͂֒ڏ. ]͎̓ǂݍ݂ōėp.
+  struct StagingStats {
+    uint32_t slabCount = 0;
+    VkDeviceSize slabBytes = 0;
+    uint64_t slabCreates = 0;
+    uint64_t slabReuses = 0;
+    uint64_t decodeInPlace = 0;   // fR[hʂ̂܂܃Xuɂ
+    uint64_t decodeFallback = 0;  // A[iɎ܂炸q[vRs[
+    VkDeviceSize bytesStaged = 0;
+  };
+  StagingStats GetStagingStats() const { return m_stagingStats; }
+
+  // WIgv[̎gp̈擪֋lߒ. GPU ̊҂Ăs.
+  // LWIg͈͍̔͂XV̂ŁAĂCX^X RefreshModelInstance Ŕf.
+  void CompactGeometryPools();
+  void RefreshModelInstance(ModelAsset& model);
+  const std::vector<GeometryPool>& GetGeometryPools() const { return m_geometryPools; }
 
 
  private:
@@ -211,6 +480,10 @@ public:
   void SelectGraphicsQueue();
   void CreateDevice();
   void CreateCommandPool();
+  void DetectDeviceMemoryMode();
+  void WriteToDeviceLocalMemoryChunked(BufferObject dstBuffer, const uint8_t* pSrcData, VkDeviceSize size, VkDeviceSize dstOffset);
+  // [offset, offset + size)  nonCoherentAtomSize ɍL͈͂tbV. memorySize ̓obt@̑傫.
+  void FlushMappedRange(VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize memorySize);
 
   // fobO|[gL.
   void EnableDebugReport();
@@ -225,6 +498,31 @@ public:
   // ImGui
   void PrepareImGui();
   void CleanupImGui();
+
+  // f̋LWIg.
+  ModelAsset LoadModelGeometry(std::filesystem::path fileName, const ModelLoadOptions& options);
+  ModelAsset CreateModelInstance(const ModelAsset& geometry);
+  void ReleaseModelGeometry(const std::string& key);
+  bool AllocateFromGeometryPool(ModelAsset& model, const std::vector<VertexAttribute>& attributes, uint64_t vertexCount, VkDeviceSize indexDataSize);
+  void ReportGeometryPool(const char* reason, int poolIndex);
+
+  // eNX`LbV.
+  static uint64_t HashTexturePath(const std::filesystem::path& fileName);
+  void EvictTextures();
+  void DestroyPendingTextures(bool force);
+
+  // Xe[WOXu. 1 ̃Xuɕ̃eNX`l߁Ap҂ȂȂ擪g.
+  struct StagingAllocation {
+    int slab = -1;            // m_stagingSlabs ̃CfbNX.
+    VkDeviceSize offset = 0;  // Xu擪̈ʒu.
+    VkDeviceSize size = 0;
+  };
+  StagingAllocation AcquireStagingSlab(VkDeviceSize size);
+  void ShrinkStagingAllocation(StagingAllocation& alloc, VkDeviceSize size);
+  void ReleaseStagingSlab(const StagingAllocation& alloc);
+  void FlushStagingSlab(const StagingAllocation& alloc);
+  void DestroyStagingSlabs();
+  void FlushTextureUploadBatch();
 protected:
   VkDeviceMemory AllocateMemory(VkBuffer image, VkMemoryPropertyFlags memProps);
   VkDeviceMemory AllocateMemory(VkImage image, VkMemoryPropertyFlags memProps);
@@ -256,6 +554,58 @@ protected:
   std::unique_ptr<PipelineLayoutManager> m_pipelineLayoutStore;
   std::unique_ptr<DescriptorSetLayoutManager> m_descriptorSetLayoutStore;
 
-  std::unordered_map<std::string, ImageObject> m_textureDatabase;
+  struct TextureCacheEntry {
+    ImageObject image;
+    std::string path;
+    uint32_t refCount = 0;
+    uint64_t lastUsedFrame = 0;
+    VkDeviceSize memorySize = 0;
+  };
+  std::unordered_map<uint64_t, TextureCacheEntry> m_textureDatabase;
+  // ReleaseTexture  m_textureDatabase ߂ VkImage -> L[.
+  std::unordered_map<VkImage, uint64_t> m_textureKeys;
+  struct PendingTextureDestroy {
+    ImageObject image;
+    uint64_t frame;
+  };
+  std::vector<PendingTextureDestroy> m_pendingTextureDestroy;
+  TextureCacheStats m_textureCacheStats;
+  VkDeviceSize m_textureMemoryBudget = 512ull << 20;
+  uint64_t m_frameNumber = 0;
+  struct StagingSlab {
+    BufferObject buffer;
+    uint8_t* mapped = nullptr;
+    bool coherent = true;
+    VkDeviceSize used = 0;  // 擪l߂.
+    uint32_t users = 0;     // ]҂̊蓖Đ.
+  };
+  std::vector<StagingSlab> m_stagingSlabs;
+  // Xu 1 ̍ŏTCY. 傫ȗv͐pTCYōAgIj.
+  VkDeviceSize m_stagingSlabSize = 64ull << 20;
+  // Xů蓖ċE. vkCmdCopyBufferToImage  bufferOffset  (4 ƃubNTCY) 𖞂.
+  VkDeviceSize m_stagingAlignment = 256;
+  StagingStats m_stagingStats;
+  DeviceMemoryMode m_deviceMemoryMode = DeviceMemoryMode_Discrete;
+  bool m_directUploadEnabled = true;
+  VkDeviceSize m_maxMemoryAllocationSize = ~VkDeviceSize(0);
+  VkDeviceSize m_nonCoherentAtomSize = 1;
+  // 𒴂]̓Xe[WO 2 g񂵂ĕ.
+  VkDeviceSize m_stagingChunkSize = 256ull << 20;
+  UploadStats m_uploadStats;
+  // ܂Ƃ߂ē]eNX`. Xu͑MI܂Ŏgp̂܂܂ɂ.
+  int m_textureUploadBatchDepth = 0;
+  std::vector<TextureUpload> m_pendingTextureUploads;
+  std::vector<StagingAllocation> m_pendingTextureUploadSlabs;
+  VkDeviceSize m_pendingTextureUploadBytes = 0;
+  VkDeviceSize m_textureUploadBatchBudget = 256ull << 20;
+  struct ModelDatabaseEntry {
+    ModelAsset geometry;
+    uint32_t refCount = 0;
+  };
+  std::unordered_map<std::string, ModelDatabaseEntry> m_modelDatabase;
+  std::vector<GeometryPool> m_geometryPools;
+  // v[ 1 ̗e. ŏ̃fǂݍݑOɕύX.
+  uint64_t m_geometryPoolVertexCapacity = 1ull << 20;
+  VkDeviceSize m_geometryPoolIndexCapacity = 64ull << 20;
   double m_frameDeltaTime = 0.0;
 };
\ No newline at end of file
@@ -40,6 +40,34 @@ namespace book_util
     }
     handle = VK_NULL_HANDLE;
   }
+
+  // vf x XgCh̃obt@TCY. 64bit ŕ\ȂƂ͗O𓊂.
+  inline VkDeviceSize CheckedBufferSize(VkDeviceSize count, VkDeviceSize stride)
+  {
+    if (stride != 0 && count > ~VkDeviceSize(0) / stride)
+    {
+      throw VulkanException("buffer size overflow.");
+    }
+    return count * stride;
+  }
+
+  // 64bit Ő_/CfbNXʒu`R}hvbV萔 32bit l֏k߂. ܂ȂƂ͗O𓊂.
+  inline uint32_t CheckedUint32(uint64_t value)
+  {
+    if (value > 0xFFFFFFFFull)
+    {
+      throw VulkanException("value does not fit in 32 bits.");
+    }
+    return uint32_t(value);
+  }
+  inline int32_t CheckedInt32(int64_t value)
+  {
+    if (value < -0x80000000ll || value > 0x7FFFFFFFll)
+    {
+      throw VulkanException("value does not fit in 32 bits.");
+    }
+    return int32_t(value);
+  }
   
   inline VkAttachmentDescription GetAttachmentDescription(VkFormat format, VkImageLayout before, VkImageLayout after, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT)
   {